@@ -46,6 +46,7 @@ struct sipe_appshare;
 struct sipe_backend_chat_session;
 struct sipe_chat_session;
 struct sipe_core_public;
+struct sipe_dns_lookup;
 struct sipe_transport_connection;
 struct sipe_file_transfer;
 struct sipe_media_call;
@@ -115,12 +116,39 @@ void sipe_backend_debug(sipe_debug_level level,
  */
 gboolean sipe_backend_debug_enabled(void);
 
+/** CACHE ********************************************************************/
+
+/**
+ * Directory where the core can store data that should survive a restart,
+ * e.g. DNS lookup results. The directory must be private to the account
+ * and must already exist.
+ *
+ * @param sipe_public The handle representing the protocol instance
+ *
+ * @return directory path or @c NULL if the backend doesn't support it.
+ *         Owned by the backend.
+ */
+const gchar *sipe_backend_cache_dir(struct sipe_core_public *sipe_public);
+
 /** CHAT *********************************************************************/
 
 void sipe_backend_chat_session_destroy(struct sipe_backend_chat_session *session);
 void sipe_backend_chat_add(struct sipe_backend_chat_session *backend_session,
 			   const gchar *uri,
 			   gboolean is_new);
+
+/**
+ * Add/remove several users in one go, e.g. for large conference rosters
+ *
+ * @param backend_session backend chat session
+ * @param uris            list of user URIs (gchar *)
+ * @param is_new          see sipe_backend_chat_add()
+ */
+void sipe_backend_chat_add_users(struct sipe_backend_chat_session *backend_session,
+				 const GSList *uris,
+				 gboolean is_new);
+void sipe_backend_chat_remove_users(struct sipe_backend_chat_session *backend_session,
+				    const GSList *uris);
 void sipe_backend_chat_close(struct sipe_backend_chat_session *backend_session);
 
 /**
@@ -430,7 +458,7 @@ struct sipe_media_relay {
 	gchar		      *hostname;
 	guint		       udp_port;
 	guint		       tcp_port;
-	struct sipe_dns_query *dns_query;
+	struct sipe_dns_lookup *dns_query;
 };
 
 /* Media handling */
@@ -605,6 +633,18 @@ gpointer sipe_backend_schedule_mseconds(struct sipe_core_public *sipe_public,
 void sipe_backend_schedule_cancel(struct sipe_core_public *sipe_public,
 				  gpointer data);
 
+/**
+ * Call sipe_core_wakeup() once from the main thread.
+ *
+ * Can be called from any thread. The call must not happen before this
+ * function has returned, even when it is called from the main thread.
+ * The account might have been deallocated in the meantime, therefore
+ * there is no core public data.
+ *
+ * @param data callback data for sipe_core_wakeup()
+ */
+void sipe_backend_wakeup(gpointer data);
+
 /** SEARCH *******************************************************************/
 
 struct sipe_backend_search_results;
@@ -635,6 +675,7 @@ typedef enum {
   SIPE_SETTING_EMAIL_PASSWORD,
   SIPE_SETTING_GROUPCHAT_USER,
   SIPE_SETTING_USER_AGENT,
+  SIPE_SETTING_FT_BLOCK_SIZE,
   SIPE_SETTING_LAST
 } sipe_setting;
 const gchar *sipe_backend_setting(struct sipe_core_public *sipe_public,
@@ -680,8 +721,15 @@ struct sipe_transport_connection *sipe_backend_transport_connect(struct sipe_cor
 								 const sipe_connect_setup *setup);
 void sipe_backend_transport_disconnect(struct sipe_transport_connection *conn);
 gchar *sipe_backend_transport_ip_address(struct sipe_transport_connection *conn);
+/* one part of an outgoing message, not necessarily zero terminated */
+struct sipe_transport_part {
+	const gchar *data;
+	gsize length;
+};
+/* all parts are sent as one message, in order */
 void sipe_backend_transport_message(struct sipe_transport_connection *conn,
-				    const gchar *buffer);
+				    const struct sipe_transport_part *parts,
+				    guint count);
 void sipe_backend_transport_flush(struct sipe_transport_connection *conn);
 
 /** USER *********************************************************************/
@@ -57,12 +57,15 @@ extern "C" {
  * The processing function in the core can remove content from the buffer.
  * It has to update buffer_used accordingly.
  *
+ * The backend must use sipe_core_transport_buffer_reserve() to manage the
+ * buffer size before reading into it.
  */
 struct sipe_transport_connection {
 	gpointer user_data;
 	gchar *buffer;
 	gsize buffer_used;        /* 0 < buffer_used < buffer_length */
 	gsize buffer_length;      /* read-only */
+	gsize buffer_hint;        /* read-only: size of incomplete message */
 	guint type;               /* read-only */
 	guint client_port;        /* read-only */
 };
@@ -185,6 +188,9 @@ gchar *sipe_core_about(void);
 /* Execute a scheduled action */
 void sipe_core_schedule_execute(gpointer data);
 
+/* Main thread part of sipe_backend_wakeup() */
+void sipe_core_wakeup(gpointer data);
+
 /* menu actions */
 void sipe_core_update_calendar(struct sipe_core_public *sipe_public);
 void sipe_core_reset_status(struct sipe_core_public *sipe_public);
@@ -337,6 +343,20 @@ void sipe_core_transport_sip_connect(struct sipe_core_public *sipe_public,
  */
 const gchar *sipe_core_transport_sip_server_name(struct sipe_core_public *sipe_public);
 
+/**
+ * Prepare transport receive buffer for the next read
+ *
+ * Grows the buffer geometrically or directly to the size of the message
+ * that is currently being received. Shrinks the buffer again when a large
+ * message has been processed.
+ *
+ * @param conn transport connection
+ *
+ * @return number of bytes that can be read to @c buffer + @c buffer_used.
+ *         Space for the string terminator is already excluded.
+ */
+gsize sipe_core_transport_buffer_reserve(struct sipe_transport_connection *conn);
+
 /**
  * Get chat ID, f.ex. group chat URI
  */
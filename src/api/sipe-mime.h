@@ -35,7 +35,8 @@ void sipe_mime_shutdown(void);
  *
  * @param user_data callback data.
  * @param fields    list of @c sipnameval structures with the header fields
- * @param body      text of the MIME part.
+ * @param body      text of the MIME part. Might point into the MIME document
+ *                  and is not NUL terminated, use @c length.
  * @param length    length of the body text.
  */
 typedef void (*sipe_mime_parts_cb)(gpointer user_data,
@@ -46,6 +47,8 @@ typedef void (*sipe_mime_parts_cb)(gpointer user_data,
 /**
  * Parse MIME document and call a function for each part.
  *
+ * The callback must not modify or free the MIME document.
+ *
  * @param type      content type of the MIME document.
  * @param body      body of the MIME document.
  * @param callback  function to call for each MIME part.
@@ -56,6 +59,27 @@ void sipe_mime_parts_foreach(const gchar *type,
 			     sipe_mime_parts_cb callback,
 			     gpointer user_data);
 
+/**
+ * Parse simple multipart document without calling the MIME backend.
+ *
+ * Only handles documents whose parts need no decoding, i.e. no nested
+ * multiparts and no transfer encoding other than 7bit, 8bit or binary.
+ * Used by sipe_mime_parts_foreach() implementations before falling back
+ * to the MIME backend parser.
+ *
+ * @param type      content type of the MIME document.
+ * @param body      body of the MIME document.
+ * @param callback  function to call for each MIME part.
+ * @param user_data callback data.
+ *
+ * @return @c TRUE if document was handled, otherwise @c FALSE and
+ *         @c callback has not been called.
+ */
+gboolean sipe_mime_parts_foreach_simple(const gchar *type,
+					const gchar *body,
+					sipe_mime_parts_cb callback,
+					gpointer user_data);
+
 /**
  * Checks whether MIME document contains a part with given type.
  *
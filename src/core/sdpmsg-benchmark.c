@@ -0,0 +1,247 @@
+/**
+ * @file sdpmsg-benchmark.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Timing harness for sdpmsg.c
+ *
+ * Parses and serializes a Lync 2013 conference offer with audio, video
+ * and application sharing streams, each with host, TCP, server reflexive
+ * and relay candidates.
+ *
+ *    $ sdpmsg_benchmark [<iterations, default 100000>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <glib.h>
+
+#include "sip-transport.h"
+#include "sipe-common.h"
+#include "sipe-backend.h"
+#include "sdpmsg.h"
+#include "sipe-utils.h"
+#include "uuid.h"
+
+/* stub functions for backend API */
+void sipe_backend_debug_literal(SIPE_UNUSED_PARAMETER sipe_debug_level level,
+				SIPE_UNUSED_PARAMETER const gchar *msg)
+{
+}
+void sipe_backend_debug(SIPE_UNUSED_PARAMETER sipe_debug_level level,
+			SIPE_UNUSED_PARAMETER const gchar *format,
+			...)
+{
+}
+gboolean sipe_backend_debug_enabled(void)
+{
+	return FALSE;
+}
+
+const gchar *sip_transport_epid(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+const gchar *sip_transport_ip_address(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+char *generateUUIDfromEPID(SIPE_UNUSED_PARAMETER const gchar *epid) { return(NULL); }
+char *sipe_get_epid(SIPE_UNUSED_PARAMETER const char *self_sip_uri,
+		    SIPE_UNUSED_PARAMETER const char *hostname,
+		    SIPE_UNUSED_PARAMETER const char *ip_address) { return(NULL); }
+
+#define LYNC_CANDIDATES(port1, port2) \
+	"a=candidate:1 1 UDP 2130706431 10.1.2.3 " port1 " typ host \r\n" \
+	"a=candidate:1 2 UDP 2130705918 10.1.2.3 " port2 " typ host \r\n" \
+	"a=candidate:2 1 TCP-PASS 174455807 10.1.2.3 " port1 " typ host \r\n" \
+	"a=candidate:2 2 TCP-PASS 174455294 10.1.2.3 " port2 " typ host \r\n" \
+	"a=candidate:3 1 TCP-ACT 174846975 10.1.2.3 " port1 " typ host \r\n" \
+	"a=candidate:3 2 TCP-ACT 174846462 10.1.2.3 " port2 " typ host \r\n" \
+	"a=candidate:4 1 UDP 1694234111 198.51.100.20 31420 typ srflx raddr 10.1.2.3 rport " port1 "\r\n" \
+	"a=candidate:4 2 UDP 1694233598 198.51.100.20 31421 typ srflx raddr 10.1.2.3 rport " port2 "\r\n" \
+	"a=candidate:5 1 UDP 16648703 203.0.113.40 54980 typ relay raddr 198.51.100.20 rport 31420\r\n" \
+	"a=candidate:5 2 UDP 16648702 203.0.113.40 55210 typ relay raddr 198.51.100.20 rport 31421\r\n" \
+	"a=candidate:6 1 TCP-PASS 6556159 203.0.113.40 58032 typ relay raddr 198.51.100.20 rport 31422\r\n" \
+	"a=candidate:6 2 TCP-PASS 6556158 203.0.113.40 58032 typ relay raddr 198.51.100.20 rport 31422\r\n" \
+	"a=candidate:7 1 TCP-ACT 7076863 203.0.113.40 58032 typ relay raddr 198.51.100.20 rport 31422\r\n" \
+	"a=candidate:7 2 TCP-ACT 7076350 203.0.113.40 58032 typ relay raddr 198.51.100.20 rport 31422\r\n"
+
+#define LYNC_CRYPTO \
+	"a=crypto:2 AES_CM_128_HMAC_SHA1_80 inline:bGJ5d3FqM2RmcmZ0Z2h5dWppa29scGFzZHF3ZXJ0|2^31|1:1\r\n" \
+	"a=crypto:3 AES_CM_128_HMAC_SHA1_80 inline:dHlkZmdoamtsb2l1eXRyZXdxYXNkZmdoamtsbW5i|2^31\r\n"
+
+static const gchar lync_offer[] =
+	"v=0\r\n"
+	"o=- 0 1 IN IP4 10.1.2.3\r\n"
+	"s=session\r\n"
+	"c=IN IP4 10.1.2.3\r\n"
+	"b=CT:99980\r\n"
+	"t=0 0\r\n"
+	"a=x-devicecaps:audio:send,recv;video:send,recv\r\n"
+	"m=audio 50012 RTP/SAVP 117 104 114 9 112 111 0 103 8 116 115 97 13 118 101\r\n"
+	"a=x-ssrc-range:2183447296-2183447296\r\n"
+	"a=rtcp-fb:* x-message app send:dsh recv:dsh\r\n"
+	"a=rtcp-rsize\r\n"
+	"a=label:main-audio\r\n"
+	"a=x-source:main-audio\r\n"
+	"a=ice-ufrag:HQJa\r\n"
+	"a=ice-pwd:cKxUz1ZvMCTJYX4bbL4UZwqV\r\n"
+	LYNC_CANDIDATES("50012", "50013")
+	LYNC_CRYPTO
+	"a=maxptime:200\r\n"
+	"a=rtcp:50013\r\n"
+	"a=rtpmap:117 G722/8000/2\r\n"
+	"a=rtpmap:104 SILK/16000\r\n"
+	"a=fmtp:104 useinbandfec=1; usedtx=0\r\n"
+	"a=rtpmap:114 x-msrta/16000\r\n"
+	"a=fmtp:114 bitrate=29000\r\n"
+	"a=rtpmap:9 G722/8000\r\n"
+	"a=rtpmap:112 G7221/16000\r\n"
+	"a=fmtp:112 bitrate=24000\r\n"
+	"a=rtpmap:111 SIREN/16000\r\n"
+	"a=fmtp:111 bitrate=16000\r\n"
+	"a=rtpmap:0 PCMU/8000\r\n"
+	"a=rtpmap:103 SILK/8000\r\n"
+	"a=fmtp:103 useinbandfec=1; usedtx=0\r\n"
+	"a=rtpmap:8 PCMA/8000\r\n"
+	"a=rtpmap:116 AAL2-G726-32/8000\r\n"
+	"a=rtpmap:115 x-msrta/8000\r\n"
+	"a=fmtp:115 bitrate=11800\r\n"
+	"a=rtpmap:97 RED/8000\r\n"
+	"a=rtpmap:13 CN/8000\r\n"
+	"a=rtpmap:118 CN/16000\r\n"
+	"a=rtpmap:101 telephone-event/8000\r\n"
+	"a=fmtp:101 0-16\r\n"
+	"a=ptime:20\r\n"
+	"m=video 50018 RTP/SAVP 122 121 123\r\n"
+	"a=x-ssrc-range:2183447297-2183447396\r\n"
+	"a=rtcp-fb:* x-message app send:src,x-pli recv:src,x-pli\r\n"
+	"a=rtcp-rsize\r\n"
+	"a=label:main-video\r\n"
+	"a=x-source:main-video\r\n"
+	"a=ice-ufrag:Tz5m\r\n"
+	"a=ice-pwd:7ZTvYD7BXQzQ2uq3H2sHhR8g\r\n"
+	LYNC_CANDIDATES("50018", "50019")
+	LYNC_CRYPTO
+	"a=rtcp:50019\r\n"
+	"a=rtpmap:122 X-H264UC/90000\r\n"
+	"a=fmtp:122 packetization-mode=1;mst-mode=NI-TC\r\n"
+	"a=rtpmap:121 x-rtvc1/90000\r\n"
+	"a=rtpmap:123 x-ulpfecuc/90000\r\n"
+	"a=x-caps:121 263:1920:1080:30.0:2000000:1;4359:1280:720:30.0:1500000:1;8455:640:480:30.0:600000:1\r\n"
+	"m=applicationsharing 50030 TCP/RTP/AVP 127\r\n"
+	"a=ice-ufrag:b7Wq\r\n"
+	"a=ice-pwd:zVXyLk3Z1Kd5r2qvA8BQ0Rmn\r\n"
+	LYNC_CANDIDATES("50030", "50031")
+	"a=setup:active\r\n"
+	"a=connection:new\r\n"
+	"a=rtpmap:127 x-data/90000\r\n"
+	"a=x-applicationsharing-session-id:1\r\n"
+	"a=x-applicationsharing-role:viewer\r\n"
+	"a=x-applicationsharing-media-type:rdp\r\n";
+
+/* like sdpmsg-tests.c: sipe-media.c generates these from parsed fields */
+static const gchar * const generated_attributes[] = {
+	"candidate", "remote-candidates", "remote-candidate",
+	"rtpmap", "fmtp", "crypto", "ice-ufrag", "ice-pwd",
+	NULL
+};
+
+static void prepare_for_serialization(struct sdpmsg *msg)
+{
+	GSList *entry;
+
+	for (entry = msg->media; entry; entry = entry->next) {
+		struct sdpmedia *media = entry->data;
+		GSList *attrs = media->attributes;
+		GSList *kept = NULL;
+
+		for (; attrs; attrs = attrs->next) {
+			struct sipnameval *attr = attrs->data;
+			const gchar * const *name;
+
+			for (name = generated_attributes; *name; name++)
+				if (sipe_strcase_equal(attr->name, *name))
+					break;
+
+			if (!*name)
+				kept = sipe_utils_nameval_add(kept,
+							      attr->name,
+							      attr->value);
+		}
+		sipe_utils_nameval_free(media->attributes);
+		media->attributes = kept;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	guint iterations = (argc > 1) ? (guint) atoi(argv[1]) : 100000;
+	gsize length = strlen(lync_offer);
+	gchar *copy = g_malloc(length + 1);
+	GTimer *timer = g_timer_new();
+	gdouble parse_time = 0.0;
+	gdouble serialize_time = 0.0;
+	gsize serialized = 0;
+	guint i;
+
+	for (i = 0; i < iterations; i++) {
+		struct sdpmsg *msg;
+		gchar *sdp;
+
+		/* parser may modify the message */
+		memcpy(copy, lync_offer, length + 1);
+
+		g_timer_start(timer);
+		msg = sdpmsg_parse_msg(copy);
+		parse_time += g_timer_elapsed(timer, NULL);
+		if (!msg) {
+			printf("parsing failed\n");
+			return(1);
+		}
+
+		prepare_for_serialization(msg);
+		g_timer_start(timer);
+		sdp = sdpmsg_to_string(msg);
+		serialize_time += g_timer_elapsed(timer, NULL);
+
+		serialized += strlen(sdp);
+		g_free(sdp);
+		sdpmsg_free(msg);
+	}
+
+	printf("%u iterations, %" G_GSIZE_FORMAT " bytes offer, %" G_GSIZE_FORMAT " bytes serialized\n",
+	       iterations, length, iterations ? serialized / iterations : 0);
+	printf("parse:     %.3f seconds (%.2f us per offer)\n",
+	       parse_time, iterations ? parse_time * 1000000 / iterations : 0.0);
+	printf("serialize: %.3f seconds (%.2f us per offer)\n",
+	       serialize_time, iterations ? serialize_time * 1000000 / iterations : 0.0);
+
+	g_timer_destroy(timer);
+	g_free(copy);
+	return(0);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
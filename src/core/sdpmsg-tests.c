@@ -0,0 +1,390 @@
+/**
+ * @file sdpmsg-tests.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Tests for sdpmsg.c */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <glib.h>
+
+#include "sip-transport.h"
+#include "sipe-common.h"
+#include "sipe-backend.h"
+#include "sipe-core.h"
+#include "sdpmsg.h"
+#include "sipe-utils.h"
+#include "uuid.h"
+
+/* stub functions for backend API */
+void sipe_backend_debug_literal(sipe_debug_level level,
+				const gchar *msg)
+{
+	printf("DEBUG %d: %s", level, msg);
+}
+void sipe_backend_debug(sipe_debug_level level,
+			const gchar *format,
+			...)
+{
+	va_list args;
+	gchar *msg;
+	va_start(args, format);
+	msg = g_strdup_vprintf(format, args);
+	va_end(args);
+
+	sipe_backend_debug_literal(level, msg);
+	g_free(msg);
+}
+gboolean sipe_backend_debug_enabled(void)
+{
+	return TRUE;
+}
+
+const gchar *sip_transport_epid(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+const gchar *sip_transport_ip_address(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+char *generateUUIDfromEPID(SIPE_UNUSED_PARAMETER const gchar *epid) { return(NULL); }
+char *sipe_get_epid(SIPE_UNUSED_PARAMETER const char *self_sip_uri,
+		    SIPE_UNUSED_PARAMETER const char *hostname,
+		    SIPE_UNUSED_PARAMETER const char *ip_address) { return(NULL); }
+
+/* test helpers */
+static guint succeeded = 0;
+static guint failed    = 0;
+static const gchar *testname;
+
+static void assert_true(gboolean condition, const gchar *what)
+{
+	if (condition) {
+		succeeded++;
+	} else {
+		printf("[%s]\nSDP FAILED: %s\n", testname, what);
+		failed++;
+	}
+}
+
+static void assert_string(const gchar *s, const gchar *expected,
+			  const gchar *what)
+{
+	if (sipe_strequal(s, expected)) {
+		succeeded++;
+	} else {
+		printf("[%s]\nSDP FAILED: %s '%s' expected: '%s'\n",
+		       testname, what,
+		       s ? s : "(nil)", expected ? expected : "(nil)");
+		failed++;
+	}
+}
+
+static struct sdpmsg *parse(const gchar *sdp)
+{
+	gchar *copy = g_strdup(sdp);
+	struct sdpmsg *msg = sdpmsg_parse_msg(copy);
+	g_free(copy);
+	return(msg);
+}
+
+/*
+ * Prepare a parsed message for serialization like sipe-media.c does for
+ * a local message: attributes that are generated from the parsed fields
+ * are removed, only the remaining ones are passed through.
+ */
+static const gchar * const generated_attributes[] = {
+	"candidate", "remote-candidates", "remote-candidate",
+	"rtpmap", "fmtp", "crypto", "ice-ufrag", "ice-pwd",
+	NULL
+};
+
+static void prepare_for_serialization(struct sdpmsg *msg)
+{
+	GSList *entry;
+
+	for (entry = msg->media; entry; entry = entry->next) {
+		struct sdpmedia *media = entry->data;
+		GSList *attrs = media->attributes;
+		GSList *kept = NULL;
+
+		for (; attrs; attrs = attrs->next) {
+			struct sipnameval *attr = attrs->data;
+			const gchar * const *name;
+
+			for (name = generated_attributes; *name; name++)
+				if (sipe_strcase_equal(attr->name, *name))
+					break;
+
+			if (!*name)
+				kept = sipe_utils_nameval_add(kept,
+							      attr->name,
+							      attr->value);
+		}
+		sipe_utils_nameval_free(media->attributes);
+		media->attributes = kept;
+
+		if (!media->ip)
+			media->ip = g_strdup(msg->ip);
+	}
+}
+
+static void assert_candidates_equal(GSList *c1, GSList *c2)
+{
+	assert_true(g_slist_length(c1) == g_slist_length(c2),
+		    "candidate count");
+
+	for (; c1 && c2; c1 = c1->next, c2 = c2->next) {
+		struct sdpcandidate *a = c1->data;
+		struct sdpcandidate *b = c2->data;
+
+		assert_string(b->foundation, a->foundation, "candidate foundation");
+		assert_true(a->component == b->component, "candidate component");
+		assert_true(a->type      == b->type,      "candidate type");
+		assert_true(a->protocol  == b->protocol,  "candidate protocol");
+		assert_true(a->priority  == b->priority,  "candidate priority");
+		assert_string(b->ip, a->ip, "candidate IP");
+		assert_true(a->port      == b->port,      "candidate port");
+		assert_string(b->base_ip, a->base_ip, "candidate base IP");
+		assert_true(a->base_port == b->base_port, "candidate base port");
+		assert_string(b->username, a->username, "candidate username");
+		assert_string(b->password, a->password, "candidate password");
+	}
+}
+
+static void assert_codecs_equal(GSList *c1, GSList *c2)
+{
+	assert_true(g_slist_length(c1) == g_slist_length(c2),
+		    "codec count");
+
+	for (; c1 && c2; c1 = c1->next, c2 = c2->next) {
+		struct sdpcodec *a = c1->data;
+		struct sdpcodec *b = c2->data;
+		GSList *p1 = a->parameters;
+		GSList *p2 = b->parameters;
+
+		assert_true(a->id         == b->id,         "codec ID");
+		assert_string(b->name, a->name, "codec name");
+		assert_true(a->clock_rate == b->clock_rate, "codec clock rate");
+		assert_true(a->type       == b->type,       "codec type");
+
+		assert_true(g_slist_length(p1) == g_slist_length(p2),
+			    "codec parameter count");
+		for (; p1 && p2; p1 = p1->next, p2 = p2->next) {
+			struct sipnameval *n1 = p1->data;
+			struct sipnameval *n2 = p2->data;
+			assert_string(n2->name,  n1->name,  "codec parameter name");
+			assert_string(n2->value, n1->value, "codec parameter value");
+		}
+	}
+}
+
+static void assert_messages_equal(const struct sdpmsg *m1,
+				  const struct sdpmsg *m2)
+{
+	GSList *e1 = m1->media;
+	GSList *e2 = m2->media;
+
+	assert_string(m2->ip, m1->ip, "IP");
+	assert_true(m1->ice_version == m2->ice_version, "ICE version");
+	assert_true(g_slist_length(e1) == g_slist_length(e2), "media count");
+
+	for (; e1 && e2; e1 = e1->next, e2 = e2->next) {
+		struct sdpmedia *a = e1->data;
+		struct sdpmedia *b = e2->data;
+
+		assert_string(b->name, a->name, "media name");
+		assert_true(a->port == b->port, "media port");
+		assert_true(a->encryption_active == b->encryption_active,
+			    "media encryption");
+		assert_true((a->encryption_key == NULL) == (b->encryption_key == NULL),
+			    "media encryption key");
+		if (a->encryption_key && b->encryption_key)
+			assert_true(memcmp(a->encryption_key,
+					   b->encryption_key,
+					   SIPE_SRTP_KEY_LEN) == 0,
+				    "media encryption key data");
+		assert_true(a->encryption_key_id == b->encryption_key_id,
+			    "media encryption key ID");
+
+		assert_candidates_equal(a->candidates, b->candidates);
+		assert_codecs_equal(a->codecs, b->codecs);
+	}
+}
+
+/*
+ * parse -> serialize must produce the expected message, parsing that again
+ * must produce the same data and serializing it again the same message.
+ */
+static void assert_round_trip(const gchar *name,
+			      const gchar *sdp,
+			      const gchar *expected)
+{
+	struct sdpmsg *msg1 = parse(sdp);
+	struct sdpmsg *msg2;
+	gchar *sdp1;
+	gchar *sdp2;
+
+	testname = name;
+
+	assert_true(msg1 != NULL, "parse original");
+	if (!msg1)
+		return;
+	prepare_for_serialization(msg1);
+	sdp1 = sdpmsg_to_string(msg1);
+	assert_string(sdp1, expected, "serialized");
+
+	msg2 = parse(sdp1);
+	assert_true(msg2 != NULL, "parse serialized");
+	if (msg2) {
+		assert_messages_equal(msg1, msg2);
+
+		prepare_for_serialization(msg2);
+		sdp2 = sdpmsg_to_string(msg2);
+		assert_string(sdp2, sdp1, "serialized again");
+		g_free(sdp2);
+		sdpmsg_free(msg2);
+	}
+
+	g_free(sdp1);
+	sdpmsg_free(msg1);
+}
+
+#define SDP_HEADER \
+	"v=0\r\n" \
+	"o=- 0 0 IN IP4 192.168.0.10\r\n" \
+	"s=session\r\n" \
+	"c=IN IP4 192.168.0.10\r\n" \
+	"b=CT:99980\r\n" \
+	"t=0 0\r\n"
+
+#define SDP_KEY "AAECAwQFBgcICQoLDA0ODxAREhMUFRYXGBkaGxwd"
+
+int main(SIPE_UNUSED_PARAMETER int argc, SIPE_UNUSED_PARAMETER char **argv)
+{
+	struct sdpmsg *msg;
+
+	/* RFC 5245 ICE: multiple media, candidate types, ICE attributes */
+	assert_round_trip("RFC 5245",
+			  SDP_HEADER
+			  "m=audio 50000 RTP/SAVP 0 101\r\n"
+			  "a=candidate:1 1 UDP 2130706431 192.168.0.10 50000 typ host \r\n"
+			  "a=candidate:1 2 UDP 2130705918 192.168.0.10 50001 typ host \r\n"
+			  "a=candidate:2 1 UDP 1694498815 203.0.113.5 40000 typ srflx raddr 192.168.0.10 rport 50000\r\n"
+			  "a=candidate:3 1 UDP 16648703 198.51.100.7 41000 typ relay raddr 203.0.113.5 rport 40000\r\n"
+			  "a=crypto:1 AES_CM_128_HMAC_SHA1_80 inline:" SDP_KEY "|2^31\r\n"
+			  "a=rtpmap:0 PCMU/8000\r\n"
+			  "a=rtpmap:101 telephone-event/8000\r\n"
+			  "a=fmtp:101 events=0-16\r\n"
+			  "a=rtcp:50001\r\n"
+			  "a=ice-ufrag:ufrag1\r\n"
+			  "a=ice-pwd:password1\r\n"
+			  "m=video 50010 RTP/AVP 121\r\n"
+			  "a=ice-ufrag:ufrag2\r\n"
+			  "a=ice-pwd:password2\r\n"
+			  "a=candidate:4 1 UDP 2130706431 192.168.0.10 50010 typ host \r\n"
+			  "a=candidate:4 1 TCP-PASS 2130706430 192.168.0.10 50012 typ host \r\n"
+			  "a=rtpmap:121 x-rtvc1/90000\r\n"
+			  "a=x-caps:121 263:1920:1080:30.0:2000000:1\r\n",
+			  SDP_HEADER
+			  "m=audio 50000 RTP/SAVP 0 101\r\n"
+			  "a=candidate:1 1 UDP 2130706431 192.168.0.10 50000 typ host \r\n"
+			  "a=candidate:1 2 UDP 2130705918 192.168.0.10 50001 typ host \r\n"
+			  "a=candidate:2 1 UDP 1694498815 203.0.113.5 40000 typ srflx raddr 192.168.0.10 rport 50000\r\n"
+			  "a=candidate:3 1 UDP 16648703 198.51.100.7 41000 typ relay raddr 203.0.113.5 rport 40000\r\n"
+			  "a=crypto:1 AES_CM_128_HMAC_SHA1_80 inline:" SDP_KEY "|2^31\r\n"
+			  "a=rtpmap:0 PCMU/8000\r\n"
+			  "a=rtpmap:101 telephone-event/8000\r\n"
+			  "a=fmtp:101 events=0-16\r\n"
+			  "a=rtcp:50001\r\n"
+			  "a=ice-ufrag:ufrag1\r\n"
+			  "a=ice-pwd:password1\r\n"
+			  "m=video 50010 RTP/AVP 121\r\n"
+			  "a=candidate:4 1 UDP 2130706431 192.168.0.10 50010 typ host \r\n"
+			  "a=candidate:4 1 TCP-PASS 2130706430 192.168.0.10 50012 typ host \r\n"
+			  "a=rtpmap:121 x-rtvc1/90000\r\n"
+			  "a=x-caps:121 263:1920:1080:30.0:2000000:1\r\n"
+			  "a=ice-ufrag:ufrag2\r\n"
+			  "a=ice-pwd:password2\r\n");
+
+	/* ICE draft 6: credentials are part of the candidate */
+	assert_round_trip("draft 6",
+			  SDP_HEADER
+			  "m=audio 50000 RTP/AVP 0\r\n"
+			  "a=candidate:dXNlcm5hbWUx 1 cGFzc3dvcmQx UDP 0.9 192.168.0.10 50000\r\n"
+			  "a=candidate:dXNlcm5hbWUx 2 cGFzc3dvcmQx UDP 0.9 192.168.0.10 50001\r\n"
+			  "a=rtpmap:0 PCMU/8000\r\n"
+			  "m=data 50020 TCP/RTP/AVP 127\r\n"
+			  "a=candidate:dXNlcm5hbWUy 1 cGFzc3dvcmQy TCP 0.8 192.168.0.10 50020\r\n"
+			  "a=rtpmap:127 x-data/90000\r\n"
+			  "a=setup:active\r\n",
+			  SDP_HEADER
+			  "m=audio 50000 RTP/AVP 0\r\n"
+			  "a=candidate:dXNlcm5hbWUx 1 cGFzc3dvcmQx UDP 0.9 192.168.0.10 50000\r\n"
+			  "a=candidate:dXNlcm5hbWUx 2 cGFzc3dvcmQx UDP 0.9 192.168.0.10 50001\r\n"
+			  "a=rtpmap:0 PCMU/8000\r\n"
+			  "m=data 50020 TCP/RTP/AVP 127\r\n"
+			  "a=candidate:dXNlcm5hbWUy 1 cGFzc3dvcmQy TCP 0.8 192.168.0.10 50020\r\n"
+			  "a=rtpmap:127 x-data/90000\r\n"
+			  "a=setup:active\r\n");
+
+	/* parsed fields */
+	testname = "RFC 5245 fields";
+	msg = parse(SDP_HEADER
+		    "m=audio 50000 RTP/AVP 0\r\n"
+		    "a=candidate:2 1 UDP 1694498815 203.0.113.5 40000 typ srflx raddr 192.168.0.10 rport 50000\r\n"
+		    "a=ice-ufrag:ufrag1\r\n"
+		    "a=ice-pwd:password1\r\n"
+		    "a=rtpmap:0 PCMU/8000\r\n");
+	assert_true(msg != NULL, "parse");
+	if (msg) {
+		struct sdpmedia *media = msg->media->data;
+		struct sdpcandidate *c = media->candidates->data;
+
+		assert_true(msg->ice_version == SIPE_ICE_RFC_5245, "ICE version");
+		assert_string(c->ip, "203.0.113.5", "candidate IP");
+		assert_true(c->port == 40000, "candidate port");
+		assert_string(c->base_ip, "192.168.0.10", "candidate base IP");
+		assert_true(c->base_port == 50000, "candidate base port");
+		assert_string(c->username, "ufrag1", "candidate username");
+		assert_string(c->password, "password1", "candidate password");
+		sdpmsg_free(msg);
+	}
+
+	/* illegal */
+	testname = "illegal";
+	msg = parse(SDP_HEADER
+		    "m=audio 50000 RTP/AVP 0\r\n"
+		    "a=candidate:1 1 XXX 2130706431 192.168.0.10 50000 typ host\r\n");
+	assert_true(msg == NULL, "unknown protocol");
+	msg = parse(SDP_HEADER
+		    "m=unknown 50000 RTP/AVP 0\r\n");
+	assert_true(msg == NULL, "unknown media");
+
+	printf("Result: %d PASSED %d FAILED\n", succeeded, failed);
+	return(failed);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
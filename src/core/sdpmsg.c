@@ -32,77 +32,166 @@
 #include "sdpmsg.h"
 #include "sipe-utils.h"
 
+/* substring of the SDP message, not NUL-terminated */
+struct sdp_token {
+	const gchar *start;
+	gsize length;
+};
+
+/*
+ * Same semantics as g_strsplit_set(), but the tokens point into the
+ * original string instead of being copied. If there are more than
+ * max_tokens tokens then the last one contains the rest of the string.
+ *
+ * Returns the number of tokens.
+ */
+static guint
+sdp_tokenize(const gchar *str, gsize length, const gchar *delimiters,
+	     struct sdp_token *tokens, guint max_tokens)
+{
+	const gchar *end = str + length;
+	guint count = 0;
+
+	if (length == 0)
+		return 0;
+
+	tokens[0].start = str;
+	while (TRUE) {
+		struct sdp_token *token = tokens + count++;
+		const gchar *ptr = token->start;
+
+		if (count < max_tokens) {
+			while ((ptr < end) && !strchr(delimiters, *ptr))
+				ptr++;
+		} else {
+			ptr = end;
+		}
+
+		token->length = ptr - token->start;
+		if (ptr == end)
+			return count;
+
+		tokens[count].start = ptr + 1;
+	}
+}
+
+static gboolean
+token_equal(const struct sdp_token *token, const gchar *str)
+{
+	return (token->length == strlen(str)) &&
+		(strncmp(token->start, str, token->length) == 0);
+}
+
 static gboolean
-append_attribute(struct sdpmedia *media, gchar *attr)
+token_case_equal(const struct sdp_token *token, const gchar *str)
 {
-	gchar **parts = g_strsplit(attr + 2, ":", 2);
+	return (token->length == strlen(str)) &&
+		(g_ascii_strncasecmp(token->start, str, token->length) == 0);
+}
+
+static gchar *
+token_dup(const struct sdp_token *token)
+{
+	return g_strndup(token->start, token->length);
+}
+
+static int
+token_int(const struct sdp_token *token)
+{
+	/* atoi() stops at the delimiter following the token */
+	return token->length ? atoi(token->start) : 0;
+}
+
+static struct sipnameval *
+nameval_new(const struct sdp_token *name, const struct sdp_token *value)
+{
+	struct sipnameval *nameval = g_new(struct sipnameval, 1);
 
-	if(!parts[0]) {
-		g_strfreev(parts);
+	nameval->name  = token_dup(name);
+	nameval->value = token_dup(value);
+
+	return nameval;
+}
+
+static gboolean
+parse_attribute(struct sdpmedia *media, const gchar *line, gsize length)
+{
+	struct sdp_token tokens[2];
+	guint count = sdp_tokenize(line + 2, length - 2, ":", tokens, 2);
+
+	if (count == 0) {
 		return FALSE;
 	}
 
-	media->attributes = sipe_utils_nameval_add(media->attributes,
-						   parts[0],
-						   parts[1] ? parts[1] : "");
-	g_strfreev(parts);
+	if (count == 1) {
+		tokens[1].start  = "";
+		tokens[1].length = 0;
+	}
+
+	/* list is reversed in parse_media_finish() */
+	media->attributes = g_slist_prepend(media->attributes,
+					    nameval_new(tokens, tokens + 1));
 	return TRUE;
 }
 
-static gboolean
-parse_attributes(struct sdpmsg *smsg, gchar *msg) {
-	gchar		**lines = g_strsplit(msg, "\r\n", 0);
-	gchar		**ptr = lines;
-
-	while (*ptr != NULL) {
-		if (g_str_has_prefix(*ptr, "o=")) {
-			gchar **parts = g_strsplit(*ptr + 2, " ", 6);
-			if (g_strv_length(parts) != 6) {
-				g_strfreev(parts);
-				g_strfreev(lines);
-				return FALSE;
-			}
-
-			smsg->ip = g_strdup(parts[5]);
-			g_strfreev(parts);
-		} else if (g_str_has_prefix(*ptr, "m=")) {
-			gchar **parts;
-			struct sdpmedia *media;
-
-			parts = g_strsplit(*ptr + 2, " ", 3);
-			if (g_strv_length(parts) < 3) {
-				g_strfreev(parts);
-				g_strfreev(lines);
-				return FALSE;
-			}
+static void
+parse_media_finish(struct sdpmedia *media)
+{
+	if (media) {
+		media->attributes = g_slist_reverse(media->attributes);
+	}
+}
 
-			media = g_new0(struct sdpmedia, 1);
+static gboolean
+parse_attributes(struct sdpmsg *smsg, const gchar *msg) {
+	struct sdpmedia *media = NULL;
+	const gchar *line = msg;
 
-			smsg->media = g_slist_append(smsg->media, media);
+	while (*line) {
+		const gchar *end = strstr(line, "\r\n");
+		gsize length = end ? (gsize) (end - line) : strlen(line);
 
-			media->name = g_strdup(parts[0]);
-			media->port = atoi(parts[1]);
-			media->encryption_active =
-					g_strstr_len(parts[2], -1, "/SAVP") != NULL;
+		if (length >= 2 && line[1] == '=') {
+			struct sdp_token parts[6];
 
-			g_strfreev(parts);
+			if (!media && line[0] == 'o') {
+				if (sdp_tokenize(line + 2, length - 2, " ",
+						 parts, 6) != 6) {
+					return FALSE;
+				}
 
-			while (*(++ptr) && !g_str_has_prefix(*ptr, "m=")) {
+				g_free(smsg->ip);
+				smsg->ip = token_dup(parts + 5);
+			} else if (line[0] == 'm') {
+				if (sdp_tokenize(line + 2, length - 2, " ",
+						 parts, 3) < 3) {
+					parse_media_finish(media);
+					return FALSE;
+				}
 
-				if (g_str_has_prefix(*ptr, "a=")) {
-					if (!append_attribute(media, *ptr)) {
-						g_strfreev(lines);
-						return FALSE;
-					}
+				parse_media_finish(media);
+				media = g_new0(struct sdpmedia, 1);
+
+				smsg->media = g_slist_append(smsg->media, media);
+
+				media->name = token_dup(parts);
+				media->port = token_int(parts + 1);
+				media->encryption_active =
+						g_strstr_len(parts[2].start,
+							     parts[2].length,
+							     "/SAVP") != NULL;
+			} else if (media && line[0] == 'a') {
+				if (!parse_attribute(media, line, length)) {
+					parse_media_finish(media);
+					return FALSE;
 				}
 			}
-			continue;
 		}
 
-		++ptr;
+		line = end ? end + 2 : line + length;
 	}
 
-	g_strfreev(lines);
+	parse_media_finish(media);
 
 	return TRUE;
 }
@@ -110,9 +199,9 @@ parse_attributes(struct sdpmsg *smsg, gchar *msg) {
 static struct sdpcandidate * sdpcandidate_copy(struct sdpcandidate *candidate);
 
 static SipeComponentType
-parse_component(const gchar *str)
+parse_component(const struct sdp_token *token)
 {
-	switch (atoi(str)) {
+	switch (token_int(token)) {
 		case 1: return  SIPE_COMPONENT_RTP;
 		case 2: return  SIPE_COMPONENT_RTCP;
 		default: return SIPE_COMPONENT_NONE;
@@ -120,149 +209,164 @@ parse_component(const gchar *str)
 }
 
 static gchar *
-base64_pad(const gchar* str)
+base64_pad(const struct sdp_token *token)
 {
-	size_t str_len = strlen(str);
-	int mod = str_len % 4;
+	int pad = (4 - token->length % 4) % 4;
+	gchar *result = g_malloc(token->length + pad + 1);
 
-	if (mod > 0) {
-		gchar *result = NULL;
-		int pad = 4 - mod;
-		gchar *ptr = result = g_malloc(str_len + pad + 1);
+	memcpy(result, token->start, token->length);
+	memset(result + token->length, '=', pad);
+	result[token->length + pad] = '\0';
 
-		memcpy(ptr, str, str_len);
-		ptr += str_len;
-		memset(ptr, '=', pad);
-		ptr += pad;
-		*ptr = '\0';
-
-		return result;
-	} else
-		return g_strdup(str);
+	return result;
 }
 
+/* candidate lists are built in reverse order, see parse_candidates() */
 static gboolean
-parse_append_candidate_draft_6(gchar **tokens, GSList **candidates)
+parse_prepend_candidate_draft_6(const struct sdp_token *tokens, guint count,
+				GSList **candidates)
 {
 	struct sdpcandidate *candidate;
 
-	if (g_strv_length(tokens) < 7 || strlen(tokens[4]) < 3) {
+	if (count < 7 || tokens[4].length < 3) {
 		return FALSE;
 	}
 
 	candidate = g_new0(struct sdpcandidate, 1);
 
-	candidate->username = base64_pad(tokens[0]);
-	candidate->component = parse_component(tokens[1]);
-	candidate->password = base64_pad(tokens[2]);
+	candidate->username = base64_pad(tokens);
+	candidate->component = parse_component(tokens + 1);
+	candidate->password = base64_pad(tokens + 2);
 
-	if (sipe_strequal(tokens[3], "UDP"))
+	if (token_equal(tokens + 3, "UDP"))
 		candidate->protocol = SIPE_NETWORK_PROTOCOL_UDP;
-	else if (sipe_strequal(tokens[3], "TCP"))
+	else if (token_equal(tokens + 3, "TCP"))
 		candidate->protocol = SIPE_NETWORK_PROTOCOL_TCP_ACTIVE;
 	else {
 		sdpcandidate_free(candidate);
 		return FALSE;
 	}
 
-	candidate->priority = atoi(tokens[4] + 2);
-	candidate->ip = g_strdup(tokens[5]);
-	candidate->port = atoi(tokens[6]);
+	candidate->priority = atoi(tokens[4].start + 2);
+	candidate->ip = token_dup(tokens + 5);
+	candidate->port = token_int(tokens + 6);
 
-	*candidates = g_slist_append(*candidates, candidate);
+	*candidates = g_slist_prepend(*candidates, candidate);
 
 	// draft 6 candidates are both active and passive
 	if (candidate->protocol == SIPE_NETWORK_PROTOCOL_TCP_ACTIVE) {
 		candidate = sdpcandidate_copy(candidate);
 		candidate->protocol = SIPE_NETWORK_PROTOCOL_TCP_PASSIVE;
-		*candidates = g_slist_append(*candidates, candidate);
+		*candidates = g_slist_prepend(*candidates, candidate);
 	}
 
 	return TRUE;
 }
 
 static gboolean
-parse_append_candidate_rfc_5245(gchar **tokens, GSList **candidates)
+parse_prepend_candidate_rfc_5245(const struct sdp_token *tokens, guint count,
+				 GSList **candidates)
 {
 	struct sdpcandidate *candidate;
 
-	if (g_strv_length(tokens) < 8) {
+	if (count < 8) {
 		return FALSE;
 	}
 
 	candidate = g_new0(struct sdpcandidate, 1);
-	candidate->foundation = g_strdup(tokens[0]);
-	candidate->component = parse_component(tokens[1]);
+	candidate->foundation = token_dup(tokens);
+	candidate->component = parse_component(tokens + 1);
 
-	if (sipe_strcase_equal(tokens[2], "UDP"))
+	if (token_case_equal(tokens + 2, "UDP"))
 		candidate->protocol = SIPE_NETWORK_PROTOCOL_UDP;
-	else if (sipe_strcase_equal(tokens[2], "TCP-ACT"))
+	else if (token_case_equal(tokens + 2, "TCP-ACT"))
 		candidate->protocol = SIPE_NETWORK_PROTOCOL_TCP_ACTIVE;
-	else if (sipe_strcase_equal(tokens[2], "TCP-PASS"))
+	else if (token_case_equal(tokens + 2, "TCP-PASS"))
 		candidate->protocol = SIPE_NETWORK_PROTOCOL_TCP_PASSIVE;
 	else {
 		sdpcandidate_free(candidate);
 		return FALSE;
 	}
 
-	candidate->priority = atoi(tokens[3]);
-	candidate->ip = g_strdup(tokens[4]);
-	candidate->port = atoi(tokens[5]);
+	candidate->priority = token_int(tokens + 3);
+	candidate->ip = token_dup(tokens + 4);
+	candidate->port = token_int(tokens + 5);
 
-	if (sipe_strcase_equal(tokens[7], "host"))
+	if (token_case_equal(tokens + 7, "host"))
 		candidate->type = SIPE_CANDIDATE_TYPE_HOST;
-	else if (sipe_strcase_equal(tokens[7], "relay"))
+	else if (token_case_equal(tokens + 7, "relay"))
 		candidate->type = SIPE_CANDIDATE_TYPE_RELAY;
-	else if (sipe_strcase_equal(tokens[7], "srflx"))
+	else if (token_case_equal(tokens + 7, "srflx"))
 		candidate->type = SIPE_CANDIDATE_TYPE_SRFLX;
-	else if (sipe_strcase_equal(tokens[7], "prflx"))
+	else if (token_case_equal(tokens + 7, "prflx"))
 		candidate->type = SIPE_CANDIDATE_TYPE_PRFLX;
 	else {
 		sdpcandidate_free(candidate);
 		return FALSE;
 	}
 
-	*candidates = g_slist_append(*candidates, candidate);
+	/* related address of reflexive and relayed candidates */
+	if (count > 8) {
+		struct sdp_token related[4];
+
+		if ((sdp_tokenize(tokens[8].start, tokens[8].length, " ",
+				  related, 4) == 4) &&
+		    token_equal(related, "raddr") &&
+		    token_equal(related + 2, "rport")) {
+			candidate->base_ip = token_dup(related + 1);
+			candidate->base_port = token_int(related + 3);
+		}
+	}
+
+	*candidates = g_slist_prepend(*candidates, candidate);
 
 	return TRUE;
 }
 
+/* RFC 5245 candidates need 8 tokens, the last one collects the rest */
+#define SDP_CANDIDATE_MAX_TOKENS 9
+
 static gboolean
 parse_candidates(GSList *attrs, SipeIceVersion *ice_version, GSList **candidates)
 {
-	const gchar *attr;
-	int i = 0;
+	GSList *entry;
 
 	g_return_val_if_fail(*candidates == NULL, FALSE);
 
-	while ((attr = sipe_utils_nameval_find_instance(attrs, "candidate", i++))) {
-		gchar **tokens = g_strsplit_set(attr, " ", 0);
+	for (entry = attrs; entry; entry = entry->next) {
+		struct sipnameval *attr = entry->data;
+		struct sdp_token tokens[SDP_CANDIDATE_MAX_TOKENS];
 		gboolean parsed_ok;
+		guint count;
 
-		if (g_strv_length(tokens) < 7) {
-			g_strfreev(tokens);
+		if (!sipe_strcase_equal(attr->name, "candidate"))
+			continue;
+
+		count = sdp_tokenize(attr->value, strlen(attr->value), " ",
+				     tokens, SDP_CANDIDATE_MAX_TOKENS);
+		if (count < 7) {
 			return FALSE;
 		}
 
-		if (sipe_strequal(tokens[6], "typ")) {
-			parsed_ok = parse_append_candidate_rfc_5245(tokens,
-								    candidates);
+		if (token_equal(tokens + 6, "typ")) {
+			parsed_ok = parse_prepend_candidate_rfc_5245(tokens, count,
+								     candidates);
 			if (*candidates)
 				*ice_version = SIPE_ICE_RFC_5245;
 		} else {
-			parsed_ok = parse_append_candidate_draft_6(tokens,
-								   candidates);
+			parsed_ok = parse_prepend_candidate_draft_6(tokens, count,
+								    candidates);
 			if (*candidates)
 				*ice_version = SIPE_ICE_DRAFT_6;
 		}
 
-		g_strfreev(tokens);
-
 		if (!parsed_ok) {
 			return FALSE;
 		}
 	}
 
+	*candidates = g_slist_reverse(*candidates);
+
 	if (!(*candidates))
 		*ice_version = SIPE_ICE_NO_ICE;
 
@@ -315,41 +419,39 @@ create_legacy_candidates(gchar *ip, guint16 port)
 static gboolean
 parse_codec_parameters(GSList *attrs, struct sdpcodec *codec)
 {
-	const gchar* params;
-	int i = 0;
+	for (; attrs; attrs = attrs->next) {
+		struct sipnameval *attr = attrs->data;
+		struct sdp_token tokens[2];
+		guint count;
 
-	while((params = sipe_utils_nameval_find_instance(attrs, "fmtp", i++))) {
-		gchar **tokens;
-		gchar **param;
+		if (!sipe_strcase_equal(attr->name, "fmtp"))
+			continue;
 
-		tokens = g_strsplit(params, " ", 0);
-		if (g_strv_length(tokens) < 1) {
-			g_strfreev(tokens);
+		count = sdp_tokenize(attr->value, strlen(attr->value), " ",
+				     tokens, 2);
+		if (count < 1) {
 			return FALSE;
 		}
 
-		if (atoi(tokens[0]) != codec->id) {
-			g_strfreev(tokens);
+		if (token_int(tokens) != codec->id) {
 			continue;
 		}
 
-		for (param = tokens + 1; *param; ++param) {
-			gchar **nameval = g_strsplit(*param, "=", 2);
-
-			if (g_strv_length(nameval) != 2) {
-				g_strfreev(nameval);
-				continue;
+		while (count == 2) {
+			struct sdp_token rest = tokens[1];
+			struct sdp_token nameval[2];
+
+			count = sdp_tokenize(rest.start, rest.length, " ",
+					     tokens, 2);
+			if (count &&
+			    (sdp_tokenize(tokens[0].start, tokens[0].length, "=",
+					  nameval, 2) == 2)) {
+				codec->parameters =
+						g_slist_append(codec->parameters,
+							       nameval_new(nameval,
+									   nameval + 1));
 			}
-
-			codec->parameters =
-					sipe_utils_nameval_add(codec->parameters,
-							       nameval[0],
-							       nameval[1]);
-
-			g_strfreev(nameval);
 		}
-
-		g_strfreev(tokens);
 	}
 
 	return TRUE;
@@ -359,66 +461,72 @@ parse_codec_parameters(GSList *attrs, struct sdpcodec *codec)
 static gboolean
 parse_codecs(GSList *attrs, SipeMediaType type, GSList **codecs)
 {
-	int i = 0;
-	const gchar *attr;
+	GSList *entry;
 
-	while ((attr = sipe_utils_nameval_find_instance(attrs, "rtpmap", i++))) {
+	for (entry = attrs; entry; entry = entry->next) {
+		struct sipnameval *attr = entry->data;
 		struct sdpcodec *codec;
-		gchar **tokens;
+		struct sdp_token tokens[4];
+		guint count;
 
-		tokens = g_strsplit_set(attr, " /", 4);
-		if (g_strv_length(tokens) < 3) {
-			g_strfreev(tokens);
+		if (!sipe_strcase_equal(attr->name, "rtpmap"))
+			continue;
+
+		count = sdp_tokenize(attr->value, strlen(attr->value), " /",
+				     tokens, 4);
+		if (count < 3) {
 			return FALSE;
 		}
 
 		codec = g_new0(struct sdpcodec, 1);
-		codec->id = atoi(tokens[0]);
-		codec->name = g_strdup(tokens[1]);
-		codec->clock_rate = atoi(tokens[2]);
+		codec->id = token_int(tokens);
+		codec->name = token_dup(tokens + 1);
+		codec->clock_rate = token_int(tokens + 2);
 		codec->type = type;
 
 		if (type == SIPE_MEDIA_AUDIO) {
-			codec->channels = tokens[3] ? atoi(tokens[3]) : 1;
+			codec->channels = (count > 3) ? token_int(tokens + 3) : 1;
 		}
 
-		g_strfreev(tokens);
-
 		if (!parse_codec_parameters(attrs, codec)) {
 			sdpcodec_free(codec);
 			return FALSE;
 		}
 
-		*codecs = g_slist_append(*codecs, codec);
+		*codecs = g_slist_prepend(*codecs, codec);
 	}
 
+	*codecs = g_slist_reverse(*codecs);
+
 	return TRUE;
 }
 
 static void
 parse_encryption_key(GSList *attrs, guchar **key, int *key_id)
 {
-	int i = 0;
-	const gchar *attr;
+	for (; attrs; attrs = attrs->next) {
+		struct sipnameval *attr = attrs->data;
+		struct sdp_token tokens[6];
 
-	while ((attr = sipe_utils_nameval_find_instance(attrs, "crypto", i++))) {
-		gchar **tokens = g_strsplit_set(attr, " :|", 6);
+		if (!sipe_strcase_equal(attr->name, "crypto"))
+			continue;
 
-		if (tokens[0] && tokens[1] && tokens[2] && tokens[3] && tokens[4] &&
-		    sipe_strcase_equal(tokens[1], "AES_CM_128_HMAC_SHA1_80") &&
-		    sipe_strequal(tokens[2], "inline") &&
-		    !tokens[5]) {
+		if ((sdp_tokenize(attr->value, strlen(attr->value), " :|",
+				  tokens, 6) == 5) &&
+		    token_case_equal(tokens + 1, "AES_CM_128_HMAC_SHA1_80") &&
+		    token_equal(tokens + 2, "inline")) {
+			gchar *encoded = token_dup(tokens + 3);
 			gsize key_len;
-			*key = g_base64_decode(tokens[3], &key_len);
+
+			*key = g_base64_decode(encoded, &key_len);
+			g_free(encoded);
 			if (key_len != SIPE_SRTP_KEY_LEN) {
 				g_free(*key);
 				*key = NULL;
 			}
-			*key_id = atoi(tokens[0]);
+			*key_id = token_int(tokens);
 		}
 
-		g_strfreev(tokens);
-
 		if (*key) {
 			break;
 		}
@@ -477,11 +585,9 @@ sdpmsg_parse_msg(gchar *msg)
 	return smsg;
 }
 
-static gchar *
-codecs_to_string(GSList *codecs)
+static void
+codecs_append(GString *result, GSList *codecs)
 {
-	GString *result = g_string_new(NULL);
-
 	for (; codecs; codecs = codecs->next) {
 		struct sdpcodec *c = codecs->data;
 		GSList *params = c->parameters;
@@ -493,10 +599,10 @@ codecs_to_string(GSList *codecs)
 				       c->clock_rate);
 
 		if (params) {
-			GString *param_str = g_string_new(NULL);
+			gsize fmtp_start = result->len;
 			int written_params = 0;
 
-			g_string_append_printf(param_str, "a=fmtp:%d", c->id);
+			g_string_append_printf(result, "a=fmtp:%d", c->id);
 
 			for (; params; params = params->next) {
 				struct sipnameval* par = params->data;
@@ -505,57 +611,46 @@ codecs_to_string(GSList *codecs)
 					continue;
 				}
 
-				g_string_append_printf(param_str, " %s=%s",
-						       par->name, par->value);
+				g_string_append_c(result, ' ');
+				g_string_append(result, par->name);
+				g_string_append_c(result, '=');
+				g_string_append(result, par->value);
 				++written_params;
 			}
 
-			g_string_append(param_str, "\r\n");
-
 			if (written_params > 0) {
-				g_string_append(result, param_str->str);
+				g_string_append(result, "\r\n");
+			} else {
+				g_string_truncate(result, fmtp_start);
 			}
-
-			g_string_free(param_str, TRUE);
 		}
 	}
-
-	return g_string_free(result, FALSE);
 }
 
-static gchar *
-codec_ids_to_string(GSList *codecs)
+static void
+codec_ids_append(GString *result, GSList *codecs)
 {
-	GString *result = g_string_new(NULL);
-
 	for (; codecs; codecs = codecs->next) {
 		struct sdpcodec *c = codecs->data;
 		g_string_append_printf(result, " %d", c->id);
 	}
-
-	return g_string_free(result, FALSE);
 }
 
-static gchar *
-base64_unpad(const gchar *str)
+static void
+base64_unpad_append(GString *result, const gchar *str)
 {
-	gchar *result = g_strdup(str);
-	gchar *ptr;
+	gsize len = strlen(str);
 
-	for (ptr = result + strlen(result); ptr != result; --ptr) {
-		if (*(ptr - 1) != '=') {
-			*ptr = '\0';
-			break;
-		}
-	}
+	while (len && (str[len - 1] == '='))
+		--len;
 
-	return result;
+	g_string_append_len(result, str, len);
 }
 
-static gchar *
-candidates_to_string(GSList *candidates, SipeIceVersion ice_version)
+static void
+candidates_append(GString *result, GSList *candidates,
+		  SipeIceVersion ice_version)
 {
-	GString *result = g_string_new("");
 	GSList *i;
 	GSList *processed_tcp_candidates = NULL;
 
@@ -563,7 +658,6 @@ candidates_to_string(GSList *candidates, SipeIceVersion ice_version)
 		struct sdpcandidate *c = i->data;
 		const gchar *protocol;
 		const gchar *type;
-		gchar *related = NULL;
 
 		if (ice_version == SIPE_ICE_RFC_5245) {
 
@@ -602,34 +696,32 @@ candidates_to_string(GSList *candidates, SipeIceVersion ice_version)
 					break;
 			}
 
+			g_string_append_printf(result,
+					       "a=candidate:%s %u %s %u %s %d typ %s ",
+					       c->foundation,
+					       c->component,
+					       protocol,
+					       c->priority,
+					       c->ip,
+					       c->port,
+					       type);
+
 			switch (c->type) {
 				case SIPE_CANDIDATE_TYPE_RELAY:
 				case SIPE_CANDIDATE_TYPE_SRFLX:
 				case SIPE_CANDIDATE_TYPE_PRFLX:
-					related = g_strdup_printf("raddr %s rport %d",
-								  c->base_ip,
-								  c->base_port);
+					g_string_append_printf(result,
+							       "raddr %s rport %d",
+							       c->base_ip,
+							       c->base_port);
 					break;
 				default:
 					break;
 			}
 
-			g_string_append_printf(result,
-					       "a=candidate:%s %u %s %u %s %d typ %s %s\r\n",
-					       c->foundation,
-					       c->component,
-					       protocol,
-					       c->priority,
-					       c->ip,
-					       c->port,
-					       type,
-					       related ? related : "");
-			g_free(related);
+			g_string_append(result, "\r\n");
 
 		} else if (ice_version == SIPE_ICE_DRAFT_6) {
-			gchar *username;
-			gchar *password;
-
 			switch (c->protocol) {
 				case SIPE_NETWORK_PROTOCOL_TCP_ACTIVE:
 				case SIPE_NETWORK_PROTOCOL_TCP_PASSIVE: {
@@ -648,7 +740,7 @@ candidates_to_string(GSList *candidates, SipeIceVersion ice_version)
 					} else {
 						protocol = "TCP";
 						processed_tcp_candidates =
-							g_slist_append(processed_tcp_candidates, c);
+							g_slist_prepend(processed_tcp_candidates, c);
 					}
 					break;
 				}
@@ -665,34 +757,26 @@ candidates_to_string(GSList *candidates, SipeIceVersion ice_version)
 				continue;
 			}
 
-			username = base64_unpad(c->username);
-			password = base64_unpad(c->password);
-
+			g_string_append(result, "a=candidate:");
+			base64_unpad_append(result, c->username);
+			g_string_append_printf(result, " %u ", c->component);
+			base64_unpad_append(result, c->password);
 			g_string_append_printf(result,
-					       "a=candidate:%s %u %s %s 0.%u %s %d\r\n",
-					       username,
-					       c->component,
-					       password,
+					       " %s 0.%u %s %d\r\n",
 					       protocol,
 					       c->priority,
 					       c->ip,
 					       c->port);
-
-			g_free(username);
-			g_free(password);
 		}
 	}
 
 	g_slist_free(processed_tcp_candidates);
-
-	return g_string_free(result, FALSE);
 }
 
-static gchar *
-remote_candidates_to_string(GSList *candidates, SipeIceVersion ice_version)
+static void
+remote_candidates_append(GString *result, GSList *candidates,
+			 SipeIceVersion ice_version)
 {
-	GString *result = g_string_new("");
-
 	if (candidates) {
 		if (ice_version == SIPE_ICE_RFC_5245) {
 			GSList *i;
@@ -711,58 +795,30 @@ remote_candidates_to_string(GSList *candidates, SipeIceVersion ice_version)
 					       c->username);
 		}
 	}
-
-	return g_string_free(result, FALSE);
 }
 
-static gchar *
-attributes_to_string(GSList *attributes)
+static void
+attributes_append(GString *result, GSList *attributes)
 {
-	GString *result = g_string_new("");
-
 	for (; attributes; attributes = attributes->next) {
 		struct sipnameval *a = attributes->data;
-		g_string_append_printf(result, "a=%s", a->name);
-		if (!sipe_strequal(a->value, ""))
-			g_string_append_printf(result, ":%s", a->value);
+		g_string_append(result, "a=");
+		g_string_append(result, a->name);
+		if (!sipe_strequal(a->value, "")) {
+			g_string_append_c(result, ':');
+			g_string_append(result, a->value);
+		}
 		g_string_append(result, "\r\n");
 	}
-
-	return g_string_free(result, FALSE);
 }
 
-static gchar *
-media_to_string(const struct sdpmsg *msg, const struct sdpmedia *media)
+static void
+media_append(GString *result, const struct sdpmsg *msg,
+	     const struct sdpmedia *media)
 {
-	gchar *media_str;
-
-	gchar *transport_profile = NULL;
-
-	gchar *media_conninfo = NULL;
-
-	gchar *codecs_str = NULL;
-	gchar *codec_ids_str = codec_ids_to_string(media->codecs);
-
-	gchar *candidates_str = NULL;
-	gchar *remote_candidates_str = NULL;
-
-	gchar *attributes_str = NULL;
-	gchar *credentials = NULL;
-
-	gchar *crypto = NULL;
-
 	gboolean uses_tcp_transport = TRUE;
 
 	if (media->port != 0) {
-		if (!sipe_strequal(msg->ip, media->ip)) {
-			media_conninfo = g_strdup_printf("c=IN IP4 %s\r\n", media->ip);
-		}
-
-		codecs_str = codecs_to_string(media->codecs);
-		candidates_str = candidates_to_string(media->candidates, msg->ice_version);
-		remote_candidates_str = remote_candidates_to_string(media->remote_candidates,
-								    msg->ice_version);
-
 		if (media->remote_candidates) {
 			struct sdpcandidate *c = media->remote_candidates->data;
 			uses_tcp_transport =
@@ -779,64 +835,53 @@ media_to_string(const struct sdpmsg *msg, const struct sdpmedia *media)
 				}
 			}
 		}
+	}
+
+	g_string_append_printf(result, "m=%s %d %sRTP/%sAVP",
+			       media->name, media->port,
+			       uses_tcp_transport ? "TCP/" : "",
+			       media->encryption_active ? "S" : "");
+	codec_ids_append(result, media->codecs);
+	g_string_append(result, "\r\n");
 
-		attributes_str = attributes_to_string(media->attributes);
+	if (media->port == 0) {
+		return;
+	}
 
-		if (msg->ice_version == SIPE_ICE_RFC_5245 && media->candidates) {
-			struct sdpcandidate *c = media->candidates->data;
+	if (!sipe_strequal(msg->ip, media->ip)) {
+		g_string_append_printf(result, "c=IN IP4 %s\r\n", media->ip);
+	}
 
-			credentials = g_strdup_printf("a=ice-ufrag:%s\r\n"
-						      "a=ice-pwd:%s\r\n",
-						      c->username,
-						      c->password);
-		}
+	candidates_append(result, media->candidates, msg->ice_version);
 
-		if (media->encryption_key) {
-			gchar *key_encoded = g_base64_encode(media->encryption_key, SIPE_SRTP_KEY_LEN);
-			crypto = g_strdup_printf("a=crypto:%d AES_CM_128_HMAC_SHA1_80 inline:%s|2^31\r\n",
-					media->encryption_key_id, key_encoded);
-			g_free(key_encoded);
-		}
+	if (media->encryption_key) {
+		gchar *key_encoded = g_base64_encode(media->encryption_key, SIPE_SRTP_KEY_LEN);
+		g_string_append_printf(result,
+				       "a=crypto:%d AES_CM_128_HMAC_SHA1_80 inline:%s|2^31\r\n",
+				       media->encryption_key_id, key_encoded);
+		g_free(key_encoded);
 	}
 
-	transport_profile = g_strdup_printf("%sRTP/%sAVP",
-					    uses_tcp_transport ? "TCP/" : "",
-					    media->encryption_active ? "S" : "");
-
-	media_str = g_strdup_printf("m=%s %d %s%s\r\n"
-				    "%s"
-				    "%s"
-				    "%s"
-				    "%s"
-				    "%s"
-				    "%s"
-				    "%s",
-				    media->name, media->port, transport_profile, codec_ids_str,
-				    media_conninfo ? media_conninfo : "",
-				    candidates_str ? candidates_str : "",
-				    crypto ? crypto : "",
-				    remote_candidates_str ? remote_candidates_str : "",
-				    codecs_str ? codecs_str : "",
-				    attributes_str ? attributes_str : "",
-				    credentials ? credentials : "");
-
-	g_free(transport_profile);
-	g_free(media_conninfo);
-	g_free(codecs_str);
-	g_free(codec_ids_str);
-	g_free(candidates_str);
-	g_free(remote_candidates_str);
-	g_free(attributes_str);
-	g_free(credentials);
-	g_free(crypto);
-
-	return media_str;
+	remote_candidates_append(result, media->remote_candidates,
+				 msg->ice_version);
+	codecs_append(result, media->codecs);
+	attributes_append(result, media->attributes);
+
+	if (msg->ice_version == SIPE_ICE_RFC_5245 && media->candidates) {
+		struct sdpcandidate *c = media->candidates->data;
+
+		g_string_append_printf(result,
+				       "a=ice-ufrag:%s\r\n"
+				       "a=ice-pwd:%s\r\n",
+				       c->username,
+				       c->password);
+	}
 }
 
 gchar *
 sdpmsg_to_string(const struct sdpmsg *msg)
 {
-	GString *body = g_string_new(NULL);
+	GString *body = g_string_sized_new(1024);
 	GSList *i;
 
 	g_string_append_printf(
@@ -851,9 +896,7 @@ sdpmsg_to_string(const struct sdpmsg *msg)
 
 
 	for (i = msg->media; i; i = i->next) {
-		gchar *media_str = media_to_string(msg, i->data);
-		g_string_append(body, media_str);
-		g_free(media_str);
+		media_append(body, msg, i->data);
 	}
 
 	return g_string_free(body, FALSE);
@@ -508,7 +508,6 @@ Response:
 	msg_str = sipmsg_breakdown_get_string(2, &msgbd);
 	sip_sec_ntlm_sipe_signature_make (NEGOTIATE_FLAGS_CONNLESS & ~NTLMSSP_NEGOTIATE_EXTENDED_SESSIONSECURITY,
 		msg_str, 0, exported_session_key2, exported_session_key2, mac);
-	sipmsg_breakdown_free(&msgbd);
 	assert_equal ("0100000000000000BF2E52667DDF6DED", mac, 16, TRUE);
 	/* sig = buff_to_hex_str((guint8 *)mac, 16); */
 	}
@@ -766,7 +765,6 @@ Message (length 352):
 	msg_str = sipmsg_breakdown_get_string(4, &msgbd);
 	assert_equal (request_sig, (guchar *)msg_str, strlen(request_sig), FALSE);
 	sip_sec_ntlm_sipe_signature_make (flags, msg_str, 0, client_sign_key, client_seal_key, mac);
-	sipmsg_breakdown_free(&msgbd);
 	assert_equal ("0100000029618e9651b65a7764000000", mac, 16, TRUE);
 	/* sig = buff_to_hex_str((guint8 *)mac, 16); */
 
@@ -779,7 +777,6 @@ Message (length 352):
 	assert_equal (response_sig, (guchar *)msg_str, strlen(response_sig), FALSE);
 	// server keys here
 	sip_sec_ntlm_sipe_signature_make (flags, msg_str, 0, server_sign_key, server_seal_key, mac);
-	sipmsg_breakdown_free(&msgbd);
 	assert_equal ("01000000E615438A917661BE64000000", mac, 16, TRUE);
 	/* sig = buff_to_hex_str((guint8 *)mac, 16); */
 
@@ -866,7 +863,6 @@ Message (length 352):
 
 	assert_equal (response_sig, (guchar *)msg_str, strlen(response_sig), FALSE);
 
-	sipmsg_breakdown_free(&msgbd);
 	}
 
 ////// UUID tests ///////
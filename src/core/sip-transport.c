@@ -69,8 +69,10 @@
 #include "sipe-backend.h"
 #include "sipe-core.h"
 #include "sipe-core-private.h"
+#include "sipe-buddy.h"
 #include "sipe-certificate.h"
 #include "sipe-dialog.h"
+#include "sipe-dns.h"
 #include "sipe-incoming.h"
 #include "sipe-lync-autodiscover.h"
 #include "sipe-nls.h"
@@ -79,6 +81,7 @@
 #include "sipe-sign.h"
 #include "sipe-subscriptions.h"
 #include "sipe-utils.h"
+#include "sipe-webticket.h"
 #include "uuid.h"
 
 struct sip_auth {
@@ -170,24 +173,30 @@ static void sipe_make_signature(struct sipe_core_private *sipe_private,
 	if (sip_sec_context_is_ready(transport->registrar.gssapi_context)) {
 		struct sipmsg_breakdown msgbd;
 		gchar *signature_input_str;
+		gchar *rand;
+		gchar *num;
 		msgbd.msg = msg;
 		sipmsg_breakdown_parse(&msgbd, transport->registrar.realm, transport->registrar.target,
 				       transport->registrar.protocol);
-		msgbd.rand = g_strdup_printf("%08x", g_random_int());
+		rand = g_strdup_printf("%08x", g_random_int());
+		sipmsg_breakdown_part_set(&msgbd.rand, rand);
 		transport->registrar.ntlm_num++;
-		msgbd.num = g_strdup_printf("%d", transport->registrar.ntlm_num);
+		num = g_strdup_printf("%d", transport->registrar.ntlm_num);
+		sipmsg_breakdown_part_set(&msgbd.num, num);
 		signature_input_str = sipmsg_breakdown_get_string(transport->registrar.version, &msgbd);
 		if (signature_input_str != NULL) {
 			char *signature_hex = sip_sec_make_signature(transport->registrar.gssapi_context, signature_input_str);
 			g_free(msg->signature);
 			msg->signature = signature_hex;
 			g_free(msg->rand);
-			msg->rand = g_strdup(msgbd.rand);
+			msg->rand = rand;
 			g_free(msg->num);
-			msg->num = g_strdup(msgbd.num);
+			msg->num = num;
 			g_free(signature_input_str);
+		} else {
+			g_free(rand);
+			g_free(num);
 		}
-		sipmsg_breakdown_free(&msgbd);
 	}
 }
 
@@ -566,9 +575,14 @@ static const gchar *sip_transport_user_agent(struct sipe_core_private *sipe_priv
 static void send_sip_message(struct sip_transport *transport,
 			     const gchar *string)
 {
+	struct sipe_transport_part part;
+
+	part.data   = string;
+	part.length = strlen(string);
+
 	sipe_utils_message_debug("SIP", string, NULL, TRUE);
 	transport->last_message = time(NULL);
-	sipe_backend_transport_message(transport->connection, string);
+	sipe_backend_transport_message(transport->connection, &part, 1);
 }
 
 static void start_keepalive_timer(struct sipe_core_private *sipe_private,
@@ -1197,6 +1211,12 @@ static gboolean process_register_response(struct sipe_core_private *sipe_private
 				if (!transport->subscribed) {
 					sipe_subscription_self_events(sipe_private);
 					transport->subscribed = TRUE;
+
+					/* fetch Web Tickets before they are needed */
+					sipe_webticket_prewarm(sipe_private);
+
+					/* resume photo fetches after redirect */
+					sipe_buddy_refresh_photos(sipe_private);
 				}
 
 				timeout = sipmsg_find_part_of_header(sipmsg_find_header(msg, "ms-keep-alive"),
@@ -1529,8 +1549,10 @@ void sip_transport_disconnect(struct sipe_core_private *sipe_private)
 
 	sipe_schedule_cancel(sipe_private, "<+keepalive-timeout>");
 
-	if (sipe_private->dns_query)
-		sipe_backend_dns_query_cancel(sipe_private->dns_query);
+	if (sipe_private->dns_query) {
+		sipe_dns_query_cancel(sipe_private->dns_query);
+		sipe_private->dns_query = NULL;
+	}
 
 }
 
@@ -1758,7 +1780,8 @@ static void sip_transport_input(struct sipe_transport_connection *conn)
 			sipe_utils_shrink_buffer(conn, cur);
 		} else {
 			if (msg) {
-				SIPE_DEBUG_INFO("sipe_transport_input: body too short (%d < %d, strlen %d) - ignoring message", remainder, msg->bodylen, (int)strlen(conn->buffer));
+				SIPE_DEBUG_INFO("sipe_transport_input: body too short (%d < %d) - ignoring message", remainder, msg->bodylen);
+				sipe_utils_buffer_hint(conn, cur, msg->bodylen);
 				sipmsg_free(msg);
                         }
 
@@ -1817,7 +1840,6 @@ static void sip_transport_input(struct sipe_transport_connection *conn)
 			g_free(signature_input_str);
 
 			g_free(rspauth);
-			sipmsg_breakdown_free(&msgbd);
 		} else {
 			process_input_message(sipe_private, msg);
 		}
@@ -1863,6 +1885,12 @@ static void sip_transport_connected(struct sipe_transport_connection *conn)
 	do_register(sipe_private, FALSE);
 }
 
+struct sip_service_data {
+	const char *protocol;
+	const char *transport;
+	guint type;
+};
+
 static void resolve_next_lync(struct sipe_core_private *sipe_private);
 static void resolve_next_service(struct sipe_core_private *sipe_private,
 				 const struct sip_service_data *start);
@@ -1878,6 +1906,11 @@ static void sip_transport_error(struct sipe_transport_connection *conn,
 		resolve_next_lync(sipe_private);
 	/* This failed attempt was based on a DNS SRV record */
 	} else if (sipe_private->service_data) {
+		/* don't use this answer again on next connect */
+		sipe_dns_forget_srv(sipe_private,
+				    sipe_private->service_data->protocol,
+				    sipe_private->service_data->transport,
+				    sipe_private->public.sip_domain);
 		resolve_next_service(sipe_private, NULL);
 	/* This failed attempt was based on a DNS A record */
 	} else if (sipe_private->address_data) {
@@ -1915,12 +1948,6 @@ static void sipe_server_register(struct sipe_core_private *sipe_private,
 	sipe_private->transport = transport;
 }
 
-struct sip_service_data {
-	const char *protocol;
-	const char *transport;
-	guint type;
-};
-
 /*
  * Autodiscover using DNS SRV records. See RFC2782/3263
  *
@@ -2035,6 +2062,7 @@ static void resolve_next_lync(struct sipe_core_private *sipe_private)
 	} else {
 		/* We tried all servers -> try DNS SRV next */
 		SIPE_LOG_INFO_NOFORMAT("no Lync Autodiscover servers found; trying SRV records next");
+		sipe_lync_autodiscover_forget(sipe_private);
 		resolve_next_service(sipe_private, services[type]);
 	}
 
@@ -2062,8 +2090,8 @@ static void resolve_next_service(struct sipe_core_private *sipe_private,
 	}
 
 	/* Try to resolve next service */
-	sipe_private->dns_query = sipe_backend_dns_query_srv(
-					SIPE_CORE_PUBLIC,
+	sipe_private->dns_query = sipe_dns_query_srv(
+					sipe_private,
 					sipe_private->service_data->protocol,
 					sipe_private->service_data->transport,
 					sipe_private->public.sip_domain,
@@ -2102,8 +2130,8 @@ static void resolve_next_address(struct sipe_core_private *sipe_private,
 	hostname = g_strdup_printf("%s.%s",
 				   sipe_private->address_data->prefix,
 				   sipe_private->public.sip_domain);
-	sipe_private->dns_query = sipe_backend_dns_query_a(
-					SIPE_CORE_PUBLIC,
+	sipe_private->dns_query = sipe_dns_query_a(
+					sipe_private,
 					hostname,
 					sipe_private->address_data->port,
 					(sipe_dns_resolved_cb) sipe_core_dns_resolved,
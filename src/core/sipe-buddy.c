@@ -61,6 +61,7 @@
 #include "sipe-utils.h"
 #include "sipe-webticket.h"
 #include "sipe-xml.h"
+#include "sipe-xml-async.h"
 
 struct sipe_buddies {
 	GHashTable *uri;
@@ -68,6 +69,24 @@ struct sipe_buddies {
 
 	/* Pending photo download HTTP requests */
 	GSList *pending_photo_requests;
+
+	/* Photo fetch scheduler */
+	GQueue *photo_queue;        /* URIs waiting for fetch, borrowed from photo_pending */
+	GHashTable *photo_pending;  /* key: URI, value: struct buddy_photo_fetch */
+	GHashTable *photo_fetched;  /* key: URI, value: time of last fetch */
+	guint photo_active;
+
+	/* memory statistics are logged when property updates have settled */
+	guint property_updates;
+	time_t stats_due;
+};
+
+struct buddy_photo_fetch {
+	/* photo location from presence, NULL -> look it up */
+	gchar *photo_hash;
+	gchar *photo_url;
+	gchar *headers;
+	gboolean active;
 };
 
 struct buddy_group_data {
@@ -79,10 +98,15 @@ struct photo_response_data {
 	gchar *who;
 	gchar *photo_hash;
 	struct sipe_http_request *request;
+	GByteArray *photo; /* streamed response body */
 };
 
-static void buddy_fetch_photo(struct sipe_core_private *sipe_private,
-			      const gchar *uri);
+static void buddy_photo_queue(struct sipe_core_private *sipe_private,
+			      const gchar *uri,
+			      gboolean priority);
+static void buddy_photo_done(struct sipe_core_private *sipe_private,
+			     const gchar *uri,
+			     gboolean fetched);
 static void photo_response_data_free(struct photo_response_data *data);
 
 void sipe_buddy_add_keys(struct sipe_core_private *sipe_private,
@@ -130,7 +154,7 @@ struct sipe_buddy *sipe_buddy_add(struct sipe_core_private *sipe_private,
 							  buddy->name);
 		}
 
-		buddy_fetch_photo(sipe_private, normalized_uri);
+		buddy_photo_queue(sipe_private, normalized_uri, FALSE);
 
 		normalized_uri = NULL; /* buddy takes ownership */
 	} else {
@@ -204,6 +228,16 @@ void sipe_buddy_add_to_group(struct sipe_core_private *sipe_private,
 	}
 }
 
+static void buddy_properties_reset(struct sipe_buddy *buddy)
+{
+	guint i;
+
+	for (i = 0; i < SIPE_BUDDY_PROPERTIES; i++) {
+		sipe_utils_intern_release(buddy->properties[i]);
+		buddy->properties[i] = NULL;
+	}
+}
+
 static gint buddy_group_compare(gconstpointer a, gconstpointer b)
 {
 	return(((const struct buddy_group_data *)a)->group->id -
@@ -217,6 +251,9 @@ void sipe_buddy_insert_group(struct sipe_buddy *buddy,
 
 	bgd->group = group;
 
+	/* new backend buddy doesn't have the cached property values */
+	buddy_properties_reset(buddy);
+
 	buddy->groups = sipe_utils_slist_insert_unique_sorted(buddy->groups,
 							      bgd,
 							      buddy_group_compare,
@@ -384,19 +421,20 @@ static void buddy_free(struct sipe_buddy *buddy)
 #endif
 	g_free(buddy->exchange_key);
 	g_free(buddy->change_key);
-	g_free(buddy->activity);
+	sipe_utils_intern_release(buddy->activity);
 	g_free(buddy->meeting_subject);
-	g_free(buddy->meeting_location);
+	sipe_utils_intern_release(buddy->meeting_location);
 	g_free(buddy->note);
 
 	g_free(buddy->cal_start_time);
 	g_free(buddy->cal_free_busy_base64);
 	g_free(buddy->cal_free_busy);
-	g_free(buddy->last_non_cal_activity);
+	sipe_utils_intern_release(buddy->last_non_cal_activity);
+	buddy_properties_reset(buddy);
 
 	sipe_cal_free_working_hours(buddy->cal_working_hours);
 
-	g_free(buddy->device_name);
+	sipe_utils_intern_release(buddy->device_name);
 	sipe_utils_slist_free_full(buddy->groups, buddy_group_free);
 	g_free(buddy);
 }
@@ -410,10 +448,113 @@ static gboolean buddy_free_cb(SIPE_UNUSED_PARAMETER gpointer key,
 	return(TRUE);
 }
 
+struct buddy_stats {
+	guint buddies;
+	guint properties;
+	gsize property_bytes;
+};
+
+static void buddy_stats_cb(SIPE_UNUSED_PARAMETER gpointer key,
+			   gpointer value,
+			   gpointer user_data)
+{
+	struct sipe_buddy *buddy  = value;
+	struct buddy_stats *stats = user_data;
+	guint i;
+
+	stats->buddies++;
+	for (i = 0; i < SIPE_BUDDY_PROPERTIES; i++)
+		if (buddy->properties[i]) {
+			stats->properties++;
+			stats->property_bytes += strlen(buddy->properties[i]) + 1;
+		}
+}
+
+/*
+ * Core memory used for buddy strings, compared to one g_strdup() per
+ * string field and no property cache. The backend copies of the property
+ * values are not included, i.e. the property cache is pure additional
+ * memory. malloc() overhead is ignored for both sides.
+ */
+static void buddy_memory_debug(struct sipe_core_private *sipe_private)
+{
+	struct sipe_utils_intern_stats pool;
+	struct buddy_stats stats = { 0, 0, 0 };
+	gsize tables;
+	gsize unpooled;
+
+	g_hash_table_foreach(sipe_private->buddies->uri,
+			     buddy_stats_cb,
+			     &stats);
+	sipe_utils_intern_stats(&pool);
+
+	tables   = stats.buddies * sizeof(((struct sipe_buddy *) NULL)->properties);
+	unpooled = pool.unpooled - stats.property_bytes;
+
+	SIPE_DEBUG_INFO("buddy_memory_debug: %d buddies, %d cached property values (tables %" G_GSIZE_FORMAT " bytes)",
+			stats.buddies, stats.properties, tables);
+	SIPE_DEBUG_INFO("buddy_memory_debug: pool %d strings, %d references, %" G_GSIZE_FORMAT " bytes",
+			pool.strings, pool.refs, pool.bytes);
+	SIPE_DEBUG_INFO("buddy_memory_debug: %" G_GSIZE_FORMAT " bytes without pool and property cache, %" G_GSIZE_FORMAT " bytes now, net %s %" G_GSIZE_FORMAT " bytes",
+			unpooled,
+			pool.bytes + tables,
+			(unpooled >= pool.bytes + tables) ? "saving" : "cost",
+			(unpooled >= pool.bytes + tables) ?
+			unpooled - pool.bytes - tables :
+			pool.bytes + tables - unpooled);
+}
+
+#define BUDDY_STATS_DELAY  30 /* seconds */
+#define BUDDY_STATS_ACTION "<+buddy-stats>"
+
+static void buddy_stats_schedule(struct sipe_core_private *sipe_private);
+static void buddy_stats_check(struct sipe_core_private *sipe_private,
+			      SIPE_UNUSED_PARAMETER gpointer unused)
+{
+	struct sipe_buddies *buddies = sipe_private->buddies;
+
+	/* wait until e.g. the initial contactCard burst has been processed */
+	if (buddies->property_updates) {
+		buddies->property_updates = 0;
+		buddy_stats_schedule(sipe_private);
+	} else {
+		buddies->stats_due = 0;
+		buddy_memory_debug(sipe_private);
+	}
+}
+
+static void buddy_stats_schedule(struct sipe_core_private *sipe_private)
+{
+	sipe_private->buddies->stats_due = time(NULL) + BUDDY_STATS_DELAY;
+	sipe_schedule_seconds(sipe_private,
+			      BUDDY_STATS_ACTION,
+			      NULL,
+			      BUDDY_STATS_DELAY,
+			      buddy_stats_check,
+			      NULL);
+}
+
+static void buddy_stats_update(struct sipe_core_private *sipe_private)
+{
+	struct sipe_buddies *buddies = sipe_private->buddies;
+
+	if (!sipe_backend_debug_enabled())
+		return;
+
+	buddies->property_updates++;
+
+	/* a lapsed due time means the action has been cancelled */
+	if (buddies->stats_due < time(NULL))
+		buddy_stats_schedule(sipe_private);
+}
+
 void sipe_buddy_free(struct sipe_core_private *sipe_private)
 {
 	struct sipe_buddies *buddies = sipe_private->buddies;
 
+	if (sipe_backend_debug_enabled())
+		buddy_memory_debug(sipe_private);
+
 	g_hash_table_foreach_steal(buddies->uri,
 				   buddy_free_cb,
 				   NULL);
@@ -427,6 +568,10 @@ void sipe_buddy_free(struct sipe_core_private *sipe_private)
 		photo_response_data_free(data);
 	}
 
+	g_queue_free(buddies->photo_queue);
+	g_hash_table_destroy(buddies->photo_pending);
+	g_hash_table_destroy(buddies->photo_fetched);
+
 	g_hash_table_destroy(buddies->uri);
 	g_hash_table_destroy(buddies->exchange_key);
 	g_free(buddies);
@@ -858,11 +1003,22 @@ void sipe_buddy_update_property(struct sipe_core_private *sipe_private,
 				sipe_buddy_info_fields propkey,
 				char *property_value)
 {
+	struct sipe_buddy *sbuddy = sipe_buddy_find_by_uri(sipe_private, uri);
 	GSList *buddies, *entry;
 
 	if (property_value)
 		property_value = g_strstrip(property_value);
 
+	/* value has already been pushed to all backend buddies */
+	if (sbuddy && (propkey < SIPE_BUDDY_PROPERTIES) &&
+	    !is_empty(property_value)) {
+		if (sipe_strequal(sbuddy->properties[propkey], property_value))
+			return;
+		sipe_utils_intern_release(sbuddy->properties[propkey]);
+		sbuddy->properties[propkey] = sipe_utils_intern(property_value);
+		buddy_stats_update(sipe_private);
+	}
+
 	entry = buddies = sipe_backend_buddy_find_all(SIPE_CORE_PUBLIC, uri, NULL); /* all buddies in different groups */
 	while (entry) {
 		gchar *prop_str;
@@ -1218,37 +1374,23 @@ static void search_ab_entry_response(struct sipe_core_private *sipe_private,
 	}
 }
 
-static gboolean process_search_contact_response(struct sipe_core_private *sipe_private,
-						struct sipmsg *msg,
-						struct transaction *trans)
+static void search_contact_response_parsed(struct sipe_core_private *sipe_private,
+					   const sipe_xml *searchResults,
+					   gpointer data)
 {
-	struct sipe_backend_search_token *token = trans->payload->data;
+	struct sipe_backend_search_token *token = data;
 	struct sipe_backend_search_results *results;
-	sipe_xml *searchResults;
 	const sipe_xml *mrow;
 	guint match_count = 0;
 	gboolean more = FALSE;
 
-	/* valid response? */
-	if (msg->response != 200) {
-		SIPE_DEBUG_ERROR("process_search_contact_response: request failed (%d)",
-				 msg->response);
-		sipe_backend_search_failed(SIPE_CORE_PUBLIC,
-					   token,
-					   _("Contact search failed"));
-		return(FALSE);
-	}
-
-	SIPE_DEBUG_INFO("process_search_contact_response: body:\n%s", msg->body ? msg->body : "");
-
 	/* valid XML? */
-	searchResults = sipe_xml_parse(msg->body, msg->bodylen);
 	if (!searchResults) {
 		SIPE_DEBUG_INFO_NOFORMAT("process_search_contact_response: no parseable searchResults");
 		sipe_backend_search_failed(SIPE_CORE_PUBLIC,
 					   token,
 					   _("Contact search failed"));
-		return(FALSE);
+		return;
 	}
 
 	/* any matches? */
@@ -1258,22 +1400,18 @@ static gboolean process_search_contact_response(struct sipe_core_private *sipe_p
 		sipe_backend_search_failed(SIPE_CORE_PUBLIC,
 					   token,
 					   _("No contacts found"));
-
-		sipe_xml_free(searchResults);
-		return(FALSE);
+		return;
 	}
 
 	/* OK, we found something - show the results to the user */
 	results = sipe_backend_search_results_start(SIPE_CORE_PUBLIC,
-						    trans->payload->data);
+						    token);
 	if (!results) {
 		SIPE_DEBUG_ERROR_NOFORMAT("process_search_contact_response: Unable to display the search results.");
 		sipe_backend_search_failed(SIPE_CORE_PUBLIC,
 					   token,
 					   _("Unable to display the search results"));
-
-		sipe_xml_free(searchResults);
-		return FALSE;
+		return;
 	}
 
 	for (/* initialized above */ ; mrow; mrow = sipe_xml_twin(mrow)) {
@@ -1296,7 +1434,33 @@ static gboolean process_search_contact_response(struct sipe_core_private *sipe_p
 	}
 
 	sipe_buddy_search_contacts_finalize(sipe_private, results, match_count, more);
-	sipe_xml_free(searchResults);
+}
+
+static gboolean process_search_contact_response(struct sipe_core_private *sipe_private,
+						struct sipmsg *msg,
+						struct transaction *trans)
+{
+	struct sipe_backend_search_token *token = trans->payload->data;
+
+	/* valid response? */
+	if (msg->response != 200) {
+		SIPE_DEBUG_ERROR("process_search_contact_response: request failed (%d)",
+				 msg->response);
+		sipe_backend_search_failed(SIPE_CORE_PUBLIC,
+					   token,
+					   _("Contact search failed"));
+		return(FALSE);
+	}
+
+	SIPE_DEBUG_INFO("process_search_contact_response: body:\n%s", msg->body ? msg->body : "");
+
+	/* large directories can return many rows */
+	sipe_xml_parse_async(sipe_private,
+			     msg->body,
+			     msg->bodylen,
+			     search_contact_response_parsed,
+			     NULL,
+			     token);
 
 	return(TRUE);
 }
@@ -1772,6 +1936,8 @@ static void photo_response_data_free(struct photo_response_data *data)
 {
 	g_free(data->who);
 	g_free(data->photo_hash);
+	if (data->photo)
+		g_byte_array_free(data->photo, TRUE);
 	if (data->request) {
 		sipe_http_request_cancel(data->request);
 	}
@@ -1779,42 +1945,56 @@ static void photo_response_data_free(struct photo_response_data *data)
 }
 
 static void photo_response_data_remove(struct sipe_core_private *sipe_private,
-				       struct photo_response_data *data)
+				       struct photo_response_data *data,
+				       gboolean fetched)
 {
 	data->request = NULL;
 	sipe_private->buddies->pending_photo_requests =
 		g_slist_remove(sipe_private->buddies->pending_photo_requests, data);
+	buddy_photo_done(sipe_private, data->who, fetched);
 	photo_response_data_free(data);
 }
 
+static gboolean process_buddy_photo_data(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private,
+					 SIPE_UNUSED_PARAMETER GSList *headers,
+					 const gchar *data,
+					 gsize length,
+					 gpointer callback_data)
+{
+	struct photo_response_data *rdata = callback_data;
+
+	/* Content-Length is controlled by the server: don't pre-allocate */
+	if (!rdata->photo)
+		rdata->photo = g_byte_array_new();
+	g_byte_array_append(rdata->photo, (const guint8 *) data, length);
+
+	return(TRUE);
+}
+
 static void process_buddy_photo_response(struct sipe_core_private *sipe_private,
 					 guint status,
-					 GSList *headers,
-					 const char *body,
+					 SIPE_UNUSED_PARAMETER GSList *headers,
+					 SIPE_UNUSED_PARAMETER const char *body,
 					 gpointer data)
 {
 	struct photo_response_data *rdata = (struct photo_response_data *) data;
 
-	if (status == SIPE_HTTP_STATUS_OK) {
-		const gchar *len_str = sipe_utils_nameval_find(headers,
-							       "Content-Length");
-		if (len_str) {
-			gsize photo_size = atoi(len_str);
-			gpointer photo = g_new(char, photo_size);
-
-			if (photo) {
-				memcpy(photo, body, photo_size);
-
-				sipe_backend_buddy_set_photo(SIPE_CORE_PUBLIC,
-							     rdata->who,
-							     photo,
-							     photo_size,
-							     rdata->photo_hash);
-			}
-		}
+	/* body has been streamed to rdata->photo */
+	if ((status == SIPE_HTTP_STATUS_OK) && rdata->photo && rdata->photo->len) {
+		gsize photo_size = rdata->photo->len;
+
+		/* backend frees "photo" */
+		sipe_backend_buddy_set_photo(SIPE_CORE_PUBLIC,
+					     rdata->who,
+					     g_byte_array_free(rdata->photo, FALSE),
+					     photo_size,
+					     rdata->photo_hash);
+		rdata->photo = NULL;
 	}
 
-	photo_response_data_remove(sipe_private, rdata);
+	photo_response_data_remove(sipe_private,
+				   rdata,
+				   status == SIPE_HTTP_STATUS_OK);
 }
 
 static void process_get_user_photo_response(struct sipe_core_private *sipe_private,
@@ -1861,7 +2041,9 @@ static void process_get_user_photo_response(struct sipe_core_private *sipe_priva
 		sipe_xml_free(xml);
 	}
 
-	photo_response_data_remove(sipe_private, rdata);
+	photo_response_data_remove(sipe_private,
+				   rdata,
+				   status == SIPE_HTTP_STATUS_OK);
 }
 
 static gchar *create_x_ms_webticket_header(const gchar *wsse_security)
@@ -1942,14 +2124,15 @@ static void photo_response_data_finalize(struct sipe_core_private *sipe_private,
 		sipe_http_request_ready(data->request);
 	} else {
 		photo_response_data_free(data);
+		buddy_photo_done(sipe_private, uri, FALSE);
 	}
 }
 
-void sipe_buddy_update_photo(struct sipe_core_private *sipe_private,
-			     const gchar *uri,
-			     const gchar *photo_hash,
-			     const gchar *photo_url,
-			     const gchar *headers)
+static void buddy_update_photo(struct sipe_core_private *sipe_private,
+			       const gchar *uri,
+			       const gchar *photo_hash,
+			       const gchar *photo_url,
+			       const gchar *headers)
 {
 	const gchar *photo_hash_old =
 		sipe_backend_buddy_get_photo_hash(SIPE_CORE_PUBLIC, uri);
@@ -1957,7 +2140,7 @@ void sipe_buddy_update_photo(struct sipe_core_private *sipe_private,
 	if (!sipe_strequal(photo_hash, photo_hash_old)) {
 		struct photo_response_data *data = g_new0(struct photo_response_data, 1);
 
-		SIPE_DEBUG_INFO("sipe_buddy_update_photo: who '%s' url '%s' hash '%s'",
+		SIPE_DEBUG_INFO("buddy_update_photo: who '%s' url '%s' hash '%s'",
 				uri, photo_url, photo_hash);
 
 		/* Photo URL is embedded XML? */
@@ -1988,12 +2171,18 @@ void sipe_buddy_update_photo(struct sipe_core_private *sipe_private,
 							      headers,
 							      process_buddy_photo_response,
 							      data);
+			if (data->request)
+				sipe_http_request_stream(data->request,
+							 process_buddy_photo_data);
 		}
 
 		photo_response_data_finalize(sipe_private,
 					     data,
 					     uri,
 					     photo_hash);
+	} else {
+		/* photo hasn't changed */
+		buddy_photo_done(sipe_private, uri, TRUE);
 	}
 }
 
@@ -2041,14 +2230,17 @@ static void get_photo_ab_entry_response(struct sipe_core_private *sipe_private,
 				sipe_private->addressbook_uri, photo_rel_path);
 		gchar *x_ms_webticket_header = create_x_ms_webticket_header(mdd->wsse_security);
 
-		sipe_buddy_update_photo(sipe_private,
-					mdd->other,
-					photo_hash,
-					photo_url,
-					x_ms_webticket_header);
+		buddy_update_photo(sipe_private,
+				   mdd->other,
+				   photo_hash,
+				   photo_url,
+				   x_ms_webticket_header);
 
 		g_free(x_ms_webticket_header);
 		g_free(photo_url);
+	} else {
+		/* no photo to fetch */
+		buddy_photo_done(sipe_private, mdd->other, soap_body != NULL);
 	}
 
 	g_free(photo_rel_path);
@@ -2056,14 +2248,16 @@ static void get_photo_ab_entry_response(struct sipe_core_private *sipe_private,
 	ms_dlx_free(mdd);
 }
 
-static void get_photo_ab_entry_failed(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private,
+static void get_photo_ab_entry_failed(struct sipe_core_private *sipe_private,
 				      struct ms_dlx_data *mdd)
 {
+	buddy_photo_done(sipe_private, mdd->other, FALSE);
 	ms_dlx_free(mdd);
 }
 
-static void buddy_fetch_photo(struct sipe_core_private *sipe_private,
-			      const gchar *uri)
+/* TRUE if a fetch has been started */
+static gboolean buddy_fetch_photo(struct sipe_core_private *sipe_private,
+				  const gchar *uri)
 {
         if (sipe_backend_uses_photo()) {
 
@@ -2081,6 +2275,7 @@ static void buddy_fetch_photo(struct sipe_core_private *sipe_private,
 						     uri,
 						     /* there is no hash */
 						     NULL);
+			return(TRUE);
 
 		/* Lync 2010: use [MS-DLX] */
 		} else if (sipe_private->dlx_uri         &&
@@ -2095,15 +2290,220 @@ static void buddy_fetch_photo(struct sipe_core_private *sipe_private,
 			mdd->session         = sipe_svc_session_start();
 
 			ms_dlx_webticket_request(sipe_private, mdd);
+			return(TRUE);
 		}
 	}
+
+	return(FALSE);
+}
+
+/*
+ * Photo fetch scheduler
+ *
+ * Fetching the photos of all buddies at once would flood the HTTP
+ * connections which are shared with UCS and EWS. Photos are therefore
+ * fetched one after the other with a limited number of fetches in flight.
+ * Photos of online buddies are fetched first.
+ *
+ * A photo that has been fetched is not fetched again for a day. Changes
+ * of the photo hash in presence updates are queued with priority. If the
+ * update arrives while a fetch for the same buddy is active, the photo is
+ * fetched again after the active fetch has been completed.
+ */
+#define BUDDY_PHOTO_MAX_ACTIVE      2
+#define BUDDY_PHOTO_REFRESH_PERIOD  (24 * 60 * 60) /* seconds */
+#define BUDDY_PHOTO_ACTION          "<+buddy-photo>"
+
+static void buddy_photo_fetch_free(struct buddy_photo_fetch *fetch)
+{
+	g_free(fetch->headers);
+	g_free(fetch->photo_url);
+	g_free(fetch->photo_hash);
+	g_free(fetch);
+}
+
+static void buddy_photo_next(struct sipe_core_private *sipe_private,
+			     SIPE_UNUSED_PARAMETER gpointer unused)
+{
+	struct sipe_buddies *buddies = sipe_private->buddies;
+
+	while (buddies->photo_active < BUDDY_PHOTO_MAX_ACTIVE) {
+		gchar *uri = g_queue_pop_head(buddies->photo_queue);
+		struct buddy_photo_fetch *fetch;
+
+		if (!uri)
+			break;
+
+		/* buddy could have been removed in the meantime */
+		if (!g_hash_table_lookup(buddies->uri, uri)) {
+			g_hash_table_remove(buddies->photo_pending, uri);
+			continue;
+		}
+
+		SIPE_DEBUG_INFO("buddy_photo_next: fetching photo for '%s' (%d queued)",
+				uri, g_queue_get_length(buddies->photo_queue));
+
+		/* mark fetch as active */
+		fetch = g_hash_table_lookup(buddies->photo_pending, uri);
+		fetch->active = TRUE;
+		buddies->photo_active++;
+
+		/* NOTE: uri is invalid after the fetch has been completed */
+		if (fetch->photo_url) {
+			/* photo location is known from presence */
+			gchar *photo_hash = fetch->photo_hash;
+			gchar *photo_url  = fetch->photo_url;
+			gchar *headers    = fetch->headers;
+
+			fetch->photo_hash = NULL;
+			fetch->photo_url  = NULL;
+			fetch->headers    = NULL;
+			buddy_update_photo(sipe_private,
+					   uri,
+					   photo_hash,
+					   photo_url,
+					   headers);
+			g_free(headers);
+			g_free(photo_url);
+			g_free(photo_hash);
+		} else if (!buddy_fetch_photo(sipe_private, uri)) {
+			/* nothing fetched: can be tried again later */
+			buddy_photo_done(sipe_private, uri, FALSE);
+		}
+	}
+}
+
+/*
+ * Next fetch is started from a scheduled action. This allows queueing of
+ * all buddies before the first fetch and doesn't start new fetches while
+ * the connection is being torn down.
+ */
+static void buddy_photo_schedule(struct sipe_core_private *sipe_private)
+{
+	sipe_schedule_mseconds(sipe_private,
+			       BUDDY_PHOTO_ACTION,
+			       NULL,
+			       0,
+			       buddy_photo_next,
+			       NULL);
+}
+
+/* fetched: photo is up-to-date, otherwise the fetch can be retried */
+static void buddy_photo_done(struct sipe_core_private *sipe_private,
+			     const gchar *uri,
+			     gboolean fetched)
+{
+	struct sipe_buddies *buddies = sipe_private->buddies;
+	struct buddy_photo_fetch *fetch;
+	gchar *key;
+
+	if (uri && fetched)
+		g_hash_table_replace(buddies->photo_fetched,
+				     g_strdup(uri),
+				     GSIZE_TO_POINTER((gsize) time(NULL)));
+
+	if (!uri ||
+	    !g_hash_table_lookup_extended(buddies->photo_pending,
+					  uri,
+					  (gpointer *) &key,
+					  (gpointer *) &fetch) ||
+	    !fetch->active)
+		return;
+
+	buddies->photo_active--;
+	if (fetch->photo_url) {
+		/* presence update arrived during fetch: fetch again */
+		fetch->active = FALSE;
+		g_queue_push_head(buddies->photo_queue, key);
+	} else {
+		g_hash_table_remove(buddies->photo_pending, uri);
+	}
+	buddy_photo_schedule(sipe_private);
+}
+
+static void buddy_photo_queue(struct sipe_core_private *sipe_private,
+			      const gchar *uri,
+			      gboolean priority)
+{
+	struct sipe_buddies *buddies = sipe_private->buddies;
+	gpointer fetched;
+	gchar *key;
+
+	/* fetch already queued or active */
+	if (g_hash_table_lookup_extended(buddies->photo_pending, uri, NULL, NULL))
+		return;
+
+	/* fetched recently */
+	fetched = g_hash_table_lookup(buddies->photo_fetched, uri);
+	if (fetched &&
+	    ((gsize) time(NULL) < GPOINTER_TO_SIZE(fetched) + BUDDY_PHOTO_REFRESH_PERIOD))
+		return;
+
+	key = g_strdup(uri);
+	g_hash_table_insert(buddies->photo_pending,
+			    key,
+			    g_new0(struct buddy_photo_fetch, 1));
+	if (priority)
+		g_queue_push_head(buddies->photo_queue, key);
+	else
+		g_queue_push_tail(buddies->photo_queue, key);
+
+	buddy_photo_schedule(sipe_private);
+}
+
+void sipe_buddy_update_photo(struct sipe_core_private *sipe_private,
+			     const gchar *uri,
+			     const gchar *photo_hash,
+			     const gchar *photo_url,
+			     const gchar *headers)
+{
+	struct sipe_buddies *buddies = sipe_private->buddies;
+	struct buddy_photo_fetch *fetch;
+	gchar *key;
+
+	/* photo hasn't changed */
+	if (sipe_strequal(photo_hash,
+			  sipe_backend_buddy_get_photo_hash(SIPE_CORE_PUBLIC,
+							    uri)))
+		return;
+
+	if (g_hash_table_lookup_extended(buddies->photo_pending,
+					 uri,
+					 (gpointer *) &key,
+					 (gpointer *) &fetch)) {
+		/* queued fetch moves to the front, active fetch is repeated */
+		if (!fetch->active) {
+			g_queue_remove(buddies->photo_queue, key);
+			g_queue_push_head(buddies->photo_queue, key);
+		}
+		g_free(fetch->headers);
+		g_free(fetch->photo_url);
+		g_free(fetch->photo_hash);
+	} else {
+		key   = g_strdup(uri);
+		fetch = g_new0(struct buddy_photo_fetch, 1);
+		g_hash_table_insert(buddies->photo_pending, key, fetch);
+		g_queue_push_head(buddies->photo_queue, key);
+	}
+
+	fetch->photo_hash = g_strdup(photo_hash);
+	fetch->photo_url  = g_strdup(photo_url);
+	fetch->headers    = g_strdup(headers);
+
+	buddy_photo_schedule(sipe_private);
 }
 
 static void buddy_refresh_photos_cb(gpointer uri,
 				    SIPE_UNUSED_PARAMETER gpointer value,
-				    gpointer sipe_private)
+				    gpointer data)
 {
-	buddy_fetch_photo(sipe_private, uri);
+	struct sipe_core_private *sipe_private = data;
+	guint status = sipe_backend_buddy_get_status(SIPE_CORE_PUBLIC, uri);
+
+	buddy_photo_queue(sipe_private,
+			  uri,
+			  (status != SIPE_ACTIVITY_UNSET) &&
+			  (status != SIPE_ACTIVITY_OFFLINE));
 }
 
 void sipe_buddy_refresh_photos(struct sipe_core_private *sipe_private)
@@ -2111,6 +2511,31 @@ void sipe_buddy_refresh_photos(struct sipe_core_private *sipe_private)
 	g_hash_table_foreach(sipe_private->buddies->uri,
 			     buddy_refresh_photos_cb,
 			     sipe_private);
+
+	/* resume fetches queued before a connection cleanup */
+	if (!g_queue_is_empty(sipe_private->buddies->photo_queue))
+		buddy_photo_schedule(sipe_private);
+}
+
+static void buddy_suspend_photos_cb(gpointer uri,
+				    struct buddy_photo_fetch *fetch,
+				    struct sipe_buddies *buddies)
+{
+	if (fetch->active) {
+		fetch->active = FALSE;
+		g_queue_push_head(buddies->photo_queue, uri);
+	}
+}
+
+void sipe_buddy_suspend_photos(struct sipe_core_private *sipe_private)
+{
+	struct sipe_buddies *buddies = sipe_private->buddies;
+
+	/* scheduled action has been cancelled */
+	g_hash_table_foreach(buddies->photo_pending,
+			     (GHFunc) buddy_suspend_photos_cb,
+			     buddies);
+	buddies->photo_active = 0;
 }
 
 /* Buddy menu callbacks*/
@@ -2443,6 +2868,15 @@ void sipe_buddy_init(struct sipe_core_private *sipe_private)
 						 (GEqualFunc) sipe_ht_equals_nick);
 	buddies->exchange_key = g_hash_table_new(g_str_hash,
 						 g_str_equal);
+	buddies->photo_queue   = g_queue_new();
+	buddies->photo_pending = g_hash_table_new_full((GHashFunc)  sipe_ht_hash_nick,
+						       (GEqualFunc) sipe_ht_equals_nick,
+						       g_free,
+						       (GDestroyNotify) buddy_photo_fetch_free);
+	buddies->photo_fetched = g_hash_table_new_full((GHashFunc)  sipe_ht_hash_nick,
+						       (GEqualFunc) sipe_ht_equals_nick,
+						       g_free,
+						       NULL);
 	sipe_private->buddies = buddies;
 }
 
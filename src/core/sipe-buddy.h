@@ -26,13 +26,17 @@ struct sipe_cal_working_hours;
 struct sipe_core_private;
 struct sipe_group;
 
+/* properties handled by sipe_buddy_update_property() */
+#define SIPE_BUDDY_PROPERTIES (SIPE_BUDDY_INFO_CUSTOM1_PHONE_DISPLAY + 1)
+
 struct sipe_buddy {
 	gchar *name;
 	gchar *exchange_key;
 	gchar *change_key;
-	gchar *activity;
+	/* pooled strings, see sipe_utils_intern() */
+	const gchar *activity;
 	gchar *meeting_subject;
-	gchar *meeting_location;
+	const gchar *meeting_location;
 	/* Sipe internal format for Note is HTML.
 	 * All incoming plain text should be html-escaped
 	 * for example by g_markup_escape_text()
@@ -53,11 +57,13 @@ struct sipe_buddy {
 	time_t user_avail_since;
 	time_t activity_since;
 	const char *last_non_cal_status_id;
-	gchar *last_non_cal_activity;
+	const gchar *last_non_cal_activity; /* pooled */
 
 	struct sipe_cal_working_hours *cal_working_hours;
 
-	gchar *device_name;
+	const gchar *device_name; /* pooled */
+	/* last property values pushed to the backend buddies (pooled) */
+	const gchar *properties[SIPE_BUDDY_PROPERTIES];
 	GSList *groups;
 	 /** flag to control sending 'context' element in 2007 subscriptions */
 	gboolean just_added;
@@ -229,6 +235,7 @@ void sipe_buddy_update_property(struct sipe_core_private *sipe_private,
 /**
  * Update the buddy photo with given SIP URI. If hash is the same
  * as the cached one then the fetching of the photo is skipped.
+ * Otherwise the fetch is queued in front of the photo fetch scheduler.
  *
  * @param sipe_private SIPE core data
  * @param uri          a SIP URI
@@ -249,6 +256,14 @@ void sipe_buddy_update_photo(struct sipe_core_private *sipe_private,
  */
 void sipe_buddy_refresh_photos(struct sipe_core_private *sipe_private);
 
+/**
+ * Stop photo fetches when the connection is cleaned up. Active fetches
+ * are queued again and resumed by sipe_buddy_refresh_photos().
+ *
+ * @param sipe_private SIPE core data
+ */
+void sipe_buddy_suspend_photos(struct sipe_core_private *sipe_private);
+
 /**
  * Finalize the search results and display results to user.
  *
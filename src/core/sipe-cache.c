@@ -0,0 +1,348 @@
+/**
+ * @file sipe-cache.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * On-disk format is a GKeyFile per section:
+ *
+ *   [entry0]
+ *   key=<key>
+ *   value=<value>
+ *   expires=<seconds since epoch>
+ *
+ * Keys are not used as group names because they can contain characters,
+ * e.g. "[" in URLs, which are invalid in a GKeyFile group name.
+ */
+
+#include <time.h>
+
+#include <glib.h>
+
+#include "sipe-common.h"
+#include "sipe-backend.h"
+#include "sipe-cache.h"
+#include "sipe-core.h"
+#include "sipe-core-private.h"
+#include "sipe-schedule.h"
+
+/* delay write-back so that a burst of updates only causes one write */
+#define SIPE_CACHE_FLUSH_DELAY 10 /* seconds */
+
+struct sipe_cache {
+	GHashTable *sections; /* name -> struct cache_section */
+};
+
+struct cache_section {
+	gchar *name;
+	GHashTable *entries;  /* key -> struct cache_entry */
+	gboolean dirty;
+};
+
+struct cache_entry {
+	gchar *value;
+	time_t expires;
+};
+
+static void cache_entry_free(gpointer data)
+{
+	struct cache_entry *entry = data;
+	g_free(entry->value);
+	g_free(entry);
+}
+
+static void cache_section_free(gpointer data)
+{
+	struct cache_section *section = data;
+	g_hash_table_destroy(section->entries);
+	g_free(section->name);
+	g_free(section);
+}
+
+static gchar *cache_section_filename(struct sipe_core_private *sipe_private,
+				     const gchar *name)
+{
+	const gchar *dir = sipe_backend_cache_dir(SIPE_CORE_PUBLIC);
+	gchar *filename = NULL;
+
+	if (dir) {
+		gchar *basename = g_strdup_printf("%s.cache", name);
+		filename = g_build_filename(dir, basename, NULL);
+		g_free(basename);
+	}
+
+	return(filename);
+}
+
+static void cache_section_load(struct sipe_core_private *sipe_private,
+			       struct cache_section *section)
+{
+	gchar *filename = cache_section_filename(sipe_private, section->name);
+
+	if (filename) {
+		GKeyFile *keyfile = g_key_file_new();
+
+		if (g_key_file_load_from_file(keyfile,
+					      filename,
+					      G_KEY_FILE_NONE,
+					      NULL)) {
+			gchar **groups = g_key_file_get_groups(keyfile, NULL);
+			time_t now = time(NULL);
+			guint count = 0;
+			gchar **group;
+
+			for (group = groups; *group; group++) {
+				gchar *key     = g_key_file_get_string(keyfile,
+								       *group,
+								       "key",
+								       NULL);
+				gchar *value   = g_key_file_get_string(keyfile,
+								       *group,
+								       "value",
+								       NULL);
+				gchar *expires = g_key_file_get_value(keyfile,
+								      *group,
+								      "expires",
+								      NULL);
+
+				if (key && value && expires) {
+					time_t timeout = g_ascii_strtoull(expires,
+									  NULL,
+									  10);
+
+					/* drop expired entries */
+					if (timeout > now) {
+						struct cache_entry *entry = g_new0(struct cache_entry, 1);
+						entry->value   = value;
+						entry->expires = timeout;
+						g_hash_table_insert(section->entries,
+								    key,
+								    entry);
+						key   = NULL;
+						value = NULL;
+						count++;
+					}
+				}
+
+				g_free(expires);
+				g_free(value);
+				g_free(key);
+			}
+			g_strfreev(groups);
+
+			SIPE_DEBUG_INFO("cache_section_load: %d entries from '%s'",
+					count, filename);
+		}
+
+		g_key_file_free(keyfile);
+		g_free(filename);
+	}
+}
+
+struct cache_save_data {
+	GKeyFile *keyfile;
+	time_t now;
+	guint count;
+};
+
+static void cache_entry_save(gpointer key,
+			     gpointer value,
+			     gpointer user_data)
+{
+	struct cache_entry *entry   = value;
+	struct cache_save_data *csd = user_data;
+
+	if (entry->expires > csd->now) {
+		gchar *group   = g_strdup_printf("entry%d", csd->count++);
+		gchar *expires = g_strdup_printf("%" G_GUINT64_FORMAT,
+						 (guint64) entry->expires);
+
+		g_key_file_set_string(csd->keyfile, group, "key", key);
+		g_key_file_set_string(csd->keyfile, group, "value", entry->value);
+		g_key_file_set_value(csd->keyfile, group, "expires", expires);
+
+		g_free(expires);
+		g_free(group);
+	}
+}
+
+static void cache_section_save(struct sipe_core_private *sipe_private,
+			       struct cache_section *section)
+{
+	gchar *filename = cache_section_filename(sipe_private, section->name);
+
+	section->dirty = FALSE;
+
+	if (filename) {
+		struct cache_save_data csd;
+		gchar *data;
+		gsize length;
+
+		csd.keyfile = g_key_file_new();
+		csd.now     = time(NULL);
+		csd.count   = 0;
+		g_hash_table_foreach(section->entries,
+				     cache_entry_save,
+				     &csd);
+
+		data = g_key_file_to_data(csd.keyfile, &length, NULL);
+		if (!(data && g_file_set_contents(filename, data, length, NULL)))
+			SIPE_DEBUG_ERROR("cache_section_save: failed to write '%s'",
+					 filename);
+		else
+			SIPE_DEBUG_INFO("cache_section_save: %d entries to '%s'",
+					csd.count, filename);
+
+		g_free(data);
+		g_key_file_free(csd.keyfile);
+		g_free(filename);
+	}
+}
+
+static void cache_section_flush(SIPE_UNUSED_PARAMETER gpointer key,
+				gpointer value,
+				gpointer user_data)
+{
+	struct cache_section *section = value;
+
+	if (section->dirty)
+		cache_section_save(user_data, section);
+}
+
+static void cache_flush(struct sipe_core_private *sipe_private,
+			SIPE_UNUSED_PARAMETER gpointer unused)
+{
+	struct sipe_cache *cache = sipe_private->cache;
+
+	if (cache)
+		g_hash_table_foreach(cache->sections,
+				     cache_section_flush,
+				     sipe_private);
+}
+
+static struct cache_section *cache_section(struct sipe_core_private *sipe_private,
+					   const gchar *name)
+{
+	struct sipe_cache *cache = sipe_private->cache;
+	struct cache_section *section;
+
+	if (!cache) {
+		sipe_private->cache = cache = g_new0(struct sipe_cache, 1);
+		cache->sections = g_hash_table_new_full(g_str_hash,
+							g_str_equal,
+							NULL,
+							cache_section_free);
+	}
+
+	section = g_hash_table_lookup(cache->sections, name);
+	if (!section) {
+		section = g_new0(struct cache_section, 1);
+		section->name    = g_strdup(name);
+		section->entries = g_hash_table_new_full(g_str_hash,
+							 g_str_equal,
+							 g_free,
+							 cache_entry_free);
+		g_hash_table_insert(cache->sections, section->name, section);
+
+		cache_section_load(sipe_private, section);
+	}
+
+	return(section);
+}
+
+static void cache_section_modified(struct sipe_core_private *sipe_private,
+				   struct cache_section *section)
+{
+	section->dirty = TRUE;
+	sipe_schedule_seconds(sipe_private,
+			      "<+cache-flush>",
+			      NULL,
+			      SIPE_CACHE_FLUSH_DELAY,
+			      cache_flush,
+			      NULL);
+}
+
+const gchar *sipe_cache_get(struct sipe_core_private *sipe_private,
+			    const gchar *section,
+			    const gchar *key)
+{
+	struct cache_section *data = cache_section(sipe_private, section);
+	struct cache_entry *entry  = g_hash_table_lookup(data->entries, key);
+
+	if (!entry)
+		return(NULL);
+
+	if (entry->expires <= time(NULL)) {
+		SIPE_DEBUG_INFO("sipe_cache_get: '%s' entry '%s' expired",
+				section, key);
+		g_hash_table_remove(data->entries, key);
+		cache_section_modified(sipe_private, data);
+		return(NULL);
+	}
+
+	return(entry->value);
+}
+
+void sipe_cache_set(struct sipe_core_private *sipe_private,
+		    const gchar *section,
+		    const gchar *key,
+		    const gchar *value,
+		    guint lifetime)
+{
+	struct cache_section *data = cache_section(sipe_private, section);
+	struct cache_entry *entry  = g_new0(struct cache_entry, 1);
+
+	entry->value   = g_strdup(value);
+	entry->expires = time(NULL) + lifetime;
+	g_hash_table_replace(data->entries, g_strdup(key), entry);
+	cache_section_modified(sipe_private, data);
+}
+
+void sipe_cache_remove(struct sipe_core_private *sipe_private,
+		       const gchar *section,
+		       const gchar *key)
+{
+	struct cache_section *data = cache_section(sipe_private, section);
+
+	if (g_hash_table_remove(data->entries, key))
+		cache_section_modified(sipe_private, data);
+}
+
+void sipe_cache_free(struct sipe_core_private *sipe_private)
+{
+	struct sipe_cache *cache = sipe_private->cache;
+
+	if (cache) {
+		sipe_schedule_cancel(sipe_private, "<+cache-flush>");
+		cache_flush(sipe_private, NULL);
+		g_hash_table_destroy(cache->sections);
+		g_free(cache);
+		sipe_private->cache = NULL;
+	}
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
@@ -0,0 +1,89 @@
+/**
+ * @file sipe-cache.h
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Persistent cache
+ *
+ * Entries are grouped into sections, e.g. "dns". A section is loaded from
+ * the backend cache directory on first access and written back shortly
+ * after it has been modified. If the backend doesn't provide a cache
+ * directory then entries only live as long as the core instance.
+ */
+
+/* Forward declarations */
+struct sipe_core_private;
+
+/**
+ * Look up cache entry
+ *
+ * @param sipe_private SIPE core private data
+ * @param section      cache section name
+ * @param key          entry key
+ *
+ * @return value or @c NULL if there is no valid entry. Owned by the cache.
+ */
+const gchar *sipe_cache_get(struct sipe_core_private *sipe_private,
+			    const gchar *section,
+			    const gchar *key);
+
+/**
+ * Add or replace cache entry
+ *
+ * @param sipe_private SIPE core private data
+ * @param section      cache section name
+ * @param key          entry key
+ * @param value        entry value (will be copied)
+ * @param lifetime     entry lifetime in seconds
+ */
+void sipe_cache_set(struct sipe_core_private *sipe_private,
+		    const gchar *section,
+		    const gchar *key,
+		    const gchar *value,
+		    guint lifetime);
+
+/**
+ * Remove cache entry
+ *
+ * @param sipe_private SIPE core private data
+ * @param section      cache section name
+ * @param key          entry key
+ */
+void sipe_cache_remove(struct sipe_core_private *sipe_private,
+		       const gchar *section,
+		       const gchar *key);
+
+/**
+ * Write modified sections and free cache data
+ *
+ * @param sipe_private SIPE core private data
+ */
+void sipe_cache_free(struct sipe_core_private *sipe_private);
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
@@ -185,6 +185,9 @@ sipe_cal_calendar_free(struct sipe_calendar *cal)
 
 		if (cal->request)
 			sipe_http_request_cancel(cal->request);
+		if (cal->oof_request)
+			sipe_http_request_cancel(cal->oof_request);
+		g_free(cal->fingerprint);
 		sipe_http_session_close(cal->session);
 
 		g_free(cal);
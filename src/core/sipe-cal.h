@@ -78,6 +78,10 @@ struct sipe_calendar {
 
 	struct sipe_http_session *session;
 	struct sipe_http_request *request;
+	struct sipe_http_request *oof_request;
+
+	/* last published calendar data */
+	gchar *fingerprint;
 
 	time_t fb_start;
 	/* hex form */
@@ -1265,6 +1265,119 @@ process_conference_appshare_endpoint(struct sipe_core_private *sipe_private,
 
 #endif // HAVE_VV
 
+/*
+ * Conference roster
+ *
+ * Core-side copy of the chat membership, so that conference-info
+ * notifications can be applied as a diff. Changes are collected while
+ * the notification is processed and handed to the backend in one go.
+ */
+#define CONF_ROSTER_IN_CHAT  0x01
+#define CONF_ROSTER_OPERATOR 0x02
+
+struct conf_roster_update {
+	GHashTable *roster;   /* user URI -> flags */
+	GHashTable *listed;   /* users in full state notification */
+	const gchar *self;
+	GSList *added;        /* gchar * */
+	GSList *removed;      /* gchar * */
+	GSList *operators;    /* gchar * */
+	gboolean self_added;
+};
+
+static GHashTable *
+conf_roster(struct sip_session *session, gboolean reset)
+{
+	if (!session->conf_roster)
+		session->conf_roster = g_hash_table_new_full(sipe_strcase_hash,
+							     (GEqualFunc) sipe_strcase_equal,
+							     g_free,
+							     NULL);
+	else if (reset)
+		g_hash_table_remove_all(session->conf_roster);
+
+	return(session->conf_roster);
+}
+
+static void
+conf_roster_user(struct conf_roster_update *update,
+		 const gchar *uri,
+		 guint flags)
+{
+	guint old_flags = GPOINTER_TO_UINT(g_hash_table_lookup(update->roster,
+							       uri));
+
+	if (flags & CONF_ROSTER_IN_CHAT) {
+		if (!(old_flags & CONF_ROSTER_IN_CHAT)) {
+			if (sipe_strcase_equal(uri, update->self))
+				update->self_added = TRUE;
+			else
+				update->added = g_slist_prepend(update->added,
+								g_strdup(uri));
+			/* new chat user: operator flag must be set again */
+			old_flags &= ~CONF_ROSTER_OPERATOR;
+		}
+		if ((flags & CONF_ROSTER_OPERATOR) &&
+		    !(old_flags & CONF_ROSTER_OPERATOR))
+			update->operators = g_slist_prepend(update->operators,
+							    g_strdup(uri));
+	} else if (old_flags & CONF_ROSTER_IN_CHAT) {
+		update->removed = g_slist_prepend(update->removed,
+						  g_strdup(uri));
+	}
+
+	/* operator role only counts while user is in the chat */
+	if (!(flags & CONF_ROSTER_IN_CHAT))
+		flags = 0;
+
+	if (flags)
+		g_hash_table_replace(update->roster,
+				     g_strdup(uri),
+				     GUINT_TO_POINTER(flags));
+	else
+		g_hash_table_remove(update->roster, uri);
+}
+
+static gboolean
+conf_roster_unlisted(gpointer key,
+		     SIPE_UNUSED_PARAMETER gpointer value,
+		     gpointer user_data)
+{
+	struct conf_roster_update *update = user_data;
+
+	if (g_hash_table_lookup(update->listed, key))
+		return(FALSE);
+
+	update->removed = g_slist_prepend(update->removed, g_strdup(key));
+	return(TRUE);
+}
+
+static void
+conf_roster_apply(struct sip_session *session,
+		  struct conf_roster_update *update,
+		  gboolean just_joined)
+{
+	struct sipe_backend_chat_session *backend = session->chat_session->backend;
+	GSList *entry;
+
+	if (update->removed) {
+		sipe_backend_chat_remove_users(backend, update->removed);
+		sipe_utils_slist_free_full(update->removed, g_free);
+	}
+
+	if (update->self_added)
+		sipe_backend_chat_add(backend, update->self, FALSE);
+	if (update->added) {
+		update->added = g_slist_reverse(update->added);
+		sipe_backend_chat_add_users(backend, update->added, !just_joined);
+		sipe_utils_slist_free_full(update->added, g_free);
+	}
+
+	for (entry = update->operators; entry; entry = entry->next)
+		sipe_backend_chat_operator(backend, entry->data);
+	sipe_utils_slist_free_full(update->operators, g_free);
+}
+
 void
 sipe_process_conference(struct sipe_core_private *sipe_private,
 			struct sipmsg *msg)
@@ -1274,6 +1387,8 @@ sipe_process_conference(struct sipe_core_private *sipe_private,
 	const sipe_xml *xn_subject;
 	const gchar *focus_uri;
 	struct sip_session *session;
+	struct conf_roster_update roster_update;
+	gchar *self;
 	gboolean just_joined = FALSE;
 #ifdef HAVE_VV
 	gboolean audio_was_added = FALSE;
@@ -1361,46 +1476,81 @@ sipe_process_conference(struct sipe_core_private *sipe_private,
 	}
 
 	/* users */
+	self = sip_uri_self(sipe_private);
+	roster_update.roster = conf_roster(session, just_joined);
+	roster_update.self = self;
+	roster_update.added = NULL;
+	roster_update.removed = NULL;
+	roster_update.operators = NULL;
+	roster_update.self_added = FALSE;
+	/* RFC 4575: default state is "full" */
+	if (sipe_xml_child(xn_conference_info, "users") &&
+	    !sipe_strequal(sipe_xml_attribute(xn_conference_info, "state"), "partial"))
+		roster_update.listed = g_hash_table_new(sipe_strcase_hash,
+							(GEqualFunc) sipe_strcase_equal);
+	else
+		roster_update.listed = NULL;
+
 	for (node = sipe_xml_child(xn_conference_info, "users/user"); node; node = sipe_xml_twin(node)) {
 		const gchar *user_uri = sipe_xml_attribute(node, "entity");
 		const gchar *state = sipe_xml_attribute(node, "state");
-		gchar *role = sipe_xml_data(sipe_xml_child(node, "roles/entry"));
-		gboolean is_operator = sipe_strequal(role, "presenter");
-		gboolean is_in_im_mcu = FALSE;
-		gchar *self = sip_uri_self(sipe_private);
+		guint flags;
+
+		if (!user_uri)
+			continue;
+
+		if (roster_update.listed)
+			g_hash_table_insert(roster_update.listed,
+					    (gpointer) user_uri,
+					    (gpointer) user_uri);
 
 		if (sipe_strequal("deleted", state)) {
-			if (sipe_backend_chat_find(session->chat_session->backend, user_uri)) {
-				sipe_backend_chat_remove(session->chat_session->backend,
-							 user_uri);
-			}
+			flags = 0;
 		} else {
-			/* endpoints */
+			/* partial user state only contains the changes */
+			gboolean partial = sipe_strequal("partial", state);
+			const sipe_xml *xn_role = sipe_xml_child(node, "roles/entry");
 			const sipe_xml *endpoint;
+
+			flags = partial ?
+				GPOINTER_TO_UINT(g_hash_table_lookup(roster_update.roster,
+								     user_uri)) :
+				0;
+
+			if (xn_role) {
+				gchar *role = sipe_xml_data(xn_role);
+				if (sipe_strequal(role, "presenter"))
+					flags |= CONF_ROSTER_OPERATOR;
+				else
+					flags &= ~CONF_ROSTER_OPERATOR;
+				g_free(role);
+			} else if (!partial) {
+				flags &= ~CONF_ROSTER_OPERATOR;
+			}
+
+			/* endpoints */
 			for (endpoint = sipe_xml_child(node, "endpoint"); endpoint; endpoint = sipe_xml_twin(endpoint)) {
-				const gchar *session_type;
+				const gchar *session_type = sipe_xml_attribute(endpoint, "session-type");
 				gchar *status = sipe_xml_data(sipe_xml_child(endpoint, "status"));
 				gboolean connected = sipe_strequal("connected", status);
 				g_free(status);
 
+				if (sipe_strequal("chat", session_type)) {
+					/* a partial endpoint might not repeat its status */
+					if (connected)
+						flags |= CONF_ROSTER_IN_CHAT;
+					else if (!partial ||
+						 sipe_strequal("deleted",
+							       sipe_xml_attribute(endpoint, "state")) ||
+						 sipe_xml_child(endpoint, "status"))
+						flags &= ~CONF_ROSTER_IN_CHAT;
+				}
+
 				if (!connected)
 					continue;
 
-				session_type = sipe_xml_attribute(endpoint, "session-type");
-
-				if (sipe_strequal("chat", session_type)) {
-					is_in_im_mcu = TRUE;
-					if (!sipe_backend_chat_find(session->chat_session->backend, user_uri)) {
-						sipe_backend_chat_add(session->chat_session->backend,
-								      user_uri,
-								      !just_joined && g_ascii_strcasecmp(user_uri, self));
-					}
-					if (is_operator) {
-						sipe_backend_chat_operator(session->chat_session->backend,
-									   user_uri);
-					}
 #ifdef HAVE_VV
-				} else if (sipe_strequal("audio-video", session_type)) {
+				if (sipe_strequal("audio-video", session_type)) {
 					if (!session->is_call)
 						audio_was_added = TRUE;
 					process_conference_av_endpoint(endpoint,
@@ -1415,17 +1565,22 @@ sipe_process_conference(struct sipe_core_private *sipe_private,
 				}
 #endif
 			}
-			if (!is_in_im_mcu) {
-				if (sipe_backend_chat_find(session->chat_session->backend, user_uri)) {
-					sipe_backend_chat_remove(session->chat_session->backend,
-								 user_uri);
-				}
-			}
 		}
-		g_free(role);
-		g_free(self);
+
+		conf_roster_user(&roster_update, user_uri, flags);
 	}
 
+	/* full state: users that are no longer listed have left */
+	if (roster_update.listed) {
+		g_hash_table_foreach_remove(roster_update.roster,
+					    conf_roster_unlisted,
+					    &roster_update);
+		g_hash_table_destroy(roster_update.listed);
+	}
+
+	conf_roster_apply(session, &roster_update, just_joined);
+	g_free(self);
+
 #ifdef HAVE_VV
 	if (audio_was_added) {
 		session->is_call = TRUE;
@@ -1474,10 +1629,9 @@ sipe_process_conference(struct sipe_core_private *sipe_private,
 	if (session->im_mcu_uri) {
 		struct sip_dialog *dialog = sipe_dialog_find(session, session->im_mcu_uri);
 		if (!dialog) {
-			dialog = sipe_dialog_add(session);
+			dialog = sipe_dialog_add(session, session->im_mcu_uri);
 
 			dialog->callid = g_strdup(session->callid);
-			dialog->with = g_strdup(session->im_mcu_uri);
 
 			/* send INVITE to IM MCU */
 			sipe_im_invite(sipe_private, session, dialog->with, NULL, NULL, NULL, FALSE);
@@ -1494,6 +1648,8 @@ sipe_conf_immcu_closed(struct sipe_core_private *sipe_private,
 	sipe_user_present_info(sipe_private, session,
 			       _("You have been disconnected from this conference."));
 	sipe_backend_chat_close(session->chat_session->backend);
+	if (session->conf_roster)
+		g_hash_table_remove_all(session->conf_roster);
 }
 
 void
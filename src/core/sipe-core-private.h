@@ -26,6 +26,7 @@ struct sip_csta;
 struct sip_service_data;
 struct sip_transport;
 struct sipe_buddies;
+struct sipe_cache;
 struct sipe_calendar;
 struct sipe_certificate;
 struct sipe_ews_autodiscover;
@@ -35,6 +36,7 @@ struct sipe_http;
 struct sipe_http_request;
 struct sipe_lync_autodiscover;
 struct sipe_media_call_private;
+struct sipe_session_index;
 struct sipe_svc;
 struct sipe_ucs;
 struct sipe_webticket;
@@ -72,6 +74,7 @@ struct sipe_core_private {
 	gchar *register_callid;
 	gchar *focus_factory_uri;
 	GSList *sessions;
+	struct sipe_session_index *session_index; /* sipe-session.c */
 	GSList *sessions_to_accept;
 	/* from REGISTER response: server events
 	 *  we're allowed to subscribe to
@@ -90,6 +93,7 @@ struct sipe_core_private {
 
 	/* [MS-PRES] */
 	GSList *containers;
+	GHashTable *access_levels;  /* member key -> container bit mask */
 	GSList *our_publication_keys;
 	GHashTable *our_publications;
 	GHashTable *user_state_publications;
@@ -150,11 +154,17 @@ struct sipe_core_private {
 	/* For RCC - Remote Call Control */
 	struct sip_csta *csta;
 
-	struct sipe_dns_query *dns_query;
+	struct sipe_dns_lookup *dns_query;
 
 	/* HTTP service */
 	struct sipe_http *http;
 
+	/* Persistent cache */
+	struct sipe_cache *cache;
+
+	/* pending asynchronous XML parse jobs */
+	GSList *xml_async_jobs;
+
 	/* TLS-DSK: Certificates & Web services */
 	struct sipe_certificate *certificate;
 	struct sipe_webticket *webticket;
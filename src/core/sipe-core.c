@@ -75,6 +75,7 @@
 #include "sip-transport.h"
 #include "sipe-backend.h"
 #include "sipe-buddy.h"
+#include "sipe-cache.h"
 #include "sipe-cal.h"
 #include "sipe-certificate.h"
 #include "sipe-chat.h"
@@ -99,6 +100,8 @@
 #include "sipe-ucs.h"
 #include "sipe-utils.h"
 #include "sipe-webticket.h"
+#include "sipe-xml.h"
+#include "sipe-xml-async.h"
 
 #ifdef PACKAGE_GIT_COMMIT
 #define SIPE_CORE_VERSION PACKAGE_VERSION " (git commit " PACKAGE_GIT_COMMIT " / "
@@ -167,6 +170,7 @@ void sipe_core_init(SIPE_UNUSED_PARAMETER const char *locale_dir)
 void sipe_core_destroy(void)
 {
 	sipe_chat_destroy();
+	sipe_xml_async_shutdown();
 	sipe_status_shutdown();
 	sipe_mime_shutdown();
 	sipe_crypto_shutdown();
@@ -379,10 +383,13 @@ void sipe_core_backend_initialized(struct sipe_core_private *sipe_private,
 
 void sipe_core_connection_cleanup(struct sipe_core_private *sipe_private)
 {
+	/* parsed responses must not be delivered to freed HTTP requests */
+	sipe_xml_parse_async_abort_all(sipe_private);
 	sipe_http_free(sipe_private);
 	sip_transport_disconnect(sipe_private);
 
 	sipe_schedule_cancel_all(sipe_private);
+	sipe_buddy_suspend_photos(sipe_private);
 
 	if (sipe_private->allowed_events)
 		sipe_utils_slist_free_full(sipe_private->allowed_events, g_free);
@@ -483,6 +490,7 @@ void sipe_core_deallocate(struct sipe_core_public *sipe_public)
 	g_free(sipe_private->dlx_uri);
 	sipe_utils_slist_free_full(sipe_private->conf_mcu_types, g_free);
 	g_hash_table_destroy(sipe_private->access_numbers);
+	sipe_cache_free(sipe_private);
 	g_free(sipe_private);
 }
 
@@ -52,7 +52,7 @@ gboolean sipe_crypt_verify_rsa(gpointer public,
 			       const guchar *digest, gsize digest_length,
 			       const guchar *signature, gsize signature_length);
 
-/* Stream RC4 cipher for file transfer */
+/* Stream RC4 cipher for file transfer (in & out may be the same buffer) */
 gpointer sipe_crypt_ft_start(const guchar *key);
 void sipe_crypt_ft_stream(gpointer context,
 			  const guchar *in, gsize length,
@@ -71,13 +71,53 @@ void sipe_dialog_free(struct sip_dialog *dialog)
 	g_free(dialog);
 }
 
-struct sip_dialog *sipe_dialog_add(struct sip_session *session)
+struct sip_dialog *sipe_dialog_add(struct sip_session *session,
+				   const gchar *with)
 {
 	struct sip_dialog *dialog = g_new0(struct sip_dialog, 1);
+
+	dialog->with = g_strdup(with);
 	session->dialogs = g_slist_append(session->dialogs, dialog);
+
+	if (!session->dialogs_by_with)
+		session->dialogs_by_with = g_hash_table_new(sipe_strcase_hash,
+							    (GEqualFunc) sipe_strcase_equal);
+	/* first dialog wins, same as a search through the list */
+	if (with && !g_hash_table_lookup(session->dialogs_by_with, with))
+		g_hash_table_insert(session->dialogs_by_with,
+				    dialog->with,
+				    dialog);
+
 	return(dialog);
 }
 
+/* unlink dialog from session, caller must free it */
+static void sipe_dialog_unlink(struct sip_session *session,
+			       struct sip_dialog *dialog)
+{
+	session->dialogs = g_slist_remove(session->dialogs, dialog);
+
+	if (dialog->with &&
+	    (g_hash_table_lookup(session->dialogs_by_with,
+				 dialog->with) == dialog)) {
+		GSList *entry;
+
+		g_hash_table_remove(session->dialogs_by_with, dialog->with);
+
+		/* index next dialog with the same URI, if any */
+		for (entry = session->dialogs; entry; entry = entry->next) {
+			struct sip_dialog *next = entry->data;
+
+			if (sipe_strcase_equal(dialog->with, next->with)) {
+				g_hash_table_insert(session->dialogs_by_with,
+						    next->with,
+						    next);
+				break;
+			}
+		}
+	}
+}
+
 static struct sip_dialog *
 sipe_dialog_find_3(struct sip_session *session,
 		   struct sip_dialog *dialog_in)
@@ -108,13 +148,13 @@ sipe_dialog_find_3(struct sip_session *session,
 struct sip_dialog *sipe_dialog_find(struct sip_session *session,
 				    const gchar *who)
 {
-	if (session && who) {
-		SIPE_DIALOG_FOREACH {
-			if (dialog->with && sipe_strcase_equal(who, dialog->with)) {
-				SIPE_DEBUG_INFO("sipe_dialog_find who='%s'", who);
-				return dialog;
-			}
-		} SIPE_DIALOG_FOREACH_END;
+	if (session && who && session->dialogs_by_with) {
+		struct sip_dialog *dialog = g_hash_table_lookup(session->dialogs_by_with,
+								who);
+		if (dialog) {
+			SIPE_DEBUG_INFO("sipe_dialog_find who='%s'", who);
+			return dialog;
+		}
 	}
 	return NULL;
 }
@@ -124,7 +164,7 @@ void sipe_dialog_remove(struct sip_session *session, const gchar *who)
 	struct sip_dialog *dialog = sipe_dialog_find(session, who);
 	if (dialog) {
 		SIPE_DEBUG_INFO("sipe_dialog_remove who='%s' with='%s'", who, dialog->with ? dialog->with : "");
-		session->dialogs = g_slist_remove(session->dialogs, dialog);
+		sipe_dialog_unlink(session, dialog);
 		sipe_dialog_free(dialog);
 	}
 }
@@ -137,7 +177,7 @@ sipe_dialog_remove_3(struct sip_session *session,
 	if (dialog) {
 		SIPE_DEBUG_INFO("sipe_dialog_remove_3 with='%s'",
 				dialog->with ? dialog->with : "");
-		session->dialogs = g_slist_remove(session->dialogs, dialog);
+		sipe_dialog_unlink(session, dialog);
 		sipe_dialog_free(dialog);
 	}
 }
@@ -150,6 +190,12 @@ void sipe_dialog_remove_all(struct sip_session *session)
 		entry = g_slist_remove(entry, dialog);
 		sipe_dialog_free(dialog);
 	}
+	session->dialogs = NULL;
+
+	if (session->dialogs_by_with) {
+		g_hash_table_destroy(session->dialogs_by_with);
+		session->dialogs_by_with = NULL;
+	}
 }
 
 static void sipe_dialog_parse_routes(struct sip_dialog *dialog,
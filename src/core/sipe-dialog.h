@@ -78,10 +78,12 @@ void sipe_dialog_free(struct sip_dialog *dialog);
  * Add a new, empty dialog to a session
  *
  * @param session (in)
+ * @param with (in) dialog identifier (URI), will be copied. May be NULL
  *
  * @return dialog the new dialog structure
  */
-struct sip_dialog *sipe_dialog_add(struct sip_session *session);
+struct sip_dialog *sipe_dialog_add(struct sip_session *session,
+				   const gchar *with);
 
 /**
  * Find a dialog in a session
@@ -0,0 +1,269 @@
+/**
+ * @file sipe-dns.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Cache entry format:
+ *
+ *   SRV  key "srv:_<protocol>._<transport>.<domain>" value "<port>:<host>"
+ *   A    key "a:<hostname>"                          value "<address>"
+ *
+ * An empty value is a negative answer.
+ */
+
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "sipe-common.h"
+#include "sipe-backend.h"
+#include "sipe-cache.h"
+#include "sipe-core.h"
+#include "sipe-core-private.h"
+#include "sipe-dns.h"
+#include "sipe-schedule.h"
+
+#define SIPE_DNS_CACHE_SECTION "dns"
+
+/*
+ * The backend DNS API doesn't report the TTL of the records, so we use
+ * fixed lifetimes instead. Negative answers are kept only for a short
+ * time: on a flaky network a lookup failure can be caused by a temporary
+ * outage instead of a missing record.
+ */
+#define SIPE_DNS_CACHE_LIFETIME           3600 /* seconds */
+#define SIPE_DNS_CACHE_NEGATIVE_LIFETIME    60 /* seconds */
+
+struct sipe_dns_lookup {
+	struct sipe_core_private *sipe_private;
+	struct sipe_dns_query *query;      /* backend query is pending */
+	gchar *timeout;                    /* cached answer is pending */
+	gchar *key;
+	gchar *hostname;
+	guint port;
+	gboolean srv;
+	sipe_dns_resolved_cb callback;
+	gpointer data;
+};
+
+static void dns_lookup_free(struct sipe_dns_lookup *lookup)
+{
+	g_free(lookup->hostname);
+	g_free(lookup->timeout);
+	g_free(lookup->key);
+	g_free(lookup);
+}
+
+static void dns_lookup_finished(struct sipe_dns_lookup *lookup,
+				const gchar *hostname,
+				guint port)
+{
+	(*lookup->callback)(lookup->data, hostname, port);
+	dns_lookup_free(lookup);
+}
+
+static void dns_cached_answer(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private,
+			      gpointer data)
+{
+	struct sipe_dns_lookup *lookup = data;
+
+	SIPE_DEBUG_INFO("dns_cached_answer: %s -> %s:%d",
+			lookup->key,
+			lookup->hostname ? lookup->hostname : "(none)",
+			lookup->port);
+
+	dns_lookup_finished(lookup, lookup->hostname, lookup->port);
+}
+
+static void dns_resolved(struct sipe_dns_lookup *lookup,
+			 const gchar *hostname,
+			 guint port)
+{
+	lookup->query = NULL;
+
+	if (hostname) {
+		gchar *value = lookup->srv ?
+			g_strdup_printf("%d:%s", port, hostname) :
+			g_strdup(hostname);
+		sipe_cache_set(lookup->sipe_private,
+			       SIPE_DNS_CACHE_SECTION,
+			       lookup->key,
+			       value,
+			       SIPE_DNS_CACHE_LIFETIME);
+		g_free(value);
+	} else {
+		sipe_cache_set(lookup->sipe_private,
+			       SIPE_DNS_CACHE_SECTION,
+			       lookup->key,
+			       "",
+			       SIPE_DNS_CACHE_NEGATIVE_LIFETIME);
+	}
+
+	dns_lookup_finished(lookup, hostname, port);
+}
+
+static struct sipe_dns_lookup *dns_lookup_new(struct sipe_core_private *sipe_private,
+					      gchar *key,
+					      gboolean srv,
+					      guint port,
+					      sipe_dns_resolved_cb callback,
+					      gpointer data)
+{
+	struct sipe_dns_lookup *lookup = g_new0(struct sipe_dns_lookup, 1);
+
+	lookup->sipe_private = sipe_private;
+	lookup->key          = key;
+	lookup->srv          = srv;
+	lookup->port         = port;
+	lookup->callback     = callback;
+	lookup->data         = data;
+
+	return(lookup);
+}
+
+static gboolean dns_lookup_cached(struct sipe_dns_lookup *lookup)
+{
+	struct sipe_core_private *sipe_private = lookup->sipe_private;
+	const gchar *value = sipe_cache_get(sipe_private,
+					    SIPE_DNS_CACHE_SECTION,
+					    lookup->key);
+
+	if (!value)
+		return(FALSE);
+
+	/* empty value: negative answer */
+	if (*value) {
+		if (lookup->srv) {
+			gchar *host;
+			lookup->port = strtoul(value, &host, 10);
+
+			/* corrupted entry */
+			if (*host != ':') {
+				sipe_cache_remove(sipe_private,
+						  SIPE_DNS_CACHE_SECTION,
+						  lookup->key);
+				lookup->port = 0;
+				return(FALSE);
+			}
+			lookup->hostname = g_strdup(host + 1);
+		} else {
+			lookup->hostname = g_strdup(value);
+		}
+	} else {
+		lookup->port = 0;
+	}
+
+	lookup->timeout = g_strdup_printf("<+dns-cache><%p>", lookup);
+	sipe_schedule_mseconds(sipe_private,
+			       lookup->timeout,
+			       lookup,
+			       0,
+			       dns_cached_answer,
+			       NULL);
+
+	return(TRUE);
+}
+
+static gchar *dns_srv_key(const gchar *protocol,
+			  const gchar *transport,
+			  const gchar *domain)
+{
+	return(g_strdup_printf("srv:_%s._%s.%s", protocol, transport, domain));
+}
+
+struct sipe_dns_lookup *sipe_dns_query_srv(struct sipe_core_private *sipe_private,
+					   const gchar *protocol,
+					   const gchar *transport,
+					   const gchar *domain,
+					   sipe_dns_resolved_cb callback,
+					   gpointer data)
+{
+	struct sipe_dns_lookup *lookup = dns_lookup_new(sipe_private,
+							dns_srv_key(protocol,
+								    transport,
+								    domain),
+							TRUE,
+							0,
+							callback,
+							data);
+
+	if (!dns_lookup_cached(lookup))
+		lookup->query = sipe_backend_dns_query_srv(SIPE_CORE_PUBLIC,
+							   protocol,
+							   transport,
+							   domain,
+							   (sipe_dns_resolved_cb) dns_resolved,
+							   lookup);
+
+	return(lookup);
+}
+
+struct sipe_dns_lookup *sipe_dns_query_a(struct sipe_core_private *sipe_private,
+					 const gchar *hostname,
+					 guint port,
+					 sipe_dns_resolved_cb callback,
+					 gpointer data)
+{
+	struct sipe_dns_lookup *lookup = dns_lookup_new(sipe_private,
+							g_strdup_printf("a:%s",
+									hostname),
+							FALSE,
+							port,
+							callback,
+							data);
+
+	if (!dns_lookup_cached(lookup))
+		lookup->query = sipe_backend_dns_query_a(SIPE_CORE_PUBLIC,
+							 hostname,
+							 port,
+							 (sipe_dns_resolved_cb) dns_resolved,
+							 lookup);
+
+	return(lookup);
+}
+
+void sipe_dns_query_cancel(struct sipe_dns_lookup *lookup)
+{
+	if (lookup->query)
+		sipe_backend_dns_query_cancel(lookup->query);
+	if (lookup->timeout)
+		sipe_schedule_cancel(lookup->sipe_private, lookup->timeout);
+	dns_lookup_free(lookup);
+}
+
+void sipe_dns_forget_srv(struct sipe_core_private *sipe_private,
+			 const gchar *protocol,
+			 const gchar *transport,
+			 const gchar *domain)
+{
+	gchar *key = dns_srv_key(protocol, transport, domain);
+	sipe_cache_remove(sipe_private, SIPE_DNS_CACHE_SECTION, key);
+	g_free(key);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
@@ -0,0 +1,79 @@
+/**
+ * @file sipe-dns.h
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * DNS queries with result cache
+ *
+ * Same semantics as sipe_backend_dns_query_xxx(), but answers, including
+ * negative ones, are stored in the persistent cache. A cached answer is
+ * delivered asynchronously, i.e. the callback is never called before the
+ * query function has returned.
+ *
+ * Needs sipe-backend.h for sipe_dns_resolved_cb.
+ */
+
+/* Forward declarations */
+struct sipe_core_private;
+struct sipe_dns_lookup;
+
+struct sipe_dns_lookup *sipe_dns_query_srv(struct sipe_core_private *sipe_private,
+					   const gchar *protocol,
+					   const gchar *transport,
+					   const gchar *domain,
+					   sipe_dns_resolved_cb callback,
+					   gpointer data);
+
+struct sipe_dns_lookup *sipe_dns_query_a(struct sipe_core_private *sipe_private,
+					 const gchar *hostname,
+					 guint port,
+					 sipe_dns_resolved_cb callback,
+					 gpointer data);
+
+/**
+ * Cancel pending query. Callback will not be called.
+ *
+ * @param lookup pending query
+ */
+void sipe_dns_query_cancel(struct sipe_dns_lookup *lookup);
+
+/**
+ * Drop cached SRV answer, e.g. after connecting to the server failed
+ *
+ * @param sipe_private SIPE core private data
+ * @param protocol     service protocol
+ * @param transport    service transport
+ * @param domain       service domain
+ */
+void sipe_dns_forget_srv(struct sipe_core_private *sipe_private,
+			 const gchar *protocol,
+			 const gchar *transport,
+			 const gchar *domain);
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
@@ -35,6 +35,7 @@
 #include <glib.h>
 
 #include "sipe-backend.h"
+#include "sipe-cache.h"
 #include "sipe-common.h"
 #include "sipe-core.h"
 #include "sipe-core-private.h"
@@ -43,6 +44,16 @@
 #include "sipe-utils.h"
 #include "sipe-xml.h"
 
+/*
+ * Successful autodiscover results are stored in the persistent cache:
+ *
+ *   key "ews:<email>" value "<AS URL>\n<EWS URL>\n<Legacy DN>\n<OAB URL>\n<OOF URL>"
+ *
+ * A missing setting is stored as an empty line.
+ */
+#define EWS_AUTODISCOVER_CACHE_SECTION  "autodiscover"
+#define EWS_AUTODISCOVER_CACHE_LIFETIME (24 * 60 * 60) /* seconds */
+
 struct sipe_ews_autodiscover_cb {
 	sipe_ews_autodiscover_callback *cb;
 	gpointer cb_data;
@@ -53,13 +64,18 @@ struct autodiscover_method {
 	gboolean redirect;
 };
 
+/* All methods are probed concurrently, first valid answer wins */
+struct autodiscover_probe {
+	struct sipe_http_request *request;
+	gchar *url;
+	gboolean retry;
+};
+
 struct sipe_ews_autodiscover {
 	struct sipe_ews_autodiscover_data *data;
-	struct sipe_http_request *request;
+	GSList *probes;
 	GSList *callbacks;
 	gchar *email;
-	const struct autodiscover_method *method;
-	gboolean retry;
 	gboolean completed;
 };
 
@@ -80,19 +96,116 @@ static void sipe_ews_autodiscover_complete(struct sipe_core_private *sipe_privat
 	sea->completed = TRUE;
 }
 
-static void sipe_ews_autodiscover_request(struct sipe_core_private *sipe_private,
-					  gboolean next_method);
+static void sipe_ews_autodiscover_probe_free(struct sipe_ews_autodiscover *sea,
+					     struct autodiscover_probe *probe)
+{
+	sea->probes = g_slist_remove(sea->probes, probe);
+	if (probe->request)
+		sipe_http_request_cancel(probe->request);
+	g_free(probe->url);
+	g_free(probe);
+}
+
+static void sipe_ews_autodiscover_probes_cancel(struct sipe_ews_autodiscover *sea)
+{
+	while (sea->probes)
+		sipe_ews_autodiscover_probe_free(sea, sea->probes->data);
+}
+
+static void sipe_ews_autodiscover_probe_failed(struct sipe_core_private *sipe_private,
+					       struct autodiscover_probe *probe)
+{
+	struct sipe_ews_autodiscover *sea = sipe_private->ews_autodiscover;
+
+	sipe_ews_autodiscover_probe_free(sea, probe);
+
+	/* was this the last pending probe? */
+	if (!sea->probes) {
+		SIPE_DEBUG_INFO_NOFORMAT("sipe_ews_autodiscover_probe_failed: no more methods to try!");
+		sipe_ews_autodiscover_complete(sipe_private, NULL);
+	}
+}
+
+static gchar *sipe_ews_autodiscover_key(struct sipe_core_private *sipe_private)
+{
+	return(g_strdup_printf("ews:%s", sipe_private->email));
+}
+
+static void sipe_ews_autodiscover_store(struct sipe_core_private *sipe_private,
+					const struct sipe_ews_autodiscover_data *ews_data)
+{
+	gchar *key   = sipe_ews_autodiscover_key(sipe_private);
+	gchar *value = g_strdup_printf("%s\n%s\n%s\n%s\n%s",
+				       ews_data->as_url    ? ews_data->as_url    : "",
+				       ews_data->ews_url   ? ews_data->ews_url   : "",
+				       ews_data->legacy_dn ? ews_data->legacy_dn : "",
+				       ews_data->oab_url   ? ews_data->oab_url   : "",
+				       ews_data->oof_url   ? ews_data->oof_url   : "");
+
+	sipe_cache_set(sipe_private,
+		       EWS_AUTODISCOVER_CACHE_SECTION,
+		       key,
+		       value,
+		       EWS_AUTODISCOVER_CACHE_LIFETIME);
+
+	g_free(value);
+	g_free(key);
+}
+
+static struct sipe_ews_autodiscover_data *sipe_ews_autodiscover_load(struct sipe_core_private *sipe_private)
+{
+	gchar *key = sipe_ews_autodiscover_key(sipe_private);
+	const gchar *value = sipe_cache_get(sipe_private,
+					    EWS_AUTODISCOVER_CACHE_SECTION,
+					    key);
+	struct sipe_ews_autodiscover_data *ews_data = NULL;
+
+	if (value) {
+		gchar **fields = g_strsplit(value, "\n", 5);
+
+		if (g_strv_length(fields) == 5) {
+			ews_data = g_new0(struct sipe_ews_autodiscover_data, 1);
+
+#define _FIELD(index, field) \
+			if (*fields[index]) \
+				ews_data->field = g_strdup(fields[index]);
+
+			_FIELD(0, as_url);
+			_FIELD(1, ews_url);
+			_FIELD(2, legacy_dn);
+			_FIELD(3, oab_url);
+			_FIELD(4, oof_url);
+#undef _FIELD
+
+		}
+		g_strfreev(fields);
+	}
+
+	g_free(key);
+	return(ews_data);
+}
+
+void sipe_ews_autodiscover_forget(struct sipe_core_private *sipe_private)
+{
+	gchar *key = sipe_ews_autodiscover_key(sipe_private);
+	sipe_cache_remove(sipe_private,
+			  EWS_AUTODISCOVER_CACHE_SECTION,
+			  key);
+	g_free(key);
+}
+
+static void sipe_ews_autodiscover_request(struct sipe_core_private *sipe_private);
 static gboolean sipe_ews_autodiscover_url(struct sipe_core_private *sipe_private,
+					  struct autodiscover_probe *probe,
 					  const gchar *url);
 static void sipe_ews_autodiscover_parse(struct sipe_core_private *sipe_private,
+					struct autodiscover_probe *probe,
 					const gchar *body)
 {
 	struct sipe_ews_autodiscover *sea = sipe_private->ews_autodiscover;
-	struct sipe_ews_autodiscover_data *ews_data = sea->data =
-		g_new0(struct sipe_ews_autodiscover_data, 1);
 	sipe_xml *xml = sipe_xml_parse(body, strlen(body));
 	const sipe_xml *account = sipe_xml_child(xml, "Response/Account");
-	gboolean complete = TRUE;
+	gboolean failed = TRUE;
 
 	/* valid POX autodiscover response? */
 	if (account) {
@@ -100,6 +213,8 @@ static void sipe_ews_autodiscover_parse(struct sipe_core_private *sipe_private,
 
 		/* POX autodiscover settings? */
 		if ((node = sipe_xml_child(account, "Protocol")) != NULL) {
+			struct sipe_ews_autodiscover_data *ews_data = sea->data =
+				g_new0(struct sipe_ews_autodiscover_data, 1);
 
 			/* Autodiscover/Response/User/LegacyDN (requires trimming) */
 			gchar *tmp = sipe_xml_data(sipe_xml_child(xml,
@@ -134,6 +249,13 @@ static void sipe_ews_autodiscover_parse(struct sipe_core_private *sipe_private,
 				g_free(type);
 			}
 
+			sipe_ews_autodiscover_store(sipe_private, ews_data);
+
+			/* we have a winner: drop all other probes */
+			sipe_ews_autodiscover_probes_cancel(sea);
+			failed = FALSE;
+			sipe_ews_autodiscover_complete(sipe_private, ews_data);
+
 		/* POX autodiscover redirect to new email address? */
 		} else if ((node = sipe_xml_child(account, "RedirectAddr")) != NULL) {
 			gchar *addr = sipe_xml_data(node);
@@ -153,10 +275,9 @@ static void sipe_ews_autodiscover_parse(struct sipe_core_private *sipe_private,
 						sea->email);
 
 				/* restart process with new email address */
-				sea->method = NULL;
-				complete    = FALSE;
-				sipe_ews_autodiscover_request(sipe_private,
-							      TRUE);
+				sipe_ews_autodiscover_probes_cancel(sea);
+				failed = FALSE;
+				sipe_ews_autodiscover_request(sipe_private);
 			}
 			g_free(addr);
 
@@ -167,8 +288,9 @@ static void sipe_ews_autodiscover_parse(struct sipe_core_private *sipe_private,
 			if (!is_empty(url)) {
 				SIPE_DEBUG_INFO("sipe_ews_autodiscover_parse: redirected to URL '%s'",
 						url);
-				complete = !sipe_ews_autodiscover_url(sipe_private,
-								      url);
+				failed = !sipe_ews_autodiscover_url(sipe_private,
+								    probe,
+								    url);
 			}
 			g_free(url);
 
@@ -179,8 +301,8 @@ static void sipe_ews_autodiscover_parse(struct sipe_core_private *sipe_private,
 	}
 	sipe_xml_free(xml);
 
-	if (complete)
-		sipe_ews_autodiscover_complete(sipe_private, ews_data);
+	if (failed)
+		sipe_ews_autodiscover_probe_failed(sipe_private, probe);
 }
 
 static void sipe_ews_autodiscover_response(struct sipe_core_private *sipe_private,
@@ -189,18 +311,18 @@ static void sipe_ews_autodiscover_response(struct sipe_core_private *sipe_privat
 					   const gchar *body,
 					   gpointer data)
 {
-	struct sipe_ews_autodiscover *sea = data;
+	struct autodiscover_probe *probe = data;
 	const gchar *type = sipe_utils_nameval_find(headers, "Content-Type");
 
-	sea->request = NULL;
+	probe->request = NULL;
 
 	switch (status) {
 	case SIPE_HTTP_STATUS_OK:
 		/* only accept XML responses */
 		if (body && g_str_has_prefix(type, "text/xml"))
-			sipe_ews_autodiscover_parse(sipe_private, body);
+			sipe_ews_autodiscover_parse(sipe_private, probe, body);
 		else
-			sipe_ews_autodiscover_request(sipe_private, TRUE);
+			sipe_ews_autodiscover_probe_failed(sipe_private, probe);
 		break;
 
 	case SIPE_HTTP_STATUS_CLIENT_FORBIDDEN:
@@ -212,20 +334,31 @@ static void sipe_ews_autodiscover_response(struct sipe_core_private *sipe_privat
 		 *
 		 * Let's try again, but only once...
 		 */
-		sipe_ews_autodiscover_request(sipe_private, !sea->retry);
+		if (probe->retry) {
+			sipe_ews_autodiscover_probe_failed(sipe_private, probe);
+		} else {
+			gchar *url = g_strdup(probe->url);
+			probe->retry = TRUE;
+			if (!sipe_ews_autodiscover_url(sipe_private, probe, url))
+				sipe_ews_autodiscover_probe_failed(sipe_private, probe);
+			g_free(url);
+		}
 		break;
 
 	case SIPE_HTTP_STATUS_ABORTED:
 		/* we are not allowed to generate new requests */
+		sipe_ews_autodiscover_probe_free(sipe_private->ews_autodiscover,
+						 probe);
 		break;
 
 	default:
-		sipe_ews_autodiscover_request(sipe_private, TRUE);
+		sipe_ews_autodiscover_probe_failed(sipe_private, probe);
 		break;
 	}
 }
 
 static gboolean sipe_ews_autodiscover_url(struct sipe_core_private *sipe_private,
+					  struct autodiscover_probe *probe,
 					  const gchar *url)
 {
 	struct sipe_ews_autodiscover *sea = sipe_private->ews_autodiscover;
@@ -239,20 +372,24 @@ static gboolean sipe_ews_autodiscover_url(struct sipe_core_private *sipe_private
 
 	SIPE_DEBUG_INFO("sipe_ews_autodiscover_url: trying '%s'", url);
 
-	sea->request = sipe_http_request_post(sipe_private,
-					      url,
-					      "Accept: text/xml\r\n",
-					      body,
-					      "text/xml",
-					      sipe_ews_autodiscover_response,
-					      sea);
+	/* remember URL for retry */
+	g_free(probe->url);
+	probe->url = g_strdup(url);
+
+	probe->request = sipe_http_request_post(sipe_private,
+						url,
+						"Accept: text/xml\r\n",
+						body,
+						"text/xml",
+						sipe_ews_autodiscover_response,
+						probe);
 	g_free(body);
 
-	if (sea->request) {
+	if (probe->request) {
 		sipe_core_email_authentication(sipe_private,
-					       sea->request);
-		sipe_http_request_allow_redirect(sea->request);
-		sipe_http_request_ready(sea->request);
+					       probe->request);
+		sipe_http_request_allow_redirect(probe->request);
+		sipe_http_request_ready(probe->request);
 		return(TRUE);
 	}
 
@@ -265,10 +402,17 @@ static void sipe_ews_autodiscover_redirect_response(struct sipe_core_private *si
 						    SIPE_UNUSED_PARAMETER const gchar *body,
 						    gpointer data)
 {
-	struct sipe_ews_autodiscover *sea = data;
-	gboolean failed = (status != (guint) SIPE_HTTP_STATUS_ABORTED);
+	struct autodiscover_probe *probe = data;
+	gboolean failed = TRUE;
 
-	sea->request = NULL;
+	probe->request = NULL;
+
+	/* we are not allowed to generate new requests */
+	if (status == (guint) SIPE_HTTP_STATUS_ABORTED) {
+		sipe_ews_autodiscover_probe_free(sipe_private->ews_autodiscover,
+						 probe);
+		return;
+	}
 
 	/* Start attempt with URL from redirect (3xx) response */
 	if ((status >= SIPE_HTTP_STATUS_REDIRECTION) &&
@@ -278,36 +422,35 @@ static void sipe_ews_autodiscover_redirect_response(struct sipe_core_private *si
 									 0);
 		if (location)
 			failed = !sipe_ews_autodiscover_url(sipe_private,
+							    probe,
 							    location);
 	}
 
 	if (failed)
-		sipe_ews_autodiscover_request(sipe_private, TRUE);
+		sipe_ews_autodiscover_probe_failed(sipe_private, probe);
 }
 
 static gboolean sipe_ews_autodiscover_redirect(struct sipe_core_private *sipe_private,
+					       struct autodiscover_probe *probe,
 					       const gchar *url)
 {
-	struct sipe_ews_autodiscover *sea = sipe_private->ews_autodiscover;
-
 	SIPE_DEBUG_INFO("sipe_ews_autodiscover_redirect: trying '%s'", url);
 
-	sea->request = sipe_http_request_get(sipe_private,
-					     url,
-					     NULL,
-					     sipe_ews_autodiscover_redirect_response,
-					     sea);
+	probe->request = sipe_http_request_get(sipe_private,
+					       url,
+					       NULL,
+					       sipe_ews_autodiscover_redirect_response,
+					       probe);
 
-	if (sea->request) {
-		sipe_http_request_ready(sea->request);
+	if (probe->request) {
+		sipe_http_request_ready(probe->request);
 		return(TRUE);
 	}
 
 	return(FALSE);
 }
 
-static void sipe_ews_autodiscover_request(struct sipe_core_private *sipe_private,
-					  gboolean next_method)
+static void sipe_ews_autodiscover_request(struct sipe_core_private *sipe_private)
 {
 	struct sipe_ews_autodiscover *sea = sipe_private->ews_autodiscover;
 	static const struct autodiscover_method methods[] = {
@@ -317,26 +460,25 @@ static void sipe_ews_autodiscover_request(struct sipe_core_private *sipe_private
 		{ "https://%s/Autodiscover/Autodiscover.xml",              FALSE },
 		{ NULL,                                                    FALSE },
 	};
+	const struct autodiscover_method *method;
 
-	sea->retry = next_method;
-	if (sea->method) {
-		if (next_method)
-			sea->method++;
-	} else
-		sea->method = methods;
-
-	if (sea->method->template) {
-		gchar *url = g_strdup_printf(sea->method->template,
+	/* Launch all probes at once */
+	for (method = methods; method->template; method++) {
+		struct autodiscover_probe *probe = g_new0(struct autodiscover_probe, 1);
+		gchar *url = g_strdup_printf(method->template,
 					     strstr(sea->email, "@") + 1);
 
-		if (!(sea->method->redirect ?
-		      sipe_ews_autodiscover_redirect(sipe_private, url) :
-		      sipe_ews_autodiscover_url(sipe_private, url)))
-			sipe_ews_autodiscover_request(sipe_private, TRUE);
+		sea->probes = g_slist_prepend(sea->probes, probe);
+
+		if (!(method->redirect ?
+		      sipe_ews_autodiscover_redirect(sipe_private, probe, url) :
+		      sipe_ews_autodiscover_url(sipe_private, probe, url)))
+			sipe_ews_autodiscover_probe_free(sea, probe);
 
 		g_free(url);
+	}
 
-	} else {
+	if (!sea->probes) {
 		SIPE_DEBUG_INFO_NOFORMAT("sipe_ews_autodiscover_request: no more methods to try!");
 		sipe_ews_autodiscover_complete(sipe_private, NULL);
 	}
@@ -348,6 +490,13 @@ void sipe_ews_autodiscover_start(struct sipe_core_private *sipe_private,
 {
 	struct sipe_ews_autodiscover *sea = sipe_private->ews_autodiscover;
 
+	/* Previous result is still valid: skip autodiscover */
+	if (!sea->completed && !sea->probes &&
+	    ((sea->data = sipe_ews_autodiscover_load(sipe_private)) != NULL)) {
+		SIPE_DEBUG_INFO_NOFORMAT("sipe_ews_autodiscover_start: using cached settings");
+		sea->completed = TRUE;
+	}
+
 	if (sea->completed) {
 		(*callback)(sipe_private, sea->data, callback_data);
 	} else {
@@ -356,8 +505,8 @@ void sipe_ews_autodiscover_start(struct sipe_core_private *sipe_private,
 		sea_cb->cb_data = callback_data;
 		sea->callbacks  = g_slist_prepend(sea->callbacks, sea_cb);
 
-		if (!sea->method)
-			sipe_ews_autodiscover_request(sipe_private, TRUE);
+		if (!sea->probes)
+			sipe_ews_autodiscover_request(sipe_private);
 	}
 }
 
@@ -374,6 +523,7 @@ void sipe_ews_autodiscover_free(struct sipe_core_private *sipe_private)
 {
 	struct sipe_ews_autodiscover *sea = sipe_private->ews_autodiscover;
 	struct sipe_ews_autodiscover_data *ews_data = sea->data;
+	sipe_ews_autodiscover_probes_cancel(sea);
 	sipe_ews_autodiscover_complete(sipe_private, NULL);
 	if (ews_data) {
 		g_free((gchar *)ews_data->as_url);
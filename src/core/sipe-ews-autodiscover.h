@@ -45,9 +45,19 @@ typedef void (sipe_ews_autodiscover_callback)(struct sipe_core_private *sipe_pri
 					      const struct sipe_ews_autodiscover_data *ews_data,
 					      gpointer callback_data);
 
+/**
+ * Drop cached EWS autodiscover result, e.g. after EWS requests failed
+ *
+ * @param sipe_private SIPE core private data
+ */
+void sipe_ews_autodiscover_forget(struct sipe_core_private *sipe_private);
+
 /**
  * Trigger EWS autodiscover
  *
+ * A successful result is cached. If a valid cached result exists then
+ * the callback is called immediately.
+ *
  * @param sipe_private  SIPE core private data
  * @param callback      callback function
  * @param callback_data callback data
@@ -54,6 +54,7 @@ be great to implement too.
 #include "sipe-cal.h"
 #include "sipe-core.h"
 #include "sipe-core-private.h"
+#include "sipe-digest.h"
 #include "sipe-ews.h"
 #include "sipe-ews-autodiscover.h"
 #include "sipe-http.h"
@@ -133,9 +134,8 @@ be great to implement too.
 
 #define SIPE_EWS_STATE_IDLE			 0
 #define SIPE_EWS_STATE_AUTODISCOVER_TRIGGERED	 1
-#define SIPE_EWS_STATE_AVAILABILITY_SUCCESS	 2
+#define SIPE_EWS_STATE_UPDATE_PENDING		 2
 #define SIPE_EWS_STATE_AVAILABILITY_FAILURE	-2
-#define SIPE_EWS_STATE_OOF_SUCCESS		 3
 #define SIPE_EWS_STATE_OOF_FAILURE		-3
 
 char *
@@ -183,9 +183,12 @@ Envelope/Body/GetUserAvailabilityResponse/FreeBusyResponseArray/FreeBusyResponse
 Envelope/Body/GetUserAvailabilityResponse/FreeBusyResponseArray/FreeBusyResponse/FreeBusyView/WorkingHours
 		 */
 		resp = sipe_xml_child(xml, "Body/GetUserAvailabilityResponse/FreeBusyResponseArray/FreeBusyResponse");
-		if (!resp) return; /* rather soap:Fault */
-		if (!sipe_strequal(sipe_xml_attribute(sipe_xml_child(resp, "ResponseMessage"), "ResponseClass"), "Success")) {
-			return; /* Error response */
+		if (!resp || /* rather soap:Fault */
+		    !sipe_strequal(sipe_xml_attribute(sipe_xml_child(resp, "ResponseMessage"), "ResponseClass"), "Success")) {
+			/* Error response: keep old data, retry on next update */
+			sipe_xml_free(xml);
+			sipe_ews_run_state_machine(cal);
+			return;
 		}
 
 		/* MergedFreeBusy */
@@ -259,7 +262,6 @@ Envelope/Body/GetUserAvailabilityResponse/FreeBusyResponseArray/FreeBusyResponse
 
 		sipe_xml_free(xml);
 
-		cal->state = SIPE_EWS_STATE_AVAILABILITY_SUCCESS;
 		sipe_ews_run_state_machine(cal);
 
 	} else {
@@ -278,7 +280,7 @@ static void sipe_ews_process_oof_response(SIPE_UNUSED_PARAMETER struct sipe_core
 
 	SIPE_DEBUG_INFO_NOFORMAT("sipe_ews_process_oof_response: cb started.");
 
-	cal->request = NULL;
+	cal->oof_request = NULL;
 
 	if ((status == SIPE_HTTP_STATUS_OK) && body) {
 		char *old_note;
@@ -293,9 +295,12 @@ static void sipe_ews_process_oof_response(SIPE_UNUSED_PARAMETER struct sipe_core
 		 * Envelope/Body/GetUserOofSettingsResponse/OofSettings/InternalReply/Message
 		 */
 		resp = sipe_xml_child(xml, "Body/GetUserOofSettingsResponse");
-		if (!resp) return; /* rather soap:Fault */
-		if (!sipe_strequal(sipe_xml_attribute(sipe_xml_child(resp, "ResponseMessage"), "ResponseClass"), "Success")) {
-			return; /* Error response */
+		if (!resp || /* rather soap:Fault */
+		    !sipe_strequal(sipe_xml_attribute(sipe_xml_child(resp, "ResponseMessage"), "ResponseClass"), "Success")) {
+			/* Error response: keep old data, retry on next update */
+			sipe_xml_free(xml);
+			sipe_ews_run_state_machine(cal);
+			return;
 		}
 
 		g_free(cal->oof_state);
@@ -341,7 +346,6 @@ static void sipe_ews_process_oof_response(SIPE_UNUSED_PARAMETER struct sipe_core
 
 		sipe_xml_free(xml);
 
-		cal->state = SIPE_EWS_STATE_OOF_SUCCESS;
 		sipe_ews_run_state_machine(cal);
 
 	} else {
@@ -350,13 +354,14 @@ static void sipe_ews_process_oof_response(SIPE_UNUSED_PARAMETER struct sipe_core
 	}
 }
 
-static void sipe_ews_send_http_request(struct sipe_calendar *cal)
+static void sipe_ews_send_http_request(struct sipe_calendar *cal,
+				       struct sipe_http_request *request)
 {
-	if (cal->request) {
+	if (request) {
 		sipe_core_email_authentication(cal->sipe_private,
-					       cal->request);
-		sipe_http_request_allow_redirect(cal->request);
-		sipe_http_request_ready(cal->request);
+					       request);
+		sipe_http_request_allow_redirect(request);
+		sipe_http_request_ready(request);
 	}
 }
 
@@ -397,7 +402,7 @@ static void sipe_ews_do_avail_request(struct sipe_calendar *cal)
 		g_free(start_str);
 		g_free(end_str);
 
-		sipe_ews_send_http_request(cal);
+		sipe_ews_send_http_request(cal, cal->request);
 	}
 }
 
@@ -409,16 +414,90 @@ static void sipe_ews_do_oof_request(struct sipe_calendar *cal)
 		SIPE_DEBUG_INFO_NOFORMAT("sipe_ews_do_oof_request: going OOF req.");
 
 		body = g_strdup_printf(SIPE_EWS_USER_OOF_SETTINGS_REQUEST, cal->email);
-		cal->request = sipe_http_request_post(cal->sipe_private,
-						      cal->as_url,
-						      NULL,
-						      body,
-						      "text/xml; charset=UTF-8",
-						      sipe_ews_process_oof_response,
-						      cal);
+		cal->oof_request = sipe_http_request_post(cal->sipe_private,
+							  cal->as_url,
+							  NULL,
+							  body,
+							  "text/xml; charset=UTF-8",
+							  sipe_ews_process_oof_response,
+							  cal);
 		g_free(body);
 
-		sipe_ews_send_http_request(cal);
+		sipe_ews_send_http_request(cal, cal->oof_request);
+	}
+}
+
+static void sipe_ews_fingerprint_string(GString *data,
+					const gchar *value)
+{
+	/* distinguish NULL from empty string */
+	g_string_append_c(data, value ? 'S' : 'N');
+	if (value)
+		g_string_append(data, value);
+	g_string_append_c(data, '\0');
+}
+
+static void sipe_ews_fingerprint_time(GString *data,
+				      time_t value)
+{
+	g_string_append_printf(data, "%" G_GINT64_FORMAT, (gint64) value);
+	g_string_append_c(data, '\0');
+}
+
+/**
+ * Fingerprint of the calendar data that gets published
+ *
+ * The effective OOF note is included, because a scheduled OOF note
+ * becomes active/inactive without a change of the EWS data.
+ */
+static gchar *sipe_ews_fingerprint(struct sipe_calendar *cal)
+{
+	GString *data = g_string_new("");
+	guchar digest[SIPE_DIGEST_SHA1_LENGTH];
+	GSList *entry;
+
+	sipe_ews_fingerprint_time(data, cal->fb_start);
+	sipe_ews_fingerprint_string(data, cal->free_busy);
+	sipe_ews_fingerprint_string(data, cal->working_hours_xml_str);
+
+	for (entry = cal->cal_events; entry; entry = entry->next) {
+		struct sipe_cal_event *cal_event = entry->data;
+
+		sipe_ews_fingerprint_time(data, cal_event->start_time);
+		sipe_ews_fingerprint_time(data, cal_event->end_time);
+		g_string_append_printf(data, "%d%d",
+				       cal_event->cal_status,
+				       cal_event->is_meeting);
+		sipe_ews_fingerprint_string(data, cal_event->subject);
+		sipe_ews_fingerprint_string(data, cal_event->location);
+	}
+
+	sipe_ews_fingerprint_string(data, cal->oof_state);
+	sipe_ews_fingerprint_string(data, cal->oof_note);
+	sipe_ews_fingerprint_time(data, cal->oof_start);
+	sipe_ews_fingerprint_time(data, cal->oof_end);
+	sipe_ews_fingerprint_string(data, sipe_ews_get_oof_note(cal));
+
+	sipe_digest_sha1((guchar *) data->str, data->len, digest);
+	g_string_free(data, TRUE);
+
+	return(buff_to_hex_str(digest, sizeof(digest)));
+}
+
+static void sipe_ews_update_finished(struct sipe_calendar *cal)
+{
+	gchar *fingerprint = sipe_ews_fingerprint(cal);
+
+	cal->state = SIPE_EWS_STATE_IDLE;
+
+	if (sipe_strequal(fingerprint, cal->fingerprint)) {
+		SIPE_DEBUG_INFO_NOFORMAT("sipe_ews_update_finished: calendar data unchanged, skipping publish");
+		g_free(fingerprint);
+	} else {
+		g_free(cal->fingerprint);
+		cal->fingerprint = fingerprint;
+		cal->is_updated  = TRUE;
+		sipe_cal_presence_publish(cal->sipe_private, TRUE);
 	}
 }
 
@@ -428,25 +507,35 @@ sipe_ews_run_state_machine(struct sipe_calendar *cal)
 	switch (cal->state) {
 	case SIPE_EWS_STATE_AVAILABILITY_FAILURE:
 	case SIPE_EWS_STATE_OOF_FAILURE:
+		/* drop the other request, if it is still pending */
+		if (cal->request) {
+			sipe_http_request_cancel(cal->request);
+			cal->request = NULL;
+		}
+		if (cal->oof_request) {
+			sipe_http_request_cancel(cal->oof_request);
+			cal->oof_request = NULL;
+		}
+		/* URLs might be outdated, rediscover them on next login */
+		sipe_ews_autodiscover_forget(cal->sipe_private);
 		cal->is_ews_disabled = TRUE;
 		break;
 	case SIPE_EWS_STATE_IDLE:
+		/* both requests are independent: run them in parallel */
+		cal->state = SIPE_EWS_STATE_UPDATE_PENDING;
 		sipe_ews_do_avail_request(cal);
+		sipe_ews_do_oof_request(cal);
+		/* no request could be sent? */
+		if (!cal->request && !cal->oof_request)
+			sipe_ews_update_finished(cal);
 		break;
 	case SIPE_EWS_STATE_AUTODISCOVER_TRIGGERED:
 		/* do nothing */
 		break;
-	case SIPE_EWS_STATE_AVAILABILITY_SUCCESS:
-		sipe_ews_do_oof_request(cal);
-		break;
-	case SIPE_EWS_STATE_OOF_SUCCESS:
-		{
-			struct sipe_core_private *sipe_private = cal->sipe_private;
-
-			cal->state = SIPE_EWS_STATE_IDLE;
-			cal->is_updated = TRUE;
-			sipe_cal_presence_publish(sipe_private, TRUE);
-		}
+	case SIPE_EWS_STATE_UPDATE_PENDING:
+		/* publish after the last response has been processed */
+		if (!cal->request && !cal->oof_request)
+			sipe_ews_update_finished(cal);
 		break;
 	}
 }
@@ -48,6 +48,9 @@
 #include "sipmsg.h"
 #include "sdpmsg.h"
 
+#define XDATA_HEADER_SIZE (sizeof (guint8) + sizeof (guint16))
+#define XDATA_CHUNK_SIZE  2048
+
 struct sipe_file_transfer_lync {
 	struct sipe_file_transfer public;
 
@@ -59,10 +62,15 @@ struct sipe_file_transfer_lync {
 
 	guint bytes_left_in_chunk;
 
-	guint8 buffer[2048];
+	/* outgoing data chunks are read behind the XData header space */
+	guint8 buffer[XDATA_HEADER_SIZE + XDATA_CHUNK_SIZE];
 	guint buffer_len;
 	guint buffer_read_pos;
 
+	/* outgoing throughput statistics */
+	GTimer *send_timer;
+	gsize bytes_sent;
+
 	int backend_pipe[2];
 	int backend_pipe_write_source_id;
 
@@ -81,8 +89,6 @@ typedef enum {
 	SIPE_XDATA_END_OF_STREAM = 0x02
 } SipeXDataMessages;
 
-#define XDATA_HEADER_SIZE sizeof (guint8) + sizeof (guint16)
-
 static void
 sipe_file_transfer_lync_free(struct sipe_file_transfer_lync *ft_private)
 {
@@ -95,6 +101,8 @@ sipe_file_transfer_lync_free(struct sipe_file_transfer_lync *ft_private)
 		close(ft_private->backend_pipe[our_pipe_end]);
 	}
 
+	if (ft_private->send_timer)
+		g_timer_destroy(ft_private->send_timer);
 	g_free(ft_private->file_name);
 	g_free(ft_private->sdp);
 	g_free(ft_private->id);
@@ -296,48 +304,62 @@ read_cb(struct sipe_media_stream *stream)
 	struct sipe_file_transfer_lync *ft_private =
 			sipe_core_media_stream_get_data(stream);
 
-	if (ft_private->buffer_read_pos < ft_private->buffer_len) {
-		/* Have data in buffer, write them to the backend. */
+	/* Pass on as much data as the backend pipe accepts in one go */
+	while (TRUE) {
+		if (ft_private->buffer_read_pos < ft_private->buffer_len) {
+			/* Have data in buffer, write them to the backend. */
+
+			gpointer buffer;
+			size_t len;
+			ssize_t written;
+
+			buffer = ft_private->buffer + ft_private->buffer_read_pos;
+			len = ft_private->buffer_len - ft_private->buffer_read_pos;
+			written = write(ft_private->backend_pipe[1], buffer, len);
+
+			if (written > 0) {
+				ft_private->buffer_read_pos += written;
+			} else if (written < 0 && errno != EAGAIN) {
+				SIPE_DEBUG_ERROR_NOFORMAT("Error while writing into "
+							  "backend pipe");
+				sipe_backend_ft_cancel_local(SIPE_FILE_TRANSFER);
+				return;
+			}
 
-		gpointer buffer;
-		size_t len;
-		ssize_t written;
+			/* Pipe is full, continue on next call. */
+			if ((size_t) written != len) {
+				return;
+			}
+		} else if (ft_private->bytes_left_in_chunk != 0) {
+			/* Have data from the sender, replenish our buffer with it. */
 
-		buffer = ft_private->buffer + ft_private->buffer_read_pos;
-		len = ft_private->buffer_len - ft_private->buffer_read_pos;
-		written = write(ft_private->backend_pipe[1], buffer, len);
+			ft_private->buffer_len = MIN(ft_private->bytes_left_in_chunk,
+						     sizeof (ft_private->buffer));
 
-		if (written > 0) {
-			ft_private->buffer_read_pos += written;
-		} else if (written < 0 && errno != EAGAIN) {
-			SIPE_DEBUG_ERROR_NOFORMAT("Error while writing into "
-						  "backend pipe");
-			sipe_backend_ft_cancel_local(SIPE_FILE_TRANSFER);
-			return;
-		}
-	} else if (ft_private->bytes_left_in_chunk != 0) {
-		/* Have data from the sender, replenish our buffer with it. */
-
-		ft_private->buffer_len = MIN(ft_private->bytes_left_in_chunk,
-					     sizeof (ft_private->buffer));
+			ft_private->buffer_len =
+					sipe_backend_media_stream_read(stream,
+								       ft_private->buffer,
+								       ft_private->buffer_len);
 
-		ft_private->buffer_len =
-				sipe_backend_media_stream_read(stream,
-							       ft_private->buffer,
-							       ft_private->buffer_len);
+			ft_private->bytes_left_in_chunk -= ft_private->buffer_len;
+			ft_private->buffer_read_pos = 0;
 
-		ft_private->bytes_left_in_chunk -= ft_private->buffer_len;
-		ft_private->buffer_read_pos = 0;
+			SIPE_DEBUG_INFO("Read %d bytes. %d left in this chunk.",
+					ft_private->buffer_len, ft_private->bytes_left_in_chunk);
 
-		SIPE_DEBUG_INFO("Read %d bytes. %d left in this chunk.",
-				ft_private->buffer_len, ft_private->bytes_left_in_chunk);
-	} else {
-		/* No data available. This is either stream start, beginning of
-		 * chunk, or stream end. */
+			/* No more data from the sender at the moment. */
+			if (ft_private->buffer_len == 0) {
+				return;
+			}
+		} else {
+			/* No data available. This is either stream start,
+			 * beginning of chunk, or stream end. */
 
-		sipe_media_stream_read_async(stream, ft_private->buffer,
-					     XDATA_HEADER_SIZE,
-					     xdata_got_header_cb);
+			sipe_media_stream_read_async(stream, ft_private->buffer,
+						     XDATA_HEADER_SIZE,
+						     xdata_got_header_cb);
+			return;
+		}
 	}
 }
 
@@ -528,11 +550,16 @@ static void
 write_chunk(struct sipe_media_stream *stream,
 	    guint8 type, guint16 len, const gchar *buffer)
 {
-	guint16 len_be = GUINT16_TO_BE(len);
+	/* header and payload go into the stream with a single write */
+	guint8 *chunk = g_malloc(XDATA_HEADER_SIZE + len);
+
+	chunk[0] = type;
+	chunk[1] = (len >> 8) & 0xFF;
+	chunk[2] = len & 0xFF;
+	memcpy(chunk + XDATA_HEADER_SIZE, buffer, len);
 
-	sipe_media_stream_write(stream, &type, sizeof (guint8));
-	sipe_media_stream_write(stream, (guint8 *)&len_be, sizeof (guint16));
-	sipe_media_stream_write(stream, (guint8 *)buffer, len);
+	sipe_media_stream_write(stream, chunk, XDATA_HEADER_SIZE + len);
+	g_free(chunk);
 }
 
 static gboolean
@@ -553,25 +580,43 @@ send_file_chunk(SIPE_UNUSED_PARAMETER GIOChannel *source,
 		return FALSE; /* G_SOURCE_REMOVE */
 	}
 
-	if (!sipe_media_stream_is_writable(stream)) {
-		return TRUE; /* G_SOURCE_CONTINUE */
-	}
-
-	bytes_read = read(ft_private->backend_pipe[0],
-			  ft_private->buffer, sizeof (ft_private->buffer));
-	if (bytes_read > 0) {
-		write_chunk(stream, SIPE_XDATA_DATA_CHUNK,
-			    bytes_read, (const gchar *)ft_private->buffer);
-	} else if (bytes_read == 0) {
-		/* EOF, write end of stream */
-		gchar *request_id_str;
-
-		request_id_str = g_strdup_printf("%u", ft_private->request_id);
-		write_chunk(stream, SIPE_XDATA_END_OF_STREAM,
-			    strlen(request_id_str), request_id_str);
-		g_free(request_id_str);
+	/* Drain the backend pipe for as long as the stream accepts data */
+	while (sipe_media_stream_is_writable(stream)) {
+		bytes_read = read(ft_private->backend_pipe[0],
+				  ft_private->buffer + XDATA_HEADER_SIZE,
+				  XDATA_CHUNK_SIZE);
+		if (bytes_read > 0) {
+			/* Data is already in place behind the header space */
+			ft_private->buffer[0] = SIPE_XDATA_DATA_CHUNK;
+			ft_private->buffer[1] = (bytes_read >> 8) & 0xFF;
+			ft_private->buffer[2] = bytes_read & 0xFF;
+			sipe_media_stream_write(stream, ft_private->buffer,
+						XDATA_HEADER_SIZE + bytes_read);
+			ft_private->bytes_sent += bytes_read;
+		} else if (bytes_read == 0) {
+			/* EOF, write end of stream */
+			gchar *request_id_str;
+
+			request_id_str = g_strdup_printf("%u", ft_private->request_id);
+			write_chunk(stream, SIPE_XDATA_END_OF_STREAM,
+				    strlen(request_id_str), request_id_str);
+			g_free(request_id_str);
+
+			if (ft_private->send_timer) {
+				gdouble elapsed = g_timer_elapsed(ft_private->send_timer,
+								  NULL);
+				SIPE_DEBUG_INFO("send_file_chunk: %" G_GSIZE_FORMAT " bytes in %.3f seconds (%.1f KiB/s)",
+						ft_private->bytes_sent,
+						elapsed,
+						elapsed > 0 ? ft_private->bytes_sent / elapsed / 1024 : 0.0);
+			}
 
-		return FALSE; /* G_SOURCE_REMOVE */
+			ft_private->backend_pipe_write_source_id = 0;
+			return FALSE; /* G_SOURCE_REMOVE */
+		} else {
+			/* Pipe is empty (EAGAIN) */
+			break;
+		}
 	}
 
 	return TRUE; /* G_SOURCE_CONTINUE */
@@ -601,6 +646,9 @@ start_writing(struct sipe_file_transfer_lync *ft_private)
 		    strlen(request_id_str), request_id_str);
 	g_free(request_id_str);
 
+	ft_private->send_timer = g_timer_new();
+	ft_private->bytes_sent = 0;
+
 	channel = g_io_channel_unix_new(ft_private->backend_pipe[0]);
 	ft_private->backend_pipe_write_source_id = g_io_add_watch(channel,
 								  G_IO_IN | G_IO_HUP,
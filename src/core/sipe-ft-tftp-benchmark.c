@@ -0,0 +1,220 @@
+/**
+ * @file sipe-ft-tftp-benchmark.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Throughput benchmark for the receive path of sipe_ft_tftp_read()
+ *
+ * A forked stand-in peer sends RC4 encrypted blocks over a loopback
+ * socket pair. The receiver decrypts them and updates the MAC like
+ * sipe_ft_tftp_read() does, once with the old two buffer path and once
+ * with in-place decryption.
+ *
+ *    $ sipe_ft_tftp_benchmark [<size in MB, default 1024>]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <glib.h>
+
+#include "sipe-common.h" /* coverity[hfa: FALSE] */
+#include "sipe-backend.h"
+#include "sipe-crypt.h"
+#include "sipe-digest.h"
+
+/* same as SIPE_FT_DEFAULT_BLOCK_SIZE in sipe-ft-tftp.c */
+#define BLOCK_SIZE 2045
+
+/*
+ * Stubs
+ */
+gboolean sipe_backend_debug_enabled(void)
+{
+	return(TRUE);
+}
+
+void sipe_backend_debug_literal(sipe_debug_level level,
+				const gchar *msg)
+{
+	printf("DEBUG(%d): %s\n", level, msg);
+}
+
+void sipe_backend_debug(sipe_debug_level level,
+			const gchar *format,
+			...)
+{
+	va_list ap;
+	gchar *newformat = g_strdup_printf("DEBUG(%d): %s\n", level, format);
+
+	va_start(ap, format);
+	vprintf(newformat, ap);
+	va_end(ap);
+
+	g_free(newformat);
+}
+
+/* needed when linking against NSS */
+void md4sum(const guchar *data, gsize length, guchar *digest);
+void md4sum(SIPE_UNUSED_PARAMETER const guchar *data,
+	    SIPE_UNUSED_PARAMETER gsize length,
+	    SIPE_UNUSED_PARAMETER guchar *digest)
+{
+}
+
+/*
+ * Benchmark code
+ */
+static const guchar key[SIPE_DIGEST_SHA1_LENGTH] = {
+	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0x10, 0x32,
+	0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe, 0x00, 0x11, 0x22, 0x33
+};
+
+static void peer(int fd, guint64 total)
+{
+	gpointer cipher = sipe_crypt_ft_start(key);
+	guchar block[BLOCK_SIZE];
+	guint64 sent = 0;
+
+	memset(block, 0x5A, sizeof(block));
+
+	while (sent < total) {
+		gsize length = MIN(total - sent, sizeof(block));
+		guchar encrypted[BLOCK_SIZE];
+		gsize offset = 0;
+
+		sipe_crypt_ft_stream(cipher, block, length, encrypted);
+		while (offset < length) {
+			ssize_t written = write(fd, encrypted + offset,
+						length - offset);
+			if (written <= 0) {
+				perror("write");
+				exit(1);
+			}
+			offset += written;
+		}
+		sent += length;
+	}
+
+	sipe_crypt_ft_destroy(cipher);
+}
+
+static gdouble receive(int fd, guint64 total, gboolean in_place)
+{
+	gpointer cipher = sipe_crypt_ft_start(key);
+	gpointer hmac   = sipe_digest_ft_start(key);
+	GTimer *timer   = g_timer_new();
+	guint64 received = 0;
+	gdouble elapsed;
+
+	while (received < total) {
+		gsize length = MIN(total - received, BLOCK_SIZE);
+		guchar *buffer = g_malloc(length);
+		ssize_t bytes_read = read(fd, buffer, length);
+
+		if (bytes_read <= 0) {
+			perror("read");
+			exit(1);
+		}
+
+		if (in_place) {
+			sipe_crypt_ft_stream(cipher, buffer, bytes_read, buffer);
+			sipe_digest_ft_update(hmac, buffer, bytes_read);
+		} else {
+			guchar *decrypted = g_malloc(bytes_read);
+			sipe_crypt_ft_stream(cipher, buffer, bytes_read, decrypted);
+			sipe_digest_ft_update(hmac, decrypted, bytes_read);
+			g_free(buffer);
+			buffer = decrypted;
+		}
+
+		/* backend takes ownership and frees the buffer */
+		g_free(buffer);
+		received += bytes_read;
+	}
+
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+	sipe_digest_ft_destroy(hmac);
+	sipe_crypt_ft_destroy(cipher);
+
+	return(elapsed);
+}
+
+static void run(guint64 total, gboolean in_place)
+{
+	int fds[2];
+	pid_t pid;
+	gdouble elapsed;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+		perror("socketpair");
+		exit(1);
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		exit(1);
+	} else if (pid == 0) {
+		close(fds[0]);
+		peer(fds[1], total);
+		close(fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	elapsed = receive(fds[0], total, in_place);
+	close(fds[0]);
+	waitpid(pid, NULL, 0);
+
+	printf("%-10s %" G_GUINT64_FORMAT " bytes in %.3f seconds (%.1f MB/s)\n",
+	       in_place ? "in place" : "two buffer",
+	       total, elapsed,
+	       elapsed > 0 ? total / elapsed / (1024 * 1024) : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	guint64 total = (guint64) ((argc > 1) ? atoi(argv[1]) : 1024) * 1024 * 1024;
+
+	sipe_crypto_init(FALSE);
+
+	run(total, FALSE);
+	run(total, TRUE);
+
+	sipe_crypto_shutdown();
+	return(0);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
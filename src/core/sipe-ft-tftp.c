@@ -27,6 +27,7 @@
 #endif
 
 #include <string.h>
+#include <time.h>
 
 #include <glib.h>
 #include <glib/gprintf.h>
@@ -45,6 +46,12 @@
 #define BUFFER_SIZE 50
 #define SIPE_FT_CHUNK_HEADER_LENGTH  3
 
+/* chunk size is a 16-bit value */
+#define SIPE_FT_MAX_BLOCK_SIZE       0xFFFF
+/* When sending data via server with ForeFront installed, block bigger than
+ * this default causes ending of transmission. */
+#define SIPE_FT_DEFAULT_BLOCK_SIZE   2045
+
 static gboolean
 write_exact(struct sipe_file_transfer_private *ft_private, const guchar *data,
 	    gsize size)
@@ -266,6 +273,29 @@ sipe_ft_tftp_stop_receiving(struct sipe_file_transfer *ft)
 	return(TRUE);
 }
 
+/*
+ * There is no way to negotiate the block size with the peer and a too
+ * big block can't be detected before the transfer has been terminated.
+ * Therefore the safe default can only be overridden by the user.
+ */
+static gsize block_size(struct sipe_file_transfer_private *ft_private)
+{
+	struct sipe_core_private *sipe_private = ft_private->sipe_private;
+	const gchar *value = sipe_backend_setting(SIPE_CORE_PUBLIC,
+						  SIPE_SETTING_FT_BLOCK_SIZE);
+	gsize size = SIPE_FT_DEFAULT_BLOCK_SIZE;
+
+	if (!is_empty(value)) {
+		guint64 configured = g_ascii_strtoull(value, NULL, 10);
+
+		if (configured > 0)
+			size = MIN(configured, SIPE_FT_MAX_BLOCK_SIZE);
+	}
+
+	SIPE_DEBUG_INFO("block_size: %" G_GSIZE_FORMAT " bytes", size);
+	return(size);
+}
+
 void
 sipe_ft_tftp_start_sending(struct sipe_file_transfer *ft, gsize total_size)
 {
@@ -332,6 +362,7 @@ sipe_ft_tftp_start_sending(struct sipe_file_transfer *ft, gsize total_size)
 	}
 
 	ft_private->bytes_remaining_chunk = 0;
+	ft_private->block_size     = block_size(ft_private);
 	ft_private->cipher_context = sipe_cipher_context_init(ft_private->encryption_key);
 	ft_private->hmac_context   = sipe_hmac_context_init(ft_private->hash_key);
 }
@@ -426,23 +457,12 @@ sipe_ft_tftp_read(struct sipe_file_transfer *ft, guchar **buffer,
 	}
 
 	if (bytes_read > 0) {
-		guchar *decrypted = g_malloc(bytes_read);
-
-		if (!decrypted) {
-			sipe_backend_ft_error(SIPE_FILE_TRANSFER_PUBLIC, _("Out of memory"));
-			SIPE_DEBUG_ERROR("sipe_core_ft_read: can't allocate %" G_GSIZE_FORMAT " bytes for decryption buffer",
-					 (gsize)bytes_read);
-			g_free(*buffer);
-			*buffer = NULL;
-			return -1;
-		}
+		/* RC4 is a stream cipher: decrypt in place */
 		sipe_crypt_ft_stream(ft_private->cipher_context,
-				     *buffer, bytes_read, decrypted);
-		g_free(*buffer);
-		*buffer = decrypted;
+				     *buffer, bytes_read, *buffer);
 
 		sipe_digest_ft_update(ft_private->hmac_context,
-				      decrypted, bytes_read);
+				      *buffer, bytes_read);
 
 		ft_private->bytes_remaining_chunk -= bytes_read;
 	}
@@ -456,39 +476,42 @@ sipe_ft_tftp_write(struct sipe_file_transfer *ft, const guchar *buffer,
 {
 	struct sipe_file_transfer_private *ft_private = SIPE_FILE_TRANSFER_PRIVATE;
 	gssize bytes_written;
+	gsize header_remaining;
 
-	/* When sending data via server with ForeFront installed, block bigger than
-	 * this default causes ending of transmission. Hard limit block to this value
-	 * when libpurple sends us more data. */
-	const gsize DEFAULT_BLOCK_SIZE = 2045;
-	if (size > DEFAULT_BLOCK_SIZE)
-		size = DEFAULT_BLOCK_SIZE;
+	/* Hard limit block size when libpurple sends us more data. */
+	if (size > ft_private->block_size)
+		size = ft_private->block_size;
 
 	if (ft_private->bytes_remaining_chunk == 0) {
-		gssize bytes_read;
-		guchar local_buf[16 + 1]; /* space for string terminator */
-		guchar hdr_buf[SIPE_FT_CHUNK_HEADER_LENGTH];
+		time_t now = time(NULL);
 
-		/* Check if receiver did not cancel the transfer
-		   before it is finished */
-		bytes_read = sipe_backend_ft_read(SIPE_FILE_TRANSFER_PUBLIC,
-						  local_buf,
-						  sizeof(local_buf) - 1);
-		local_buf[sizeof(local_buf) - 1] = '\0';
+		/* Check once per second if receiver did not cancel the
+		   transfer before it is finished */
+		if (now != ft_private->last_cancel_check) {
+			gssize bytes_read;
+			guchar local_buf[16 + 1]; /* space for string terminator */
 
-		if (bytes_read < 0) {
-			sipe_backend_ft_error(SIPE_FILE_TRANSFER_PUBLIC,
-					      _("Socket read failed"));
-			return -1;
-		} else if ((bytes_read > 0) &&
-			   (g_str_has_prefix((gchar *)local_buf, "CCL\r\n") ||
-			    g_str_has_prefix((gchar *)local_buf, "BYE 2164261682\r\n"))) {
-			return -1;
+			ft_private->last_cancel_check = now;
+			bytes_read = sipe_backend_ft_read(SIPE_FILE_TRANSFER_PUBLIC,
+							  local_buf,
+							  sizeof(local_buf) - 1);
+			local_buf[sizeof(local_buf) - 1] = '\0';
+
+			if (bytes_read < 0) {
+				sipe_backend_ft_error(SIPE_FILE_TRANSFER_PUBLIC,
+						      _("Socket read failed"));
+				return -1;
+			} else if ((bytes_read > 0) &&
+				   (g_str_has_prefix((gchar *)local_buf, "CCL\r\n") ||
+				    g_str_has_prefix((gchar *)local_buf, "BYE 2164261682\r\n"))) {
+				return -1;
+			}
 		}
 
-		if (ft_private->outbuf_size < size) {
+		/* chunk header is sent together with the data */
+		if (ft_private->outbuf_size < SIPE_FT_CHUNK_HEADER_LENGTH + size) {
 			g_free(ft_private->encrypted_outbuf);
-			ft_private->outbuf_size = size;
+			ft_private->outbuf_size = SIPE_FT_CHUNK_HEADER_LENGTH + size;
 			ft_private->encrypted_outbuf = g_malloc(ft_private->outbuf_size);
 			if (!ft_private->encrypted_outbuf) {
 				sipe_backend_ft_error(SIPE_FILE_TRANSFER_PUBLIC,
@@ -499,14 +522,6 @@ sipe_ft_tftp_write(struct sipe_file_transfer *ft, const guchar *buffer,
 			}
 		}
 
-		ft_private->bytes_remaining_chunk = size;
-		ft_private->outbuf_ptr = ft_private->encrypted_outbuf;
-		sipe_crypt_ft_stream(ft_private->cipher_context,
-				     buffer, size,
-				     ft_private->encrypted_outbuf);
-		sipe_digest_ft_update(ft_private->hmac_context,
-				      buffer, size);
-
 		/* chunk header format:
 		 *
 		 *  0:  00   unknown             (always zero?)
@@ -515,18 +530,24 @@ sipe_ft_tftp_write(struct sipe_file_transfer *ft, const guchar *buffer,
 		 *
 		 * Convert size from host order to little endian
 		 */
-		hdr_buf[0] = 0;
-		hdr_buf[1] = (ft_private->bytes_remaining_chunk & 0x00FF);
-		hdr_buf[2] = (ft_private->bytes_remaining_chunk & 0xFF00) >> 8;
-
-		/* write chunk header */
-		if (sipe_backend_ft_write(SIPE_FILE_TRANSFER_PUBLIC, hdr_buf, sizeof(hdr_buf)) != sizeof(hdr_buf)) {
-			sipe_backend_ft_error(SIPE_FILE_TRANSFER_PUBLIC,
-					      _("Socket write failed"));
-			return -1;
-		}
+		ft_private->encrypted_outbuf[0] = 0;
+		ft_private->encrypted_outbuf[1] = (size & 0x00FF);
+		ft_private->encrypted_outbuf[2] = (size & 0xFF00) >> 8;
+
+		ft_private->bytes_remaining_chunk = SIPE_FT_CHUNK_HEADER_LENGTH + size;
+		ft_private->outbuf_ptr = ft_private->encrypted_outbuf;
+		sipe_crypt_ft_stream(ft_private->cipher_context,
+				     buffer, size,
+				     ft_private->encrypted_outbuf + SIPE_FT_CHUNK_HEADER_LENGTH);
+		sipe_digest_ft_update(ft_private->hmac_context,
+				      buffer, size);
 	}
 
+	/* part of the chunk header that hasn't been written yet */
+	header_remaining = SIPE_FT_CHUNK_HEADER_LENGTH -
+		MIN((gsize) (ft_private->outbuf_ptr - ft_private->encrypted_outbuf),
+		    SIPE_FT_CHUNK_HEADER_LENGTH);
+
 	bytes_written = sipe_backend_ft_write(SIPE_FILE_TRANSFER_PUBLIC,
 					      ft_private->outbuf_ptr,
 					      ft_private->bytes_remaining_chunk);
@@ -535,6 +556,12 @@ sipe_ft_tftp_write(struct sipe_file_transfer *ft, const guchar *buffer,
 	} else if (bytes_written > 0) {
 		ft_private->bytes_remaining_chunk -= bytes_written;
 		ft_private->outbuf_ptr += bytes_written;
+
+		/* caller only knows about the data bytes */
+		if ((gsize) bytes_written > header_remaining)
+			bytes_written -= header_remaining;
+		else
+			bytes_written = 0;
 	}
 
 	return bytes_written;
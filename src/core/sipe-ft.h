@@ -53,6 +53,8 @@ struct sipe_file_transfer_private {
 	guchar *encrypted_outbuf;
 	guchar *outbuf_ptr;
 	gsize outbuf_size;
+	gsize block_size;
+	time_t last_cancel_check;
 
 	struct sipe_backend_listendata *listendata;
 };
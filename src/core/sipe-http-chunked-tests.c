@@ -0,0 +1,188 @@
+/**
+ * @file sipe-http-chunked-tests.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Tests for sipe-http-chunked.c */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "sipe-common.h"
+#include "sipe-http-chunked.h"
+
+/* test helpers */
+static guint succeeded = 0;
+static guint failed    = 0;
+
+static void append_cb(const gchar *data,
+		      gsize length,
+		      gpointer user_data)
+{
+	g_string_append_len(user_data, data, length);
+}
+
+/*
+ * Feed input in pieces of "step" bytes. Unconsumed input is passed in
+ * again with the next piece, like the transport does with its buffer.
+ */
+static void assert_decode(const gchar *name,
+			  const gchar *input,
+			  gsize step,
+			  guint expected_result,
+			  const gchar *expected_body,
+			  gsize expected_unused)
+{
+	struct sipe_http_chunked chunked;
+	GString *body  = g_string_new("");
+	gsize length   = strlen(input);
+	gsize offset   = 0;
+	gsize received = 0;
+	guint result   = SIPE_HTTP_CHUNKED_INCOMPLETE;
+
+	sipe_http_chunked_init(&chunked);
+
+	while (received < length) {
+		gsize used;
+
+		received = MIN(received + step, length);
+		result   = sipe_http_chunked_decode(&chunked,
+						    input + offset,
+						    received - offset,
+						    &used,
+						    append_cb,
+						    body);
+		offset  += used;
+
+		if (result != SIPE_HTTP_CHUNKED_INCOMPLETE)
+			break;
+	}
+
+	if ((result == expected_result) &&
+	    ((result == SIPE_HTTP_CHUNKED_ERROR) ||
+	     ((strcmp(body->str, expected_body) == 0) &&
+	      (length - offset == expected_unused)))) {
+		succeeded++;
+	} else {
+		printf("[%s/%" G_GSIZE_FORMAT "]\nchunked decode FAILED: result %d (expected %d) body '%s' (expected '%s') unused %" G_GSIZE_FORMAT " (expected %" G_GSIZE_FORMAT ")\n",
+		       name, step,
+		       result, expected_result,
+		       body->str, expected_body ? expected_body : "",
+		       length - offset, expected_unused);
+		failed++;
+	}
+
+	g_string_free(body, TRUE);
+}
+
+/* every test case is also run with input split at every possible position */
+static void assert_all_steps(const gchar *name,
+			     const gchar *input,
+			     guint expected_result,
+			     const gchar *expected_body,
+			     gsize expected_unused)
+{
+	gsize step;
+	for (step = 1; step <= strlen(input); step++)
+		assert_decode(name, input, step,
+			      expected_result, expected_body, expected_unused);
+}
+
+int main(SIPE_UNUSED_PARAMETER int argc, SIPE_UNUSED_PARAMETER char **argv)
+{
+	/* simple */
+	assert_all_steps("simple",
+			 "5\r\nhello\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "hello", 0);
+	assert_all_steps("multiple",
+			 "5\r\nhello\r\n1\r\n \r\nA\r\n0123456789\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "hello 0123456789", 0);
+	assert_all_steps("empty",
+			 "0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "", 0);
+	assert_all_steps("hex",
+			 "1a\r\nabcdefghijklmnopqrstuvwxyz\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "abcdefghijklmnopqrstuvwxyz", 0);
+
+	/* chunk data containing line breaks */
+	assert_all_steps("CRLF in data",
+			 "4\r\n\r\n\r\n\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "\r\n\r\n", 0);
+
+	/* chunk extensions */
+	assert_all_steps("extension",
+			 "5;name=value\r\nhello\r\n0;last\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "hello", 0);
+	assert_all_steps("extension with white space",
+			 "5 ;name=\"a b\"\r\nhello\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "hello", 0);
+
+	/* trailers */
+	assert_all_steps("trailer",
+			 "5\r\nhello\r\n0\r\nExpires: never\r\nX-Test: 1\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_COMPLETE, "hello", 0);
+
+	/* next message in buffer is not consumed */
+	assert_decode("pipelined",
+		      "5\r\nhello\r\n0\r\n\r\nHTTP/1.1 200 OK\r\n", 1000,
+		      SIPE_HTTP_CHUNKED_COMPLETE, "hello", 17);
+
+	/* incomplete */
+	assert_decode("incomplete data",
+		      "5\r\nhel", 1000,
+		      SIPE_HTTP_CHUNKED_INCOMPLETE, "hel", 0);
+	assert_decode("incomplete size",
+		      "5\r\nhello\r\n1", 1000,
+		      SIPE_HTTP_CHUNKED_INCOMPLETE, "hello", 1);
+	assert_decode("incomplete trailer",
+		      "5\r\nhello\r\n0\r\nX-Test: 1\r\n", 1000,
+		      SIPE_HTTP_CHUNKED_INCOMPLETE, "hello", 0);
+
+	/* illegal */
+	assert_all_steps("illegal size",
+			 "x\r\nhello\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_ERROR, NULL, 0);
+	assert_all_steps("negative size",
+			 "-5\r\nhello\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_ERROR, NULL, 0);
+	assert_all_steps("garbage after size",
+			 "5x\r\nhello\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_ERROR, NULL, 0);
+	assert_all_steps("huge size",
+			 "FFFFFFFFFFFFFFFF\r\nhello\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_ERROR, NULL, 0);
+	assert_all_steps("missing CRLF after data",
+			 "5\r\nhelloX\r\n0\r\n\r\n",
+			 SIPE_HTTP_CHUNKED_ERROR, NULL, 0);
+
+	printf("Result: %d PASSED %d FAILED\n", succeeded, failed);
+	return(failed);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
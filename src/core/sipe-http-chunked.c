@@ -0,0 +1,153 @@
+/**
+ * @file sipe-http-chunked.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * RFC 7230 4.1:
+ *
+ *   chunked-body = *chunk last-chunk trailer-part CRLF
+ *   chunk        = chunk-size [ chunk-ext ] CRLF chunk-data CRLF
+ *   last-chunk   = 1*("0") [ chunk-ext ] CRLF
+ *   trailer-part = *( header-field CRLF )
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "sipe-http-chunked.h"
+
+/*
+ * no sane server sends chunks larger than this. The limit must also
+ * leave room for the trailing CRLF in remainder on 32-bit targets.
+ */
+#define SIPE_HTTP_CHUNKED_MAX_SIZE MIN(G_GUINT64_CONSTANT(0xFFFFFFFF), \
+				       (guint64) (G_MAXSIZE - 2))
+/* size and trailer lines are short */
+#define SIPE_HTTP_CHUNKED_MAX_LINE 4096
+
+static const gchar *find_crlf(const gchar *data,
+			      const gchar *end)
+{
+	while (data + 1 < end) {
+		const gchar *cr = memchr(data, '\r', end - data - 1);
+		if (!cr)
+			break;
+		if (cr[1] == '\n')
+			return(cr);
+		data = cr + 1;
+	}
+	return(NULL);
+}
+
+void sipe_http_chunked_init(struct sipe_http_chunked *chunked)
+{
+	chunked->remainder = 0;
+	chunked->trailer   = FALSE;
+}
+
+guint sipe_http_chunked_decode(struct sipe_http_chunked *chunked,
+			       const gchar *data,
+			       gsize length,
+			       gsize *consumed,
+			       sipe_http_chunked_cb *callback,
+			       gpointer user_data)
+{
+	const gchar *current = data;
+	const gchar *end     = data + length;
+	guint result         = SIPE_HTTP_CHUNKED_INCOMPLETE;
+
+	while ((result == SIPE_HTTP_CHUNKED_INCOMPLETE) && (current < end)) {
+
+		if (chunked->remainder > 2) {
+			gsize decoded = MIN((gsize) (end - current),
+					    chunked->remainder - 2);
+
+			(*callback)(current, decoded, user_data);
+			chunked->remainder -= decoded;
+			current            += decoded;
+
+		} else if (chunked->remainder) {
+			/* chunk data is followed by CRLF */
+			if (*current != ((chunked->remainder == 2) ? '\r' : '\n')) {
+				result = SIPE_HTTP_CHUNKED_ERROR;
+				break;
+			}
+			chunked->remainder--;
+			current++;
+
+		} else {
+			const gchar *line_end = find_crlf(current, end);
+
+			/* line not finished yet */
+			if (!line_end) {
+				if ((gsize) (end - current) > SIPE_HTTP_CHUNKED_MAX_LINE)
+					result = SIPE_HTTP_CHUNKED_ERROR;
+				break;
+			}
+
+			if (chunked->trailer) {
+				/* empty line terminates trailer */
+				if (line_end == current)
+					result = SIPE_HTTP_CHUNKED_COMPLETE;
+
+			} else {
+				gchar *tmp;
+				guint64 size;
+
+				/* strtoull() would also accept white space and sign */
+				if (!g_ascii_isxdigit(*current)) {
+					result = SIPE_HTTP_CHUNKED_ERROR;
+					break;
+				}
+
+				size = g_ascii_strtoull(current, &tmp, 16);
+
+				/* only chunk extensions may follow the size */
+				if ((size > SIPE_HTTP_CHUNKED_MAX_SIZE) ||
+				    ((tmp != line_end) &&
+				     (*tmp != ';') && (*tmp != ' ') && (*tmp != '\t'))) {
+					result = SIPE_HTTP_CHUNKED_ERROR;
+					break;
+				}
+
+				if (size == 0)
+					chunked->trailer   = TRUE;
+				else
+					chunked->remainder = (gsize) size + 2;
+			}
+
+			current = line_end + 2;
+		}
+	}
+
+	*consumed = current - data;
+	return(result);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
@@ -0,0 +1,91 @@
+/**
+ * @file sipe-http-chunked.h
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * HTTP/1.1 Transfer-Encoding: chunked decoder
+ *
+ * The decoder is resumable, i.e. input can be passed in any number of
+ * pieces and is never scanned twice.
+ *
+ * Interface dependencies:
+ *
+ * <glib.h>
+ */
+
+/* decoder result */
+#define SIPE_HTTP_CHUNKED_INCOMPLETE 0
+#define SIPE_HTTP_CHUNKED_COMPLETE   1
+#define SIPE_HTTP_CHUNKED_ERROR      2
+
+struct sipe_http_chunked {
+	gsize remainder;     /* chunk data + CRLF, 0 -> chunk size line */
+	gboolean trailer;    /* last chunk seen, skipping trailer lines */
+};
+
+/**
+ * Decoded data callback
+ *
+ * @param data      decoded data (not zero terminated)
+ * @param length    length of the data
+ * @param user_data callback data
+ */
+typedef void (sipe_http_chunked_cb)(const gchar *data,
+				    gsize length,
+				    gpointer user_data);
+
+/**
+ * Initialize decoder state
+ *
+ * @param chunked decoder state
+ */
+void sipe_http_chunked_init(struct sipe_http_chunked *chunked);
+
+/**
+ * Decode input
+ *
+ * @param chunked   decoder state
+ * @param data      input
+ * @param length    length of the input
+ * @param consumed  returns the number of input bytes that have been
+ *                  processed. The remaining input must be passed in
+ *                  again together with the next input.
+ * @param callback  function to call for decoded data
+ * @param user_data callback data
+ *
+ * @return decoder result
+ */
+guint sipe_http_chunked_decode(struct sipe_http_chunked *chunked,
+			       const gchar *data,
+			       gsize length,
+			       gsize *consumed,
+			       sipe_http_chunked_cb *callback,
+			       gpointer user_data);
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
@@ -71,6 +71,7 @@ struct sipe_http_request {
 	const gchar *password; /* not copied */
 
 	sipe_http_response_callback *cb;
+	sipe_http_body_callback *stream_cb; /* NULL -> collect body */
 	gpointer cb_data;
 
 	guint32 flags;
@@ -517,9 +518,68 @@ void sipe_http_request_response(struct sipe_http_connection_public *conn_public,
 	}
 }
 
+gboolean sipe_http_request_stream_start(struct sipe_http_connection_public *conn_public,
+					struct sipmsg *msg)
+{
+	struct sipe_http_request *req = conn_public->pending_requests->data;
+
+	if (req->stream_cb                              &&
+	    (msg->response >= SIPE_HTTP_STATUS_OK)       &&
+	    (msg->response <  SIPE_HTTP_STATUS_REDIRECTION)) {
+		conn_public->streaming = req;
+		return(TRUE);
+	}
+
+	return(FALSE);
+}
+
+void sipe_http_request_stream_data(struct sipe_http_connection_public *conn_public,
+				   struct sipmsg *msg,
+				   const gchar *data,
+				   gsize length)
+{
+	struct sipe_http_request *req = conn_public->streaming;
+
+	/* request has been cancelled: discard rest of body */
+	if (!req)
+		return;
+
+	if (!(*req->stream_cb)(conn_public->sipe_private,
+			       msg->headers,
+			       data,
+			       length,
+			       req->cb_data) &&
+	    /* callback might have cancelled the request */
+	    (conn_public->streaming == req)) {
+		SIPE_DEBUG_INFO_NOFORMAT("sipe_http_request_stream_data: aborted by callback");
+
+		/* Callback: request failed */
+		(*req->cb)(conn_public->sipe_private,
+			   SIPE_HTTP_STATUS_FAILED,
+			   msg->headers,
+			   NULL,
+			   req->cb_data);
+
+		/* remove failed request */
+		sipe_http_request_cancel(req);
+	}
+}
+
+void sipe_http_request_stream_end(struct sipe_http_connection_public *conn_public,
+				  struct sipmsg *msg)
+{
+	if (conn_public->streaming) {
+		conn_public->streaming = NULL;
+		sipe_http_request_response(conn_public, msg);
+	} else
+		SIPE_DEBUG_INFO_NOFORMAT("sipe_http_request_stream_end: request has been cancelled, discarding response");
+}
+
 void sipe_http_request_shutdown(struct sipe_http_connection_public *conn_public,
 				gboolean abort)
 {
+	conn_public->streaming = NULL;
+
 	if (conn_public->pending_requests) {
 		GSList *entry = conn_public->pending_requests;
 		while (entry) {
@@ -624,6 +684,10 @@ void sipe_http_request_cancel(struct sipe_http_request *request)
 	conn_public->pending_requests = g_slist_remove(conn_public->pending_requests,
 						       request);
 
+	/* rest of streamed body will be discarded */
+	if (conn_public->streaming == request)
+		conn_public->streaming = NULL;
+
 	/* cancelled by requester, don't use callback */
 	request->cb = NULL;
 
@@ -638,6 +702,12 @@ void sipe_http_request_session(struct sipe_http_request *request,
 	request->session = session;
 }
 
+void sipe_http_request_stream(struct sipe_http_request *request,
+			      sipe_http_body_callback *callback)
+{
+	request->stream_cb = callback;
+}
+
 void sipe_http_request_allow_redirect(struct sipe_http_request *request)
 {
 	request->flags |= SIPE_HTTP_REQUEST_FLAG_REDIRECT;
@@ -85,6 +85,40 @@ void sipe_http_request_next(struct sipe_http_connection_public *conn_public);
 void sipe_http_request_response(struct sipe_http_connection_public *conn_public,
 				struct sipmsg *msg);
 
+/**
+ * HTTP response header received, check if body should be streamed
+ *
+ * @param conn_public HTTP connection public data
+ * @param msg         parsed message header
+ *
+ * @return @c TRUE if body should be passed on with
+ *         @c sipe_http_request_stream_data()
+ */
+gboolean sipe_http_request_stream_start(struct sipe_http_connection_public *conn_public,
+					struct sipmsg *msg);
+
+/**
+ * HTTP response body segment received
+ *
+ * @param conn_public HTTP connection public data
+ * @param msg         parsed message header
+ * @param data        body segment
+ * @param length      length of the segment
+ */
+void sipe_http_request_stream_data(struct sipe_http_connection_public *conn_public,
+				   struct sipmsg *msg,
+				   const gchar *data,
+				   gsize length);
+
+/**
+ * HTTP response with streamed body completed
+ *
+ * @param conn_public HTTP connection public data
+ * @param msg         parsed message (body is empty)
+ */
+void sipe_http_request_stream_end(struct sipe_http_connection_public *conn_public,
+				  struct sipmsg *msg);
+
 /**
  * HTTP connection shutdown
  *
@@ -39,6 +39,7 @@
 #include "sipe-core.h"
 #include "sipe-core-private.h"
 #include "sipe-http.h"
+#include "sipe-http-chunked.h"
 #include "sipe-schedule.h"
 #include "sipe-utils.h"
 
@@ -62,6 +63,19 @@ struct sipe_http_connection {
 	gchar *host_port;
 	time_t timeout;  /* in seconds from epoch */
 	gboolean use_tls;
+
+	/*
+	 * Response body in progress: chunked or streamed
+	 *
+	 * Data is moved from the receive buffer as soon as it arrives, i.e.
+	 * input is never scanned twice.
+	 */
+	struct sipmsg *body_msg;    /* != NULL -> body in progress */
+	gchar *body_header;         /* for debugging output */
+	GString *body;              /* NULL -> passed on to request */
+	gsize body_remainder;       /* not chunked: body data */
+	gboolean chunked;
+	struct sipe_http_chunked decoder;
 };
 
 struct sipe_http {
@@ -79,6 +93,21 @@ static gint timeout_compare(gconstpointer a,
 	       ((struct sipe_http_connection *) b)->timeout);
 }
 
+static void sipe_http_transport_body_reset(struct sipe_http_connection *conn)
+{
+	if (conn->body_msg) {
+		sipmsg_free(conn->body_msg);
+		g_free(conn->body_header);
+		if (conn->body)
+			g_string_free(conn->body, TRUE);
+		conn->body_msg    = NULL;
+		conn->body_header = NULL;
+		conn->body        = NULL;
+	}
+	conn->body_remainder = 0;
+	sipe_http_chunked_init(&conn->decoder);
+}
+
 static void sipe_http_transport_update_timeout_queue(struct sipe_http_connection *conn,
 						     gboolean remove);
 static void sipe_http_transport_free(gpointer data)
@@ -91,6 +120,7 @@ static void sipe_http_transport_free(gpointer data)
 	if (conn->connection)
 		sipe_backend_transport_disconnect(conn->connection);
 	conn->connection = NULL;
+	sipe_http_transport_body_reset(conn);
 
 	sipe_http_transport_update_timeout_queue(conn, TRUE);
 
@@ -263,11 +293,158 @@ static void sipe_http_transport_connected(struct sipe_transport_connection *conn
 	sipe_http_request_next(SIPE_HTTP_CONNECTION_PUBLIC);
 }
 
+static void sipe_http_transport_message(struct sipe_http_connection *conn,
+					struct sipmsg *msg,
+					gboolean streamed)
+{
+	gboolean drop = FALSE;
+	gboolean next;
+
+	if (msg->response == SIPMSG_RESPONSE_FATAL_ERROR) {
+		/* fatal header parse error */
+		msg->response = SIPE_HTTP_STATUS_SERVER_ERROR;
+		drop          = TRUE;
+	} else if (sipe_strcase_equal(sipmsg_find_header(msg, "Connection"), "close")) {
+		SIPE_DEBUG_INFO("sipe_http_transport_message: server requested close '%s'",
+				conn->host_port);
+		drop          = TRUE;
+	}
+
+	if (streamed)
+		sipe_http_request_stream_end(SIPE_HTTP_CONNECTION_PUBLIC, msg);
+	else
+		sipe_http_request_response(SIPE_HTTP_CONNECTION_PUBLIC, msg);
+	next = sipe_http_request_pending(SIPE_HTTP_CONNECTION_PUBLIC);
+
+	if (drop) {
+		/* drop backend connection */
+		sipe_backend_transport_disconnect(conn->connection);
+		conn->connection       = NULL;
+		conn->public.connected = FALSE;
+		sipe_http_transport_body_reset(conn);
+
+		/* if we have pending requests we need to trigger re-connect */
+		if (next)
+			sipe_http_transport_new(conn->public.sipe_private,
+						conn->public.host,
+						conn->public.port,
+						conn->use_tls);
+
+	} else if (next) {
+		/* trigger sending of next pending request */
+		sipe_http_request_next(SIPE_HTTP_CONNECTION_PUBLIC);
+	}
+
+	sipmsg_free(msg);
+}
+
+static void sipe_http_transport_body_append(struct sipe_http_connection *conn,
+					    const gchar *data,
+					    gsize length)
+{
+	if (length == 0)
+		return;
+
+	if (conn->body)
+		g_string_append_len(conn->body, data, length);
+	else
+		sipe_http_request_stream_data(SIPE_HTTP_CONNECTION_PUBLIC,
+					      conn->body_msg,
+					      data,
+					      length);
+}
+
+static void sipe_http_transport_chunk_cb(const gchar *data,
+					 gsize length,
+					 gpointer user_data)
+{
+	sipe_http_transport_body_append(user_data, data, length);
+}
+
+/*
+ * Process as much of the body as is available in the buffer
+ *
+ * Returns the message when the body is complete, NULL otherwise.
+ */
+static struct sipmsg *sipe_http_transport_body(struct sipe_transport_connection *connection,
+					       struct sipe_http_connection *conn)
+{
+	gchar *current     = connection->buffer;
+	const gchar *end   = connection->buffer + connection->buffer_used;
+	gboolean complete  = FALSE;
+	struct sipmsg *msg = NULL;
+
+	if (!conn->chunked) {
+		gsize used = MIN((gsize) (end - current), conn->body_remainder);
+
+		sipe_http_transport_body_append(conn, current, used);
+		conn->body_remainder -= used;
+		current              += used;
+		complete              = (conn->body_remainder == 0);
+	}
+
+	if (conn->chunked) {
+		gsize used;
+		guint result = sipe_http_chunked_decode(&conn->decoder,
+							current,
+							end - current,
+							&used,
+							sipe_http_transport_chunk_cb,
+							conn);
+
+		current += used;
+		if (result == SIPE_HTTP_CHUNKED_ERROR) {
+			SIPE_DEBUG_ERROR_NOFORMAT("sipe_http_transport_body: illegal chunked body");
+			conn->body_msg->response = SIPMSG_RESPONSE_FATAL_ERROR;
+			current  = (gchar *) end;
+			complete = TRUE;
+		} else
+			complete = (result == SIPE_HTTP_CHUNKED_COMPLETE);
+	}
+
+	/* processed input is no longer needed */
+	sipe_utils_shrink_buffer(connection, current);
+
+	if (complete) {
+		msg = conn->body_msg;
+		if (conn->body) {
+			msg->bodylen = conn->body->len;
+			msg->body    = g_string_free(conn->body, FALSE);
+		} else {
+			/* body has already been passed on */
+			msg->bodylen = 0;
+			msg->body    = g_strdup("");
+		}
+		sipe_utils_message_debug("HTTP",
+					 conn->body_header,
+					 msg->body,
+					 FALSE);
+		g_free(conn->body_header);
+		conn->body_msg    = NULL;
+		conn->body_header = NULL;
+		conn->body        = NULL;
+	}
+
+	return(msg);
+}
+
 static void sipe_http_transport_input(struct sipe_transport_connection *connection)
 {
 	struct sipe_http_connection *conn = SIPE_HTTP_CONNECTION;
 	char *current = connection->buffer;
 
+	if (!conn->connection)
+		return;
+
+	/* continue body in progress */
+	if (conn->body_msg) {
+		gboolean streamed  = (conn->body == NULL);
+		struct sipmsg *msg = sipe_http_transport_body(connection, conn);
+		if (msg)
+			sipe_http_transport_message(conn, msg, streamed);
+		return;
+	}
+
 	/* according to the RFC remove CRLF at the beginning */
 	while (*current == '\r' || *current == '\n') {
 		current++;
@@ -275,11 +452,10 @@ static void sipe_http_transport_input(struct sipe_transport_connection *connecti
 	if (current != connection->buffer)
 		sipe_utils_shrink_buffer(connection, current);
 
-	if (conn->connection &&
-	    (current = strstr(connection->buffer, "\r\n\r\n")) != NULL) {
+	if ((current = strstr(connection->buffer, "\r\n\r\n")) != NULL) {
 		struct sipmsg *msg;
-		gboolean drop = FALSE;
-		gboolean next;
+		gboolean chunked;
+		gboolean streamed;
 
 		current += 2;
 		current[0] = '\0';
@@ -291,84 +467,27 @@ static void sipe_http_transport_input(struct sipe_transport_connection *connecti
 		}
 
 		/* HTTP/1.1 Transfer-Encoding: chunked */
-		if (msg->bodylen == SIPMSG_BODYLEN_CHUNKED) {
-			gchar *start        = current + 2;
-			GSList *chunks      = NULL;
-			gboolean incomplete = TRUE;
-
-			msg->bodylen = 0;
-			while (strlen(start) > 0) {
-				gchar *tmp;
-				guint length = g_ascii_strtoll(start, &tmp, 16);
-				guint remainder;
-				struct _chunk {
-					guint length;
-					const gchar *start;
-				} *chunk;
-
-				/* Illegal number */
-				if ((length == 0) && (start == tmp))
-					break;
-				msg->bodylen += length;
-
-				/* Chunk header not finished yet */
-				tmp = strstr(tmp, "\r\n");
-				if (tmp == NULL)
-					break;
-
-				/* Chunk not finished yet */
-				tmp += 2;
-				remainder = connection->buffer_used - (tmp - connection->buffer);
-				if (remainder < length + 2)
-					break;
-
-				/* Next chunk */
-				start = tmp + length + 2;
-
-				/* Body completed */
-				if (length == 0) {
-					gchar *dummy  = g_malloc(msg->bodylen + 1);
-					gchar *p      = dummy;
-					GSList *entry = chunks;
-
-					while (entry) {
-						chunk = entry->data;
-						memcpy(p, chunk->start, chunk->length);
-						p += chunk->length;
-						entry = entry->next;
-					}
-					p[0] = '\0';
-
-					msg->body = dummy;
-					sipe_utils_message_debug("HTTP",
-								 connection->buffer,
-								 msg->body,
-								 FALSE);
-
-					current = start;
-					sipe_utils_shrink_buffer(connection,
-								 current);
-
-					incomplete = FALSE;
-					break;
-				}
-
-				/* Append completed chunk */
-				chunk = g_new0(struct _chunk, 1);
-				chunk->length = length;
-				chunk->start  = tmp;
-				chunks = g_slist_append(chunks, chunk);
-			}
-
-			if (chunks)
-				sipe_utils_slist_free_full(chunks, g_free);
-
-			if (incomplete) {
-				/* restore header for next try */
-				sipmsg_free(msg);
-				current[0] = '\r';
+		chunked  = (msg->bodylen == SIPMSG_BODYLEN_CHUNKED);
+		streamed = (msg->response != SIPMSG_RESPONSE_FATAL_ERROR) &&
+			(chunked || (msg->bodylen >= 0))                  &&
+			sipe_http_request_stream_start(SIPE_HTTP_CONNECTION_PUBLIC,
+						       msg);
+
+		if (chunked || streamed) {
+			conn->body_msg       = msg;
+			conn->body_header    = g_strdup(connection->buffer);
+			conn->body           = streamed ? NULL : g_string_new("");
+			conn->body_remainder = chunked ? 0 : (gsize) msg->bodylen;
+			conn->chunked        = chunked;
+			sipe_http_chunked_init(&conn->decoder);
+			msg->bodylen         = 0;
+
+			/* header has been processed */
+			sipe_utils_shrink_buffer(connection, current + 2);
+
+			msg = sipe_http_transport_body(connection, conn);
+			if (!msg)
 				return;
-			}
 
 		} else {
 			guint remainder = connection->buffer_used - (current + 2 - connection->buffer);
@@ -386,8 +505,11 @@ static void sipe_http_transport_input(struct sipe_transport_connection *connecti
 							 FALSE);
 				sipe_utils_shrink_buffer(connection, current);
 			} else {
-				SIPE_DEBUG_INFO("sipe_http_transport_input: body too short (%d < %d, strlen %" G_GSIZE_FORMAT ") - ignoring message",
-						remainder, msg->bodylen, strlen(connection->buffer));
+				SIPE_DEBUG_INFO("sipe_http_transport_input: body too short (%d < %d) - ignoring message",
+						remainder, msg->bodylen);
+				sipe_utils_buffer_hint(connection,
+						       current + 2,
+						       msg->bodylen);
 
 				/* restore header for next try */
 				sipmsg_free(msg);
@@ -396,38 +518,7 @@ static void sipe_http_transport_input(struct sipe_transport_connection *connecti
 			}
 		}
 
-		if (msg->response == SIPMSG_RESPONSE_FATAL_ERROR) {
-			/* fatal header parse error */
-			msg->response = SIPE_HTTP_STATUS_SERVER_ERROR;
-			drop          = TRUE;
-		} else if (sipe_strcase_equal(sipmsg_find_header(msg, "Connection"), "close")) {
-			SIPE_DEBUG_INFO("sipe_http_transport_input: server requested close '%s'",
-					conn->host_port);
-			drop          = TRUE;
-		}
-
-		sipe_http_request_response(SIPE_HTTP_CONNECTION_PUBLIC, msg);
-		next = sipe_http_request_pending(SIPE_HTTP_CONNECTION_PUBLIC);
-
-		if (drop) {
-			/* drop backend connection */
-			sipe_backend_transport_disconnect(conn->connection);
-			conn->connection       = NULL;
-			conn->public.connected = FALSE;
-
-			/* if we have pending requests we need to trigger re-connect */
-			if (next)
-				sipe_http_transport_new(conn->public.sipe_private,
-							conn->public.host,
-							conn->public.port,
-							conn->use_tls);
-
-		} else if (next) {
-			/* trigger sending of next pending request */
-			sipe_http_request_next(SIPE_HTTP_CONNECTION_PUBLIC);
-		}
-
-		sipmsg_free(msg);
+		sipe_http_transport_message(conn, msg, streamed);
 	}
 }
 
@@ -516,13 +607,22 @@ void sipe_http_transport_send(struct sipe_http_connection_public *conn_public,
 			      const gchar *body)
 {
 	struct sipe_http_connection *conn = SIPE_HTTP_CONNECTION_PRIVATE;
-	GString *message = g_string_new(header);
-
-	g_string_append_printf(message, "\r\n%s", body ? body : "");
+	/* header, empty line, body: no need to copy the body */
+	struct sipe_transport_part parts[3] = {
+		{ NULL,   0 },
+		{ "\r\n", 2 },
+		{ NULL,   0 },
+	};
+
+	parts[0].data   = header;
+	parts[0].length = strlen(header);
+	if (body) {
+		parts[2].data   = body;
+		parts[2].length = strlen(body);
+	}
 
-	sipe_utils_message_debug("HTTP", message->str, NULL, TRUE);
-	sipe_backend_transport_message(conn->connection, message->str);
-	g_string_free(message, TRUE);
+	sipe_utils_message_debug("HTTP", header, body, TRUE);
+	sipe_backend_transport_message(conn->connection, parts, 3);
 
 	sipe_http_transport_update_timeout_queue(conn, FALSE);
 }
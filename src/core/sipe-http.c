@@ -25,13 +25,28 @@
  *
  *  - convenience functions for public API: GET & POST requests
  *  - URL parsing
+ *  - response cache
  *  - all other public API functions are implemented by lower layers
+ *
+ *
+ * Response cache entry format (persistent cache section "http"):
+ *
+ *   key "<URI>" value "<fresh until>\n<ETag>\n<Last-Modified>\n<body>"
+ *
+ * The entry lives longer than its freshness period, so that an outdated
+ * response can be revalidated with a conditional request.
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #include <glib.h>
 
 #include "sipe-backend.h"
+#include "sipe-cache.h"
 #include "sipe-http.h"
+#include "sipe-utils.h"
 
 #define _SIPE_HTTP_PRIVATE_IF_REQUEST
 #include "sipe-http-request.h"
@@ -148,6 +163,175 @@ struct sipe_http_request *sipe_http_request_post(struct sipe_core_private *sipe_
 	return(req);
 }
 
+#define SIPE_HTTP_CACHE_SECTION   "http"
+#define SIPE_HTTP_CACHE_FRESHNESS (24 * 60 * 60)     /* seconds */
+#define SIPE_HTTP_CACHE_LIFETIME  (7 * 24 * 60 * 60) /* seconds */
+
+/* caller must g_strfreev() fields */
+static gchar **sipe_http_cache_entry(struct sipe_core_private *sipe_private,
+				     const gchar *uri)
+{
+	const gchar *value = sipe_cache_get(sipe_private,
+					    SIPE_HTTP_CACHE_SECTION,
+					    uri);
+	gchar **fields = NULL;
+
+	if (value) {
+		fields = g_strsplit(value, "\n", 4);
+
+		/* corrupted entry */
+		if (g_strv_length(fields) != 4) {
+			g_strfreev(fields);
+			fields = NULL;
+			sipe_cache_remove(sipe_private,
+					  SIPE_HTTP_CACHE_SECTION,
+					  uri);
+		}
+	}
+
+	return(fields);
+}
+
+static void sipe_http_cache_store(struct sipe_core_private *sipe_private,
+				  const gchar *uri,
+				  time_t fresh_until,
+				  const gchar *etag,
+				  const gchar *last_modified,
+				  const gchar *body)
+{
+	gchar *value = g_strdup_printf("%" G_GUINT64_FORMAT "\n%s\n%s\n%s",
+				       (guint64) fresh_until,
+				       etag ? etag : "",
+				       last_modified ? last_modified : "",
+				       body);
+	sipe_cache_set(sipe_private,
+		       SIPE_HTTP_CACHE_SECTION,
+		       uri,
+		       value,
+		       SIPE_HTTP_CACHE_LIFETIME);
+	g_free(value);
+}
+
+/* returns 0 if response must not be stored */
+static time_t sipe_http_cache_freshness(GSList *headers)
+{
+	const gchar *cache_control = sipe_utils_nameval_find(headers,
+							     "Cache-Control");
+	time_t freshness = SIPE_HTTP_CACHE_FRESHNESS;
+
+	if (cache_control) {
+		const gchar *max_age = strstr(cache_control, "max-age=");
+
+		if (strstr(cache_control, "no-store"))
+			return(0);
+		if (strstr(cache_control, "no-cache"))
+			/* store, but always revalidate */
+			freshness = 0;
+		else if (max_age)
+			freshness = strtoul(max_age + 8, NULL, 10);
+	}
+
+	return(time(NULL) + MIN(freshness, SIPE_HTTP_CACHE_LIFETIME));
+}
+
+gboolean sipe_http_cache_fresh(struct sipe_core_private *sipe_private,
+			       const gchar *uri)
+{
+	gchar **fields = sipe_http_cache_entry(sipe_private, uri);
+	gboolean fresh = FALSE;
+
+	if (fields) {
+		fresh = g_ascii_strtoull(fields[0], NULL, 10) > (guint64) time(NULL);
+		g_strfreev(fields);
+	}
+
+	return(fresh);
+}
+
+gchar *sipe_http_cache_body(struct sipe_core_private *sipe_private,
+			    const gchar *uri)
+{
+	gchar **fields = sipe_http_cache_entry(sipe_private, uri);
+	gchar *body = NULL;
+
+	if (fields) {
+		body = g_strdup(fields[3]);
+		g_strfreev(fields);
+	}
+
+	return(body);
+}
+
+gchar *sipe_http_cache_headers(struct sipe_core_private *sipe_private,
+			       const gchar *uri)
+{
+	gchar **fields = sipe_http_cache_entry(sipe_private, uri);
+	GString *headers;
+
+	if (!fields)
+		return(NULL);
+
+	headers = g_string_new("");
+	if (*fields[1])
+		g_string_append_printf(headers, "If-None-Match: %s\r\n",
+				       fields[1]);
+	if (*fields[2])
+		g_string_append_printf(headers, "If-Modified-Since: %s\r\n",
+				       fields[2]);
+	g_strfreev(fields);
+
+	/* without validators the server can't answer "Not Modified" */
+	if (headers->len == 0) {
+		g_string_free(headers, TRUE);
+		return(NULL);
+	}
+
+	return(g_string_free(headers, FALSE));
+}
+
+void sipe_http_cache_update(struct sipe_core_private *sipe_private,
+			    const gchar *uri,
+			    guint status,
+			    GSList *headers,
+			    const gchar *body)
+{
+	if ((status == SIPE_HTTP_STATUS_OK) && body) {
+		time_t fresh_until = sipe_http_cache_freshness(headers);
+
+		if (fresh_until)
+			sipe_http_cache_store(sipe_private,
+					      uri,
+					      fresh_until,
+					      sipe_utils_nameval_find(headers, "ETag"),
+					      sipe_utils_nameval_find(headers, "Last-Modified"),
+					      body);
+		else
+			sipe_cache_remove(sipe_private,
+					  SIPE_HTTP_CACHE_SECTION,
+					  uri);
+
+	} else if (status == SIPE_HTTP_STATUS_NOT_MODIFIED) {
+		gchar **fields = sipe_http_cache_entry(sipe_private, uri);
+
+		if (fields) {
+			time_t fresh_until = sipe_http_cache_freshness(headers);
+
+			SIPE_DEBUG_INFO("sipe_http_cache_update: cached response for '%s' is still valid",
+					uri);
+
+			/* restart freshness period */
+			if (fresh_until)
+				sipe_http_cache_store(sipe_private,
+						      uri,
+						      fresh_until,
+						      fields[1],
+						      fields[2],
+						      fields[3]);
+			g_strfreev(fields);
+		}
+	}
+}
+
 /*
   Local Variables:
   mode: c
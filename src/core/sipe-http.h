@@ -50,10 +50,28 @@ typedef void (sipe_http_response_callback)(struct sipe_core_private *sipe_privat
 					   const gchar *body,
 					   gpointer callback_data);
 
+/**
+ * HTTP response body segment callback
+ *
+ * @param sipe_private  SIPE core private data
+ * @param headers       response headers
+ * @param data          body segment (not zero terminated)
+ * @param length        length of the segment
+ * @param callback_data callback data
+ *
+ * @return @c FALSE to abort the request
+ */
+typedef gboolean (sipe_http_body_callback)(struct sipe_core_private *sipe_private,
+					   GSList *headers,
+					   const gchar *data,
+					   gsize length,
+					   gpointer callback_data);
+
 /* HTTP response status codes */
 #define SIPE_HTTP_STATUS_FAILED                0 /* internal use */
 #define SIPE_HTTP_STATUS_OK                  200
 #define SIPE_HTTP_STATUS_REDIRECTION         300 /* - 399 */
+#define SIPE_HTTP_STATUS_NOT_MODIFIED        304
 #define SIPE_HTTP_STATUS_CLIENT_ERROR        400 /* - 499 */
 #define SIPE_HTTP_STATUS_CLIENT_UNAUTHORIZED 401
 #define SIPE_HTTP_STATUS_CLIENT_FORBIDDEN    403
@@ -121,6 +139,59 @@ struct sipe_http_request *sipe_http_request_post(struct sipe_core_private *sipe_
 						 sipe_http_response_callback *callback,
 						 gpointer callback_data);
 
+/**
+ * Check if the response cache has a fresh response for URI
+ *
+ * The response can be used without sending a request to the server.
+ *
+ * @param sipe_private SIPE core private data
+ * @param uri          URI
+ *
+ * @return @c TRUE if cached response is fresh
+ */
+gboolean sipe_http_cache_fresh(struct sipe_core_private *sipe_private,
+			       const gchar *uri);
+
+/**
+ * Get body of cached response for URI
+ *
+ * @param sipe_private SIPE core private data
+ * @param uri          URI
+ *
+ * @return body (must be g_free()'d) or @c NULL if there is no cached response
+ */
+gchar *sipe_http_cache_body(struct sipe_core_private *sipe_private,
+			    const gchar *uri);
+
+/**
+ * Create headers for conditional GET request to revalidate cached response
+ *
+ * @param sipe_private SIPE core private data
+ * @param uri          URI
+ *
+ * @return headers (must be g_free()'d) or @c NULL if there is nothing to revalidate
+ */
+gchar *sipe_http_cache_headers(struct sipe_core_private *sipe_private,
+			       const gchar *uri);
+
+/**
+ * Update response cache from response for GET request
+ *
+ * Stores a successful response or restarts the freshness period of the
+ * cached response after a "304 Not Modified" response.
+ *
+ * @param sipe_private SIPE core private data
+ * @param uri          URI
+ * @param status       status code
+ * @param headers      response headers
+ * @param body         response body
+ */
+void sipe_http_cache_update(struct sipe_core_private *sipe_private,
+			    const gchar *uri,
+			    guint status,
+			    GSList *headers,
+			    const gchar *body);
+
 /**
  * HTTP request is ready to be sent
  *
@@ -144,6 +215,25 @@ void sipe_http_request_cancel(struct sipe_http_request *request);
 void sipe_http_request_session(struct sipe_http_request *request,
 			       struct sipe_http_session *session);
 
+/**
+ * Stream body of successful (2xx) response
+ *
+ * The body is passed to the segment callback as it arrives instead of
+ * being collected in memory. After the last segment the response callback
+ * is called with an empty body. The status code passed to the response
+ * callback decides if the streamed body was valid.
+ *
+ * If the segment callback aborts the request then the response callback
+ * is called with @c SIPE_HTTP_STATUS_FAILED.
+ *
+ * Other responses are delivered to the response callback as usual.
+ *
+ * @param request  pointer to opaque HTTP request data structure
+ * @param callback segment callback function
+ */
+void sipe_http_request_stream(struct sipe_http_request *request,
+			      sipe_http_body_callback *callback);
+
 /**
  * Allow redirection of HTTP request
  *
@@ -310,9 +310,8 @@ sipe_im_invite(struct sipe_core_private *sipe_private,
 	}
 
 	if (!dialog) {
-		dialog = sipe_dialog_add(session);
+		dialog = sipe_dialog_add(session, who);
 		dialog->callid = session->callid ? g_strdup(session->callid) : gencallid();
-		dialog->with = g_strdup(who);
 	}
 
 	if (!(dialog->ourtag)) {
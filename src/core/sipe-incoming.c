@@ -267,6 +267,16 @@ static gboolean sipe_process_incoming_x_msmsgsinvite(struct sipe_core_private *s
 }
 
 #ifdef HAVE_VV
+struct invite_mime_data {
+	gchar *type;
+	gchar *body;
+	gsize length;
+};
+
+/*
+ * The body might be parsed in place, i.e. the message must not be changed
+ * before sipe_mime_parts_foreach() has returned.
+ */
 static void sipe_invite_mime_cb(gpointer user_data, const GSList *fields,
 				const gchar *body, gsize length)
 {
@@ -277,23 +287,16 @@ static void sipe_invite_mime_cb(gpointer user_data, const GSList *fields,
 		return;
 
 	if (!cd || !strstr(cd, "ms-proxy-2007fallback")) {
-		struct sipmsg *msg = user_data;
-		const gchar* msg_ct = sipmsg_find_header(msg, "Content-Type");
+		struct invite_mime_data *data = user_data;
 
-		if (g_str_has_prefix(msg_ct, "application/sdp")) {
-			/* We have already found suitable alternative and set message's body
-			 * and Content-Type accordingly */
+		if (data->type) {
+			/* We have already found suitable alternative */
 			return;
 		}
 
-		sipmsg_remove_header_now(msg, "Content-Type");
-		sipmsg_add_header_now(msg, "Content-Type", type);
-
-		/* Replace message body with chosen alternative, so we can continue to
-		 * process it as a normal single part message. */
-		g_free(msg->body);
-		msg->body = g_strndup(body, length);
-		msg->bodylen = length;
+		data->type   = g_strdup(type);
+		data->body   = g_strndup(body, length);
+		data->length = length;
 	}
 }
 #endif
@@ -388,7 +391,22 @@ void process_incoming_invite(struct sipe_core_private *sipe_private,
 
 #ifdef HAVE_VV
 	if (g_str_has_prefix(content_type, "multipart/alternative")) {
-		sipe_mime_parts_foreach(content_type, msg->body, sipe_invite_mime_cb, msg);
+		struct invite_mime_data data = { NULL, NULL, 0 };
+
+		sipe_mime_parts_foreach(content_type, msg->body, sipe_invite_mime_cb, &data);
+
+		if (data.type) {
+			sipmsg_remove_header_now(msg, "Content-Type");
+			sipmsg_add_header_now(msg, "Content-Type", data.type);
+			g_free(data.type);
+
+			/* Replace message body with chosen alternative, so we can continue to
+			 * process it as a normal single part message. */
+			g_free(msg->body);
+			msg->body = data.body;
+			msg->bodylen = data.length;
+		}
+
 		/* Reload Content-Type to get type of the selected message part */
 		content_type = sipmsg_find_header(msg, "Content-Type");
 	}
@@ -480,6 +498,7 @@ void process_incoming_invite(struct sipe_core_private *sipe_private,
 				session->chat_session = sipe_chat_create_session(SIPE_CHAT_TYPE_MULTIPARTY,
 										 roster_manager,
 										 chat_title);
+				sipe_session_reindex(sipe_private, session);
 
 				g_free(chat_title);
 			}
@@ -508,8 +527,7 @@ void process_incoming_invite(struct sipe_core_private *sipe_private,
 		session = sipe_session_find_or_add_im(sipe_private, from);
 
 	/* session is now initialized */
-	g_free(session->callid);
-	session->callid = g_strdup(callid);
+	sipe_session_set_callid(sipe_private, session, callid);
 
 	if (is_multiparty && end_points) {
 		gchar *to = parse_from(sipmsg_find_header(msg, "To"));
@@ -528,11 +546,9 @@ void process_incoming_invite(struct sipe_core_private *sipe_private,
 				dialog->theirepid = end_point->epid;
 				end_point->epid = NULL;
 			} else {
-				dialog = sipe_dialog_add(session);
+				dialog = sipe_dialog_add(session, end_point->contact);
 
 				dialog->callid = g_strdup(session->callid);
-				dialog->with = end_point->contact;
-				end_point->contact = NULL;
 				dialog->theirepid = end_point->epid;
 				end_point->epid = NULL;
 
@@ -566,8 +582,7 @@ void process_incoming_invite(struct sipe_core_private *sipe_private,
 		just_joined = TRUE;
 	}
 
-	dialog = sipe_dialog_add(session);
-	dialog->with = g_strdup(from);
+	dialog = sipe_dialog_add(session, from);
 	dialog->callid = g_strdup(session->callid);
 	dialog->is_established = TRUE;
 	sipe_dialog_parse(dialog, msg, FALSE);
@@ -27,16 +27,19 @@
  *                    https://technet.microsoft.com/en-us/library/jj945654.aspx
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <glib.h>
 
 #include "sipe-common.h"
 #include "sipe-backend.h"
+#include "sipe-cache.h"
 #include "sipe-core.h"
 #include "sipe-core-private.h"
 #include "sipe-http.h"
 #include "sipe-lync-autodiscover.h"
+#include "sipe-schedule.h"
 #include "sipe-utils.h"
 #include "sipe-svc.h"
 #include "sipe-webticket.h"
@@ -45,16 +48,25 @@
 #define LYNC_AUTODISCOVER_ACCEPT_HEADER \
 	"Accept: application/vnd.microsoft.rtc.autodiscover+xml;v=1\r\n"
 
+/*
+ * Successful autodiscover results are stored in the persistent cache:
+ *
+ *   key "lync:<SIP URI>" value "<port>:<server>[ <port>:<server>]"
+ *
+ * Servers are listed in the order they should be tried.
+ */
+#define LYNC_AUTODISCOVER_CACHE_SECTION  "autodiscover"
+#define LYNC_AUTODISCOVER_CACHE_LIFETIME (24 * 60 * 60) /* seconds */
+
 struct lync_autodiscover_request {
 	sipe_lync_autodiscover_callback *cb;
 	gpointer cb_data;
 	gpointer id;                       /* != NULL for active request */
 	struct sipe_http_request *request;
 	struct sipe_svc_session *session;
-	const gchar *protocol;
-	const gchar **method;
+	GSList *servers;                   /* cached result */
+	gchar *timeout;                    /* cached result is pending */
 	gchar *uri;
-	gboolean is_pending;
 };
 
 struct sipe_lync_autodiscover {
@@ -83,9 +95,15 @@ static void sipe_lync_autodiscover_request_free(struct sipe_core_private *sipe_p
 
 	if (request->request)
 		sipe_http_request_cancel(request->request);
+	if (request->timeout) {
+		sipe_schedule_cancel(sipe_private, request->timeout);
+		g_free(request->timeout);
+	}
 	if (request->cb)
 		/* Callback: aborted */
 		(*request->cb)(sipe_private, NULL, request->cb_data);
+	while (request->servers)
+		request->servers = sipe_lync_autodiscover_pop(request->servers);
 	sipe_svc_session_close(request->session);
 	g_free(request->uri);
 	g_free(request);
@@ -142,8 +160,82 @@ GSList *sipe_lync_autodiscover_pop(GSList *servers)
 	return(servers);
 }
 
-static void sipe_lync_autodiscover_queue_request(struct sipe_core_private *sipe_private,
-						 struct lync_autodiscover_request *request);
+static gchar *sipe_lync_autodiscover_key(struct sipe_core_private *sipe_private)
+{
+	return(g_strdup_printf("lync:%s", sipe_private->username));
+}
+
+static void sipe_lync_autodiscover_store(struct sipe_core_private *sipe_private,
+					 GSList *servers)
+{
+	GString *value = g_string_new("");
+
+	for (; servers && servers->data; servers = servers->next) {
+		struct sipe_lync_autodiscover_data *lync_data = servers->data;
+		g_string_append_printf(value, "%s%d:%s",
+				       value->len ? " " : "",
+				       lync_data->port,
+				       lync_data->server);
+	}
+
+	if (value->len) {
+		gchar *key = sipe_lync_autodiscover_key(sipe_private);
+		sipe_cache_set(sipe_private,
+			       LYNC_AUTODISCOVER_CACHE_SECTION,
+			       key,
+			       value->str,
+			       LYNC_AUTODISCOVER_CACHE_LIFETIME);
+		g_free(key);
+	}
+
+	g_string_free(value, TRUE);
+}
+
+static GSList *sipe_lync_autodiscover_load(struct sipe_core_private *sipe_private)
+{
+	gchar *key = sipe_lync_autodiscover_key(sipe_private);
+	const gchar *value = sipe_cache_get(sipe_private,
+					    LYNC_AUTODISCOVER_CACHE_SECTION,
+					    key);
+	GSList *servers = NULL;
+
+	if (value) {
+		gchar **entries = g_strsplit(value, " ", 0);
+		gchar **entry;
+
+		for (entry = entries; *entry; entry++) {
+			gchar *server;
+			guint port = strtoul(*entry, &server, 10);
+
+			if ((port != 0) && (*server == ':') && server[1]) {
+				struct sipe_lync_autodiscover_data *lync_data = g_new0(struct sipe_lync_autodiscover_data, 1);
+				lync_data->server = g_strdup(server + 1);
+				lync_data->port   = port;
+				servers = g_slist_append(servers, lync_data);
+			}
+		}
+		g_strfreev(entries);
+
+		/* terminate list with NULL entry */
+		if (servers)
+			servers = g_slist_append(servers, NULL);
+	}
+
+	g_free(key);
+	return(servers);
+}
+
+void sipe_lync_autodiscover_forget(struct sipe_core_private *sipe_private)
+{
+	gchar *key = sipe_lync_autodiscover_key(sipe_private);
+	sipe_cache_remove(sipe_private,
+			  LYNC_AUTODISCOVER_CACHE_SECTION,
+			  key);
+	g_free(key);
+}
+
+static void sipe_lync_autodiscover_failed(struct sipe_core_private *sipe_private,
+					  struct lync_autodiscover_request *request);
 static void sipe_lync_autodiscover_parse(struct sipe_core_private *sipe_private,
 					 struct lync_autodiscover_request *request,
 					 const gchar *body)
@@ -203,13 +295,23 @@ static void sipe_lync_autodiscover_parse(struct sipe_core_private *sipe_private,
 							     node,
 							     "SipClientInternalAccess");
 
+			sipe_lync_autodiscover_store(sipe_private, servers);
+
 			/* Callback takes ownership of servers list */
 			(*request->cb)(sipe_private, servers, request->cb_data);
 
-			/* We're done with requests for this callback */
-			FOR_ALL_REQUESTS_WITH_SAME_ID( \
-				lar->cb = NULL;        \
-				lar->id = NULL         \
+			/*
+			 * We're done with requests for this callback. Cancel
+			 * all other probes that are waiting for a HTTP
+			 * response. Probes waiting for a web ticket will be
+			 * freed when the web ticket callback arrives.
+			 */
+			FOR_ALL_REQUESTS_WITH_SAME_ID(			    \
+				lar->cb = NULL;				    \
+				lar->id = NULL;				    \
+				if ((lar != request) && lar->request)	    \
+					sipe_lync_autodiscover_request_free(sipe_private, \
+									    lar) \
 			);
 
 		}
@@ -223,7 +325,7 @@ static void sipe_lync_autodiscover_parse(struct sipe_core_private *sipe_private,
 	sipe_xml_free(xml);
 
 	if (next)
-		sipe_lync_autodiscover_queue_request(sipe_private, request);
+		sipe_lync_autodiscover_failed(sipe_private, request);
 }
 
 static void sipe_lync_autodiscover_webticket(struct sipe_core_private *sipe_private,
@@ -236,8 +338,13 @@ static void sipe_lync_autodiscover_webticket(struct sipe_core_private *sipe_priv
 	struct lync_autodiscover_request *request = callback_data;
 	gchar *saml;
 
+	/* Another probe has already succeeded */
+	if (!request->id) {
+		sipe_lync_autodiscover_request_free(sipe_private, request);
+		/* request is invalid */
+
 	/* Extract SAML Assertion from WSSE Security XML text */
-	if (wsse_security &&
+	} else if (wsse_security &&
 	    ((saml = sipe_xml_extract_raw(wsse_security,
 					  "Assertion",
 					  TRUE)) != NULL)) {
@@ -256,7 +363,7 @@ static void sipe_lync_autodiscover_webticket(struct sipe_core_private *sipe_priv
 		g_free(headers);
 
 	} else
-		sipe_lync_autodiscover_queue_request(sipe_private, request);
+		sipe_lync_autodiscover_failed(sipe_private, request);
 }
 
 static void sipe_lync_autodiscover_cb(struct sipe_core_private *sipe_private,
@@ -278,7 +385,7 @@ static void sipe_lync_autodiscover_cb(struct sipe_core_private *sipe_private,
 		if (body && g_str_has_prefix(type, "application/vnd.microsoft.rtc.autodiscover+xml"))
 			sipe_lync_autodiscover_parse(sipe_private, request, body);
 		else
-			sipe_lync_autodiscover_queue_request(sipe_private, request);
+			sipe_lync_autodiscover_failed(sipe_private, request);
 		break;
 
 	case SIPE_HTTP_STATUS_FAILED:
@@ -295,9 +402,9 @@ static void sipe_lync_autodiscover_cb(struct sipe_core_private *sipe_private,
 								       uri, /* Auth URI */
 								       sipe_lync_autodiscover_webticket,
 								       request)))
-					sipe_lync_autodiscover_queue_request(sipe_private, request);
+					sipe_lync_autodiscover_failed(sipe_private, request);
 			} else
-				sipe_lync_autodiscover_queue_request(sipe_private, request);
+				sipe_lync_autodiscover_failed(sipe_private, request);
 	        }
 		break;
 
@@ -307,109 +414,78 @@ static void sipe_lync_autodiscover_cb(struct sipe_core_private *sipe_private,
 		break;
 
 	default:
-		sipe_lync_autodiscover_queue_request(sipe_private, request);
+		sipe_lync_autodiscover_failed(sipe_private, request);
 		break;
 	}
 
 	g_free(uri);
 }
 
-/* Proceed to next method for request */
-static void sipe_lync_autodiscover_request(struct sipe_core_private *sipe_private,
-					   struct lync_autodiscover_request *request)
+/* Probe has completed without result */
+static void sipe_lync_autodiscover_failed(struct sipe_core_private *sipe_private,
+					  struct lync_autodiscover_request *request)
 {
 	gpointer id = request->id;
 
 	/* Active request? */
 	if (id) {
-		static const gchar *methods[] = {
-			"%s://LyncDiscoverInternal.%s/?sipuri=%s",
-			"%s://LyncDiscover.%s/?sipuri=%s",
-			NULL
-		};
+		guint count = 0;
 
-		request->is_pending = TRUE;
+		/* Count entries with the same request ID */
+		FOR_ALL_REQUESTS_WITH_SAME_ID( \
+			count++;	       \
+		);
 
-		if (request->method)
-			request->method++;
-		else
-			request->method = methods;
-
-		if (*request->method) {
-			gchar *uri = g_strdup_printf(*request->method,
-						     request->protocol,
-						     SIPE_CORE_PUBLIC->sip_domain,
-						     sipe_private->username);
-
-			SIPE_DEBUG_INFO("sipe_lync_autodiscover_request: trying '%s'", uri);
-
-			lync_request(sipe_private, request, uri, NULL);
-			g_free(uri);
-
-		} else {
-			guint count = 0;
+		if (count == 1) {
+			/*
+			 * This is the last pending request for this
+			 * ID, i.e. autodiscover has failed. Create
+			 * empty server list and return it.
+			 */
+			GSList *servers = g_slist_prepend(NULL, NULL);
 
-			/* Count entries with the same request ID */
-			FOR_ALL_REQUESTS_WITH_SAME_ID( \
-				count++;	       \
-			);
-
-			if (count == 1) {
-				/*
-				 * This is the last pending request for this
-				 * ID, i.e. autodiscover has failed. Create
-				 * empty server list and return it.
-				 */
-				GSList *servers = g_slist_prepend(NULL, NULL);
-
-				/* All methods tried, indicate failure to caller */
-				SIPE_DEBUG_INFO_NOFORMAT("sipe_lync_autodiscover_request: no more methods to try!");
-
-				/* Callback takes ownership of servers list */
-				(*request->cb)(sipe_private, servers, request->cb_data);
-			}
+			/* All methods tried, indicate failure to caller */
+			SIPE_DEBUG_INFO_NOFORMAT("sipe_lync_autodiscover_failed: no more methods to try!");
 
-			/* Request completed */
-			request->cb = NULL;
-			sipe_lync_autodiscover_request_free(sipe_private, request);
-			/* request is invalid */
+			/* Callback takes ownership of servers list */
+			(*request->cb)(sipe_private, servers, request->cb_data);
 		}
-	} else {
-		/* Inactive request, callback already NULL */
-		sipe_lync_autodiscover_request_free(sipe_private, request);
-		/* request is invalid */
+
+		/* Request completed */
+		request->cb = NULL;
 	}
+
+	/* Inactive request, callback already NULL */
+	sipe_lync_autodiscover_request_free(sipe_private, request);
+	/* request is invalid */
 }
 
-/* Proceed to next method for all requests */
-static void sipe_lync_autodiscover_queue_request(struct sipe_core_private *sipe_private,
-						 struct lync_autodiscover_request *request)
+static void sipe_lync_autodiscover_cached(struct sipe_core_private *sipe_private,
+					  gpointer data)
 {
-	gpointer id = request->id;
+	struct lync_autodiscover_request *request = data;
+	GSList *servers = request->servers;
 
-	/* This request is ready to proceed to next method */
-	request->is_pending = FALSE;
+	SIPE_DEBUG_INFO_NOFORMAT("sipe_lync_autodiscover_cached: using cached server list");
 
-	/* Is any request for the same ID still pending? */
-	FOR_ALL_REQUESTS_WITH_SAME_ID( \
-		if (lar->is_pending)   \
-			return	       \
-	);
+	/* schedule has expired */
+	g_free(request->timeout);
+	request->timeout = NULL;
 
-	SIPE_DEBUG_INFO_NOFORMAT("sipe_lync_autodiscover_queue_request: proceed in lockstep");
+	/* Callback takes ownership of servers list */
+	request->servers = NULL;
+	(*request->cb)(sipe_private, servers, request->cb_data);
 
-	/* No, proceed to next method for all requests */
-	FOR_ALL_REQUESTS_WITH_SAME_ID(			     \
-		sipe_lync_autodiscover_request(sipe_private, \
-					       lar)	     \
-	);
+	/* Request completed */
+	request->cb = NULL;
+	sipe_lync_autodiscover_request_free(sipe_private, request);
+	/* request is invalid */
 }
 
-static gpointer sipe_lync_autodiscover_create(struct sipe_core_private *sipe_private,
-					      gpointer id,
-					      const gchar *protocol,
-					      sipe_lync_autodiscover_callback *callback,
-					      gpointer callback_data)
+static struct lync_autodiscover_request *sipe_lync_autodiscover_create(struct sipe_core_private *sipe_private,
+								       gpointer id,
+								       sipe_lync_autodiscover_callback *callback,
+								       gpointer callback_data)
 {
 	struct sipe_lync_autodiscover *sla = sipe_private->lync_autodiscover;
 	struct lync_autodiscover_request *request = g_new0(struct lync_autodiscover_request, 1);
@@ -418,7 +494,6 @@ static gpointer sipe_lync_autodiscover_create(struct sipe_core_private *sipe_pri
 	if (id == NULL)
 		id = request;
 
-	request->protocol = protocol;
 	request->cb       = callback;
 	request->cb_data  = callback_data;
 	request->id       = id;
@@ -427,25 +502,66 @@ static gpointer sipe_lync_autodiscover_create(struct sipe_core_private *sipe_pri
 	sla->pending_requests = g_slist_prepend(sla->pending_requests,
 						request);
 
-	sipe_lync_autodiscover_request(sipe_private, request);
-
-	return(id);
+	return(request);
 }
 
 void sipe_lync_autodiscover_start(struct sipe_core_private *sipe_private,
 				  sipe_lync_autodiscover_callback *callback,
 				  gpointer callback_data)
 {
+	static const gchar *protocols[] = {
+		"http",
+		"https",
+		NULL
+	};
+	static const gchar *methods[] = {
+		"%s://LyncDiscoverInternal.%s/?sipuri=%s",
+		"%s://LyncDiscover.%s/?sipuri=%s",
+		NULL
+	};
+	GSList *servers = sipe_lync_autodiscover_load(sipe_private);
+	struct lync_autodiscover_request *request;
 	gpointer id = NULL;
+	const gchar **protocol;
+	const gchar **method;
+
+	/* Previous result is still valid: skip autodiscover */
+	if (servers) {
+		request = sipe_lync_autodiscover_create(sipe_private,
+							NULL,
+							callback,
+							callback_data);
+		request->servers = servers;
+		request->timeout = g_strdup_printf("<+lync-autodiscover><%p>",
+						   request);
+		sipe_schedule_mseconds(sipe_private,
+				       request->timeout,
+				       request,
+				       0,
+				       sipe_lync_autodiscover_cached,
+				       NULL);
+		return;
+	}
 
-#define CREATE(protocol) \
-	id = sipe_lync_autodiscover_create(sipe_private,  \
-					   id,            \
-					   #protocol,     \
-					   callback,      \
-					   callback_data)
-	CREATE(http);
-	CREATE(https);
+	/* Launch all probes at once, first valid answer wins */
+	for (protocol = protocols; *protocol; protocol++)
+		for (method = methods; *method; method++) {
+			gchar *uri = g_strdup_printf(*method,
+						     *protocol,
+						     SIPE_CORE_PUBLIC->sip_domain,
+						     sipe_private->username);
+
+			request = sipe_lync_autodiscover_create(sipe_private,
+								id,
+								callback,
+								callback_data);
+			id = request->id;
+
+			SIPE_DEBUG_INFO("sipe_lync_autodiscover_start: trying '%s'", uri);
+
+			lync_request(sipe_private, request, uri, NULL);
+			g_free(uri);
+		}
 }
 
 void sipe_lync_autodiscover_init(struct sipe_core_private *sipe_private)
@@ -37,7 +37,8 @@ struct sipe_lync_autodiscover_data {
  * @param servers       list with Lync autodiscover data
  * @param callback_data callback data
  *
- * servers will be @c NULL when request got aborted.
+ * servers will be @c NULL when request got aborted. The callback is
+ * never called before sipe_lync_autodiscover_start() has returned.
  * last entry in the list will be a @c NULL entry.
  */
 typedef void (sipe_lync_autodiscover_callback)(struct sipe_core_private *sipe_private,
@@ -53,9 +54,19 @@ typedef void (sipe_lync_autodiscover_callback)(struct sipe_core_private *sipe_pr
  */
 GSList *sipe_lync_autodiscover_pop(GSList *servers);
 
+/**
+ * Drop cached Lync autodiscover result, e.g. after all servers failed
+ *
+ * @param sipe_private SIPE core private data
+ */
+void sipe_lync_autodiscover_forget(struct sipe_core_private *sipe_private);
+
 /**
  * Trigger Lync autodiscover
  *
+ * A successful result is cached. If a valid cached result exists then
+ * it is delivered without sending any requests.
+ *
  * @param sipe_private  SIPE core private data
  * @param callback      callback function
  * @param callback_data callback data
@@ -41,6 +41,7 @@
 #include "sipe-core.h"
 #include "sipe-core-private.h"
 #include "sipe-dialog.h"
+#include "sipe-dns.h"
 #include "sipe-media.h"
 #include "sipe-ocs2007.h"
 #include "sipe-session.h"
@@ -1037,8 +1038,7 @@ sipe_media_call_new(struct sipe_core_private *sipe_private, const gchar* with,
 
 	session = sipe_session_add_call(sipe_private, with);
 
-	dialog = sipe_dialog_add(session);
-	dialog->with = g_strdup(with);
+	dialog = sipe_dialog_add(session, with);
 
 	if (msg) {
 		gchar *newTag = gentag();
@@ -2053,7 +2053,7 @@ sipe_media_relay_free(struct sipe_media_relay *relay)
 {
 	g_free(relay->hostname);
 	if (relay->dns_query)
-		sipe_backend_dns_query_cancel(relay->dns_query);
+		sipe_dns_query_cancel(relay->dns_query);
 	g_free(relay);
 }
 
@@ -2142,8 +2142,8 @@ process_get_av_edge_credentials_response(struct sipe_core_private *sipe_private,
 
 				relays = g_slist_append(relays, relay);
 
-				relay->dns_query = sipe_backend_dns_query_a(
-							SIPE_CORE_PUBLIC,
+				relay->dns_query = sipe_dns_query_a(
+							sipe_private,
 							relay->hostname,
 							relay->udp_port,
 							(sipe_dns_resolved_cb) relay_ip_resolved_cb,
@@ -2295,13 +2295,22 @@ sipe_media_stream_read_async(struct sipe_media_stream *stream,
 	g_queue_push_tail(SIPE_MEDIA_STREAM_PRIVATE->async_reads, data);
 }
 
+/* pending small writes are merged up to this size */
+#define STREAM_WRITE_QUEUE_COALESCE_LIMIT 65536
+
 static void
 stream_append_buffer(struct sipe_media_stream *stream,
-		     guint8 *buffer, guint len)
+		     const guint8 *buffer, gsize len)
 {
-	GByteArray *b = g_byte_array_sized_new(len);
+	GQueue *queue = SIPE_MEDIA_STREAM_PRIVATE->write_queue;
+	GByteArray *b = g_queue_peek_tail(queue);
+
+	/* stream is a byte stream: append to last pending buffer */
+	if (!b || (b->len + len > STREAM_WRITE_QUEUE_COALESCE_LIMIT)) {
+		b = g_byte_array_sized_new(len);
+		g_queue_push_tail(queue, b);
+	}
 	g_byte_array_append(b, buffer, len);
-	g_queue_push_tail(SIPE_MEDIA_STREAM_PRIVATE->write_queue, b);
 }
 
 gboolean
@@ -2312,13 +2321,15 @@ sipe_media_stream_write(struct sipe_media_stream *stream,
 		stream_append_buffer(stream, buffer, len);
 		return FALSE;
 	} else {
-		guint written;
+		gssize written;
 
 		written = sipe_backend_media_stream_write(stream, buffer, len);
-		if (written == len) {
+		if ((written >= 0) && ((gsize) written == len)) {
 			return TRUE;
 		}
 
+		if (written < 0)
+			written = 0;
 		stream_append_buffer(stream,
 				     (guint8 *)buffer + written, len - written);
 		return FALSE;
@@ -2337,13 +2348,15 @@ sipe_core_media_stream_writable(struct sipe_media_stream *stream,
 
 	while (!g_queue_is_empty(SIPE_MEDIA_STREAM_PRIVATE->write_queue)) {
 		GByteArray *b;
-		guint written;
+		gssize written;
 
 		b = g_queue_peek_head(SIPE_MEDIA_STREAM_PRIVATE->write_queue);
 
 		written = sipe_backend_media_stream_write(stream, b->data, b->len);
-		if (written != b->len) {
-			g_byte_array_remove_range(b, 0, written);
+		if ((written < 0) || ((guint) written != b->len)) {
+			/* only skip over data that has been sent */
+			if (written > 0)
+				g_byte_array_remove_range(b, 0, written);
 			return;
 		}
 
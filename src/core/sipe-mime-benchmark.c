@@ -0,0 +1,185 @@
+/**
+ * @file sipe-mime-benchmark.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Timing harness for simple multipart parser vs. GMime
+ *
+ * Splits a batched presence NOTIFY body (RLMI + one categories document
+ * per contact) with sipe_mime_parts_foreach_simple() and with the GMime
+ * parser from sipe-mime.c.
+ *
+ *    $ sipe_mime_benchmark [<contacts, default 100> [<iterations, default 1000>]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include <glib.h>
+
+#include "sip-transport.h"
+#include "sipe-common.h"
+#include "uuid.h"
+
+/* gives access to GMime parser without simple parser shortcut */
+#include "sipe-mime.c"
+
+/* stub functions for backend API */
+void sipe_backend_debug_literal(SIPE_UNUSED_PARAMETER sipe_debug_level level,
+				SIPE_UNUSED_PARAMETER const gchar *msg)
+{
+}
+void sipe_backend_debug(SIPE_UNUSED_PARAMETER sipe_debug_level level,
+			SIPE_UNUSED_PARAMETER const gchar *format,
+			...)
+{
+}
+gboolean sipe_backend_debug_enabled(void)
+{
+	return FALSE;
+}
+
+const gchar *sip_transport_epid(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+const gchar *sip_transport_ip_address(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+char *generateUUIDfromEPID(SIPE_UNUSED_PARAMETER const gchar *epid) { return(NULL); }
+char *sipe_get_epid(SIPE_UNUSED_PARAMETER const char *self_sip_uri,
+		    SIPE_UNUSED_PARAMETER const char *hostname,
+		    SIPE_UNUSED_PARAMETER const char *ip_address) { return(NULL); }
+
+#define BOUNDARY "e9e7ef3f-92ed-4a8c-b3e6-3b1d0c8f2c6e"
+
+static const gchar content_type[] =
+	"multipart/related;type=\"application/rlmi+xml\";start=resourceList;boundary=" BOUNDARY;
+
+static gchar *batched_notify(guint contacts)
+{
+	GString *body = g_string_new(NULL);
+	guint i;
+
+	g_string_append(body,
+			"--" BOUNDARY "\r\n"
+			"Content-Transfer-Encoding: binary\r\n"
+			"Content-ID: <resourceList>\r\n"
+			"Content-Type: application/rlmi+xml\r\n"
+			"\r\n"
+			"<list xmlns=\"urn:ietf:params:xml:ns:rlmi\" uri=\"sip:user@example.com;ms-roaming-presence\" version=\"1\" fullState=\"false\">");
+	for (i = 0; i < contacts; i++)
+		g_string_append_printf(body,
+				       "<resource uri=\"sip:contact%u@example.com\"><instance id=\"0\" state=\"active\" cid=\"contact%u@example.com\"/></resource>",
+				       i, i);
+	g_string_append(body, "</list>\r\n");
+
+	for (i = 0; i < contacts; i++)
+		g_string_append_printf(body,
+				       "--" BOUNDARY "\r\n"
+				       "Content-Transfer-Encoding: binary\r\n"
+				       "Content-ID: <contact%u@example.com>\r\n"
+				       "Content-Type: application/msrtc-event-categories+xml\r\n"
+				       "\r\n"
+				       "<categories xmlns=\"http://schemas.microsoft.com/2006/09/sip/categories\" uri=\"sip:contact%u@example.com\">"
+				       "<category name=\"state\" instance=\"1\" publishTime=\"2016-06-01T08:00:00.000Z\">"
+				       "<state xsi:type=\"aggregateState\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns=\"http://schemas.microsoft.com/2006/09/sip/state\">"
+				       "<availability>3500</availability><delimiter xmlns=\"http://schemas.microsoft.com/2006/09/sip/commontypes\"/>"
+				       "</state></category>"
+				       "<category name=\"contactCard\" instance=\"0\" publishTime=\"2016-06-01T08:00:00.000Z\">"
+				       "<contactCard xmlns=\"http://schemas.microsoft.com/2006/09/sip/contactcard\">"
+				       "<identity><name><displayName>Contact %u</displayName></name><email>contact%u@example.com</email></identity>"
+				       "<company>Example Corp</company><department>Engineering</department><office>Building 1</office>"
+				       "<phone type=\"work\"><uri>tel:+1555000%04u</uri><displayString>+1 555 000 %04u</displayString></phone>"
+				       "</contactCard></category>"
+				       "<category name=\"note\" instance=\"0\" publishTime=\"2016-06-01T08:00:00.000Z\">"
+				       "<note xmlns=\"http://schemas.microsoft.com/2006/09/sip/note\"><body type=\"personal\">Out until Monday</body></note>"
+				       "</category></categories>\r\n",
+				       i, i, i, i, i, i);
+
+	g_string_append(body, "--" BOUNDARY "--\r\n");
+	return(g_string_free(body, FALSE));
+}
+
+struct count_data {
+	guint parts;
+	gsize bytes;
+};
+
+static void count_cb(gpointer user_data,
+		     SIPE_UNUSED_PARAMETER const GSList *fields,
+		     SIPE_UNUSED_PARAMETER const gchar *body,
+		     gsize length)
+{
+	struct count_data *count = user_data;
+	count->parts++;
+	count->bytes += length;
+}
+
+int main(int argc, char **argv)
+{
+	guint contacts   = (argc > 1) ? (guint) atoi(argv[1]) : 100;
+	guint iterations = (argc > 2) ? (guint) atoi(argv[2]) : 1000;
+	gchar *body      = batched_notify(contacts);
+	GTimer *timer    = g_timer_new();
+	struct count_data simple = { 0, 0 };
+	struct count_data gmime  = { 0, 0 };
+	gdouble simple_time;
+	gdouble gmime_time;
+	guint i;
+
+	sipe_mime_init();
+
+	g_timer_start(timer);
+	for (i = 0; i < iterations; i++)
+		if (!sipe_mime_parts_foreach_simple(content_type, body,
+						    count_cb, &simple)) {
+			printf("simple parser rejected document\n");
+			return(1);
+		}
+	simple_time = g_timer_elapsed(timer, NULL);
+
+	g_timer_start(timer);
+	for (i = 0; i < iterations; i++)
+		gmime_parts_foreach(content_type, body, count_cb, &gmime);
+	gmime_time = g_timer_elapsed(timer, NULL);
+
+	printf("%u iterations, %u contacts, %" G_GSIZE_FORMAT " bytes\n",
+	       iterations, contacts, strlen(body));
+	printf("simple: %.3f seconds (%.2f us per document), %u parts, %" G_GSIZE_FORMAT " body bytes\n",
+	       simple_time,
+	       iterations ? simple_time * 1000000 / iterations : 0.0,
+	       simple.parts, simple.bytes);
+	printf("GMime:  %.3f seconds (%.2f us per document), %u parts, %" G_GSIZE_FORMAT " body bytes\n",
+	       gmime_time,
+	       iterations ? gmime_time * 1000000 / iterations : 0.0,
+	       gmime.parts, gmime.bytes);
+
+	sipe_mime_shutdown();
+	g_timer_destroy(timer);
+	g_free(body);
+
+	return(simple.parts != gmime.parts);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
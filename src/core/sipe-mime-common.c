@@ -20,12 +20,272 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <string.h>
+
 #include <glib.h>
 
 #include "sipe-common.h"
+#include "sipe-backend.h"
 #include "sipe-mime.h"
 #include "sipe-utils.h"
 
+struct simple_part {
+	GSList *fields;
+	const gchar *body;
+	gsize length;
+};
+
+/* returns "--<boundary>" */
+static gchar *simple_delimiter(const gchar *type)
+{
+	const gchar *param = strchr(type, ';');
+
+	/* first entry is the MIME type itself */
+	while (param) {
+		param++;
+		while ((*param == ' ') || (*param == '\t'))
+			param++;
+
+		if (g_ascii_strncasecmp(param, "boundary=", 9) == 0) {
+			const gchar *end;
+
+			param += 9;
+			if (*param == '"')
+				end = strchr(++param, '"');
+			else
+				end = param + strcspn(param, "; \t\r\n");
+
+			if (!end || (end == param))
+				return(NULL);
+			return(g_strdup_printf("--%.*s", (int) (end - param), param));
+		}
+
+		param = strchr(param, ';');
+	}
+
+	return(NULL);
+}
+
+/* delimiter must be at the start of a line */
+static const gchar *simple_find_delimiter(const gchar *doc,
+					  const gchar *pos,
+					  const gchar *delimiter)
+{
+	while ((pos = strstr(pos, delimiter)) != NULL) {
+		if ((pos == doc) || (pos[-1] == '\n'))
+			return(pos);
+		pos++;
+	}
+	return(NULL);
+}
+
+/* strips trailing (and optionally leading) white space from a slice */
+static gsize simple_strip(const gchar **text,
+			  gsize length,
+			  gboolean leading)
+{
+	if (leading)
+		while (length && g_ascii_isspace(**text)) {
+			(*text)++;
+			length--;
+		}
+	while (length && g_ascii_isspace((*text)[length - 1]))
+		length--;
+	return(length);
+}
+
+/* header block is [start, end) */
+static gboolean simple_headers(struct simple_part *part,
+			       const gchar *start,
+			       const gchar *end)
+{
+	gboolean ok = TRUE;
+
+	while (ok && (start < end)) {
+		const gchar *line_end = memchr(start, '\n', end - start);
+		const gchar *next;
+		gsize length;
+
+		if (!line_end)
+			line_end = end;
+		next   = line_end + 1;
+		length = simple_strip(&start, line_end - start, FALSE);
+
+		if (!length) {
+			/* empty line */
+
+		/* folded header line */
+		} else if ((*start == ' ') || (*start == '\t')) {
+			if (part->fields) {
+				struct sipnameval *field = part->fields->data;
+				gchar *value = field->value;
+
+				field->value = g_strdup_printf("%s%.*s",
+							       value,
+							       (int) length,
+							       start);
+				g_free(value);
+			}
+
+		} else {
+			const gchar *colon = memchr(start, ':', length);
+
+			if (colon) {
+				struct sipnameval *field = g_new(struct sipnameval, 1);
+				const gchar *value = colon + 1;
+				gsize value_length = simple_strip(&value,
+								  start + length - value,
+								  TRUE);
+
+				field->name  = g_strndup(start, colon - start);
+				field->value = g_strndup(value, value_length);
+				part->fields = g_slist_prepend(part->fields, field);
+			} else {
+				ok = FALSE;
+			}
+		}
+
+		start = next;
+	}
+	part->fields = g_slist_reverse(part->fields);
+
+	if (ok) {
+		const gchar *encoding = sipe_utils_nameval_find(part->fields,
+								"Content-Transfer-Encoding");
+		const gchar *type     = sipe_utils_nameval_find(part->fields,
+								"Content-Type");
+
+		/* leave decoding and nested documents to the MIME backend */
+		if ((encoding &&
+		     !sipe_strcase_equal(encoding, "7bit") &&
+		     !sipe_strcase_equal(encoding, "8bit") &&
+		     !sipe_strcase_equal(encoding, "binary")) ||
+		    (type && (g_ascii_strncasecmp(type, "multipart/", 10) == 0)))
+			ok = FALSE;
+	}
+
+	return(ok);
+}
+
+/*
+ * The document is scanned in place: part bodies passed to the callback
+ * point into the caller's body. Callbacks are only called after the whole
+ * document has been scanned, i.e. they must not modify or free it.
+ */
+gboolean sipe_mime_parts_foreach_simple(const gchar *type,
+					const gchar *body,
+					sipe_mime_parts_cb callback,
+					gpointer user_data)
+{
+	gchar *delimiter;
+	gsize delimiter_length;
+	const gchar *pos;
+	GArray *parts;
+	gboolean ok = FALSE;
+	guint i;
+
+	if (!type || !body ||
+	    (g_ascii_strncasecmp(type, "multipart/", 10) != 0))
+		return(FALSE);
+
+	delimiter = simple_delimiter(type);
+	if (!delimiter)
+		return(FALSE);
+	delimiter_length = strlen(delimiter);
+	parts = g_array_new(FALSE, FALSE, sizeof(struct simple_part));
+
+	/* skip preamble */
+	pos = simple_find_delimiter(body, body, delimiter);
+
+	while (pos) {
+		struct simple_part part = { NULL, NULL, 0 };
+		const gchar *start = pos + delimiter_length;
+		const gchar *end;
+		const gchar *separator;
+
+		/* close delimiter */
+		if (g_str_has_prefix(start, "--")) {
+			ok = parts->len > 0;
+			break;
+		}
+
+		/* skip rest of delimiter line */
+		start = strchr(start, '\n');
+		if (!start)
+			break;
+		start++;
+
+		/* find next delimiter */
+		end = simple_find_delimiter(body, start, delimiter);
+		if (!end)
+			break;
+		pos = end;
+
+		/* part without any content */
+		if (end == start)
+			break;
+
+		/* CRLF before delimiter belongs to the delimiter */
+		end--;
+		if ((end > start) && (end[-1] == '\r'))
+			end--;
+
+		/* empty line terminates headers */
+		if ((start[0] == '\n') ||
+		    ((start[0] == '\r') && (start[1] == '\n'))) {
+			separator = start;
+		} else {
+			const gchar *crlf = g_strstr_len(start, end - start, "\n\r\n");
+			const gchar *lf   = g_strstr_len(start, end - start, "\n\n");
+
+			/* whichever comes first, the body might contain the other */
+			if (crlf && (!lf || (crlf < lf)))
+				separator = crlf + 1;
+			else if (lf)
+				separator = lf + 1;
+			else
+				separator = end;
+		}
+
+		if (separator == end)
+			part.body = end;
+		else
+			part.body = separator + ((*separator == '\r') ? 2 : 1);
+		if (part.body > end)
+			part.body = end;
+		part.length = end - part.body;
+
+		if (!simple_headers(&part, start, separator)) {
+			sipe_utils_nameval_free(part.fields);
+			break;
+		}
+		g_array_append_val(parts, part);
+	}
+
+	if (ok) {
+		SIPE_DEBUG_INFO("sipe_mime_parts_foreach_simple: %d parts", parts->len);
+		for (i = 0; i < parts->len; i++) {
+			struct simple_part *part = &g_array_index(parts,
+								  struct simple_part,
+								  i);
+			/* same as GMime backend: parts without type are passed on too */
+			(*callback)(user_data,
+				    part->fields,
+				    part->body,
+				    part->length);
+		}
+	}
+
+	for (i = 0; i < parts->len; i++)
+		sipe_utils_nameval_free(g_array_index(parts,
+						      struct simple_part,
+						      i).fields);
+	g_array_free(parts, TRUE);
+	g_free(delimiter);
+
+	return(ok);
+}
+
 struct parts_contain_cb_data {
 	const gchar * type;
 	gboolean result;
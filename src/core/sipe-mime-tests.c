@@ -0,0 +1,348 @@
+/**
+ * @file sipe-mime-tests.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Tests for sipe_mime_parts_foreach_simple() in sipe-mime-common.c */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <glib.h>
+
+#include "sip-transport.h"
+#include "sipe-common.h"
+#include "sipe-backend.h"
+#include "sipe-mime.h"
+#include "sipe-utils.h"
+#include "uuid.h"
+
+/* stub functions for backend API */
+void sipe_backend_debug_literal(sipe_debug_level level,
+				const gchar *msg)
+{
+	printf("DEBUG %d: %s", level, msg);
+}
+void sipe_backend_debug(sipe_debug_level level,
+			const gchar *format,
+			...)
+{
+	va_list args;
+	gchar *msg;
+	va_start(args, format);
+	msg = g_strdup_vprintf(format, args);
+	va_end(args);
+
+	sipe_backend_debug_literal(level, msg);
+	g_free(msg);
+}
+gboolean sipe_backend_debug_enabled(void)
+{
+	return TRUE;
+}
+
+const gchar *sip_transport_epid(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+const gchar *sip_transport_ip_address(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private) { return(NULL); }
+char *generateUUIDfromEPID(SIPE_UNUSED_PARAMETER const gchar *epid) { return(NULL); }
+char *sipe_get_epid(SIPE_UNUSED_PARAMETER const char *self_sip_uri,
+		    SIPE_UNUSED_PARAMETER const char *hostname,
+		    SIPE_UNUSED_PARAMETER const char *ip_address) { return(NULL); }
+
+/* stub for MIME backend: only the simple parser is tested */
+void sipe_mime_parts_foreach(SIPE_UNUSED_PARAMETER const gchar *type,
+			     SIPE_UNUSED_PARAMETER const gchar *body,
+			     SIPE_UNUSED_PARAMETER sipe_mime_parts_cb callback,
+			     SIPE_UNUSED_PARAMETER gpointer user_data) {}
+
+/* test helpers */
+static guint succeeded = 0;
+static guint failed    = 0;
+
+/* collects "<Content-Type>|<body>" for each part */
+static void collect_cb(gpointer user_data,
+		       const GSList *fields,
+		       const gchar *body,
+		       gsize length)
+{
+	GString *result = user_data;
+	const gchar *type = sipe_utils_nameval_find(fields, "Content-Type");
+
+	if (result->len)
+		g_string_append_c(result, '#');
+	g_string_append(result, type ? type : "(nil)");
+	g_string_append_c(result, '|');
+	g_string_append_len(result, body, length);
+}
+
+static void assert_parts(const gchar *name,
+			 const gchar *type,
+			 const gchar *body,
+			 gboolean expected_ok,
+			 const gchar *expected_parts)
+{
+	GString *result = g_string_new("");
+	gboolean ok = sipe_mime_parts_foreach_simple(type,
+						     body,
+						     collect_cb,
+						     result);
+
+	if ((ok == expected_ok) &&
+	    sipe_strequal(result->str, expected_parts)) {
+		succeeded++;
+	} else {
+		printf("[%s]\nMIME parse FAILED: %s (expected %s) parts '%s' (expected '%s')\n",
+		       name,
+		       ok ? "TRUE" : "FALSE",
+		       expected_ok ? "TRUE" : "FALSE",
+		       result->str, expected_parts);
+		failed++;
+	}
+
+	g_string_free(result, TRUE);
+}
+
+/* counts parts whose body points into the document */
+struct in_place_data {
+	const gchar *start;
+	const gchar *end;
+	guint parts;
+};
+
+static void in_place_cb(gpointer user_data,
+			SIPE_UNUSED_PARAMETER const GSList *fields,
+			const gchar *body,
+			gsize length)
+{
+	struct in_place_data *data = user_data;
+
+	if ((body >= data->start) && (body + length <= data->end))
+		data->parts++;
+}
+
+static void assert_in_place(const gchar *name,
+			    const gchar *type,
+			    const gchar *body,
+			    guint expected_parts)
+{
+	struct in_place_data data;
+
+	data.start = body;
+	data.end   = body + strlen(body);
+	data.parts = 0;
+	sipe_mime_parts_foreach_simple(type, body, in_place_cb, &data);
+
+	if (data.parts == expected_parts) {
+		succeeded++;
+	} else {
+		printf("[%s]\nMIME in place FAILED: %u parts (expected %u)\n",
+		       name, data.parts, expected_parts);
+		failed++;
+	}
+}
+
+#define MULTIPART "multipart/alternative;boundary=\"b1\""
+
+int main(SIPE_UNUSED_PARAMETER int argc, SIPE_UNUSED_PARAMETER char **argv)
+{
+	assert_parts("CRLF",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b1\r\n"
+		     "Content-Type: text/html\r\n"
+		     "\r\n"
+		     "<b>html</b>\r\n"
+		     "--b1--\r\n",
+		     TRUE,
+		     "text/plain|plain#text/html|<b>html</b>");
+
+	assert_parts("LF",
+		     MULTIPART,
+		     "--b1\n"
+		     "Content-Type: text/plain\n"
+		     "\n"
+		     "plain\n"
+		     "--b1\n"
+		     "Content-Type: text/html\n"
+		     "\n"
+		     "<b>html</b>\n"
+		     "--b1--\n",
+		     TRUE,
+		     "text/plain|plain#text/html|<b>html</b>");
+
+	/* LF header separator must win over CRLF empty line in body */
+	assert_parts("LF headers, CRLF body",
+		     MULTIPART,
+		     "--b1\n"
+		     "Content-Type: text/plain\n"
+		     "\n"
+		     "line1\r\n"
+		     "\r\n"
+		     "line2\n"
+		     "--b1--\n",
+		     TRUE,
+		     "text/plain|line1\r\n\r\nline2");
+
+	/* and vice versa */
+	assert_parts("CRLF headers, LF body",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "\r\n"
+		     "line1\n"
+		     "\n"
+		     "line2\r\n"
+		     "--b1--\r\n",
+		     TRUE,
+		     "text/plain|line1\n\nline2");
+
+	assert_parts("folded header",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "Content-Type: text/plain;\r\n"
+		     "\tcharset=UTF-8\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b1--\r\n",
+		     TRUE,
+		     "text/plain;\tcharset=UTF-8|plain");
+
+	assert_parts("preamble and epilogue",
+		     "multipart/mixed; boundary=b1",
+		     "This is a preamble.\r\n"
+		     "It mentions --b1 in the middle of a line.\r\n"
+		     "--b1\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b1--\r\n"
+		     "This is an epilogue.\r\n",
+		     TRUE,
+		     "text/plain|plain");
+
+	/* same as GMime backend */
+	assert_parts("part without Content-Type",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "Content-ID: <1>\r\n"
+		     "\r\n"
+		     "untyped\r\n"
+		     "--b1\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b1--\r\n",
+		     TRUE,
+		     "(nil)|untyped#text/plain|plain");
+
+	assert_parts("part without headers",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b1--\r\n",
+		     TRUE,
+		     "(nil)|plain");
+
+	/* documents that must be left to the MIME backend */
+	assert_parts("missing closing boundary",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b1\r\n"
+		     "Content-Type: text/html\r\n"
+		     "\r\n"
+		     "<b>html</b>\r\n",
+		     FALSE,
+		     "");
+	assert_parts("no parts",
+		     MULTIPART,
+		     "--b1--\r\n",
+		     FALSE,
+		     "");
+	assert_parts("transfer encoding",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "Content-Transfer-Encoding: base64\r\n"
+		     "\r\n"
+		     "cGxhaW4=\r\n"
+		     "--b1--\r\n",
+		     FALSE,
+		     "");
+	assert_parts("nested multipart",
+		     MULTIPART,
+		     "--b1\r\n"
+		     "Content-Type: multipart/related;boundary=b2\r\n"
+		     "\r\n"
+		     "--b2\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b2--\r\n"
+		     "--b1--\r\n",
+		     FALSE,
+		     "");
+	assert_parts("no boundary",
+		     "multipart/alternative",
+		     "--b1\r\n"
+		     "Content-Type: text/plain\r\n"
+		     "\r\n"
+		     "plain\r\n"
+		     "--b1--\r\n",
+		     FALSE,
+		     "");
+	assert_parts("not multipart",
+		     "text/plain",
+		     "plain",
+		     FALSE,
+		     "");
+
+	/* part bodies are not copied */
+	assert_in_place("in place",
+			MULTIPART,
+			"--b1\r\n"
+			"Content-Type: text/plain\r\n"
+			"\r\n"
+			"plain\r\n"
+			"--b1\r\n"
+			"Content-Type: text/html\r\n"
+			"\r\n"
+			"<b>html</b>\r\n"
+			"--b1--\r\n",
+			2);
+
+	printf("Result: %d PASSED %d FAILED\n", succeeded, failed);
+	return(failed);
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
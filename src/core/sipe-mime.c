@@ -133,13 +133,16 @@ static void gmime_callback(SIPE_UNUSED_PARAMETER GMimeObject *parent,
 	}
 }
 
-void sipe_mime_parts_foreach(const gchar *type,
-			     const gchar *body,
-			     sipe_mime_parts_cb callback,
-			     gpointer user_data)
+static void gmime_parts_foreach(const gchar *type,
+				const gchar *body,
+				sipe_mime_parts_cb callback,
+				gpointer user_data)
 {
-	gchar *doc = g_strdup_printf("Content-Type: %s\r\n\r\n%s", type, body);
-	GMimeStream *stream = g_mime_stream_mem_new_with_buffer(doc, strlen(doc));
+	gchar *doc;
+	GMimeStream *stream;
+
+	doc = g_strdup_printf("Content-Type: %s\r\n\r\n%s", type, body);
+	stream = g_mime_stream_mem_new_with_buffer(doc, strlen(doc));
 
 	if (stream) {
 		GMimeParser *parser = g_mime_parser_new_with_stream(stream);
@@ -160,6 +163,15 @@ void sipe_mime_parts_foreach(const gchar *type,
 	g_free(doc);
 }
 
+void sipe_mime_parts_foreach(const gchar *type,
+			     const gchar *body,
+			     sipe_mime_parts_cb callback,
+			     gpointer user_data)
+{
+	if (!sipe_mime_parts_foreach_simple(type, body, callback, user_data))
+		gmime_parts_foreach(type, body, callback, user_data);
+}
+
 /*
   Local Variables:
   mode: c
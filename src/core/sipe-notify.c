@@ -353,11 +353,14 @@ static void process_incoming_notify_msrtc(struct sipe_core_private *sipe_private
 	time_t activity_since = 0;
 
 	/* fix for Reuters environment on Linux */
-	if (data && strstr(data, "encoding=\"utf-16\"")) {
+	/* NOTE: MIME part data is not NUL terminated */
+	if (data && g_strstr_len(data, len, "encoding=\"utf-16\"")) {
+		char *part = g_strndup(data, len);
 		char *tmp_data;
-		tmp_data = sipe_utils_str_replace(data, "encoding=\"utf-16\"", "encoding=\"utf-8\"");
+		tmp_data = sipe_utils_str_replace(part, "encoding=\"utf-16\"", "encoding=\"utf-8\"");
 		xn_presentity = sipe_xml_parse(tmp_data, strlen(tmp_data));
 		g_free(tmp_data);
+		g_free(part);
 	} else {
 		xn_presentity = sipe_xml_parse(data, len);
 	}
@@ -518,9 +521,8 @@ static void process_incoming_notify_msrtc(struct sipe_core_private *sipe_private
 	sbuddy = sipe_buddy_find_by_uri(sipe_private, uri);
 	if (sbuddy)
 	{
-		g_free(sbuddy->activity);
-		sbuddy->activity = activity;
-		activity = NULL;
+		sipe_utils_intern_release(sbuddy->activity);
+		sbuddy->activity = sipe_utils_intern(activity);
 
 		sbuddy->activity_since = activity_since;
 
@@ -533,9 +535,9 @@ static void process_incoming_notify_msrtc(struct sipe_core_private *sipe_private
 
 		sbuddy->is_oof_note = (xn_oof != NULL);
 
-		g_free(sbuddy->device_name);
+		sipe_utils_intern_release(sbuddy->device_name);
 		sbuddy->device_name = NULL;
-		if (!is_empty(device_name)) { sbuddy->device_name = g_strdup(device_name); }
+		if (!is_empty(device_name)) { sbuddy->device_name = sipe_utils_intern(device_name); }
 
 		if (!is_empty(cal_free_busy_base64)) {
 			g_free(sbuddy->cal_start_time);
@@ -552,8 +554,8 @@ static void process_incoming_notify_msrtc(struct sipe_core_private *sipe_private
 		}
 
 		sbuddy->last_non_cal_status_id = status_id;
-		g_free(sbuddy->last_non_cal_activity);
-		sbuddy->last_non_cal_activity = g_strdup(sbuddy->activity);
+		sipe_utils_intern_release(sbuddy->last_non_cal_activity);
+		sbuddy->last_non_cal_activity = sipe_utils_intern(sbuddy->activity);
 
 		if (sipe_strcase_equal(sbuddy->name, self_uri)) {
 			if (!sipe_strequal(sbuddy->note, sipe_private->note)) /* not same */
@@ -817,7 +819,7 @@ static void process_incoming_notify_rlmi(struct sipe_core_private *sipe_private,
 			}
 
 			/* activity */
-			g_free(sbuddy->activity);
+			sipe_utils_intern_release(sbuddy->activity);
 			sbuddy->activity = NULL;
 			if (xn_activity) {
 				const char *token = sipe_xml_attribute(xn_activity, "token");
@@ -825,16 +827,15 @@ static void process_incoming_notify_rlmi(struct sipe_core_private *sipe_private,
 
 				/* from token */
 				if (!is_empty(token)) {
-					sbuddy->activity = g_strdup(sipe_core_activity_description(sipe_status_token_to_activity(token)));
+					sbuddy->activity = sipe_utils_intern(sipe_core_activity_description(sipe_status_token_to_activity(token)));
 				}
 				/* from custom element */
 				if (xn_custom) {
 					char *custom = sipe_xml_data(xn_custom);
 
 					if (!is_empty(custom)) {
-						g_free(sbuddy->activity);
-						sbuddy->activity = custom;
-						custom = NULL;
+						sipe_utils_intern_release(sbuddy->activity);
+						sbuddy->activity = sipe_utils_intern(custom);
 					}
 					g_free(custom);
 				}
@@ -852,27 +853,27 @@ static void process_incoming_notify_rlmi(struct sipe_core_private *sipe_private,
 				g_free(meeting_subject);
 			}
 			/* meeting_location */
-			g_free(sbuddy->meeting_location);
+			sipe_utils_intern_release(sbuddy->meeting_location);
 			sbuddy->meeting_location = NULL;
 			if (xn_meeting_location) {
 				char *meeting_location = sipe_xml_data(xn_meeting_location);
 
-				if (!is_empty(meeting_location)) {
-					sbuddy->meeting_location = meeting_location;
-					meeting_location = NULL;
-				}
+				if (!is_empty(meeting_location))
+					sbuddy->meeting_location = sipe_utils_intern(meeting_location);
 				g_free(meeting_location);
 			}
 
 			status = sipe_ocs2007_status_from_legacy_availability(availability, NULL);
 			legacy_activity = sipe_ocs2007_legacy_activity_description(availability);
 			if (sbuddy->activity && legacy_activity) {
-				gchar *tmp2 = sbuddy->activity;
+				const gchar *tmp2 = sbuddy->activity;
+				gchar *combined = g_strdup_printf("%s, %s", sbuddy->activity, legacy_activity);
 
-				sbuddy->activity = g_strdup_printf("%s, %s", sbuddy->activity, legacy_activity);
-				g_free(tmp2);
+				sbuddy->activity = sipe_utils_intern(combined);
+				g_free(combined);
+				sipe_utils_intern_release(tmp2);
 			} else if (legacy_activity) {
-				sbuddy->activity = g_strdup(legacy_activity);
+				sbuddy->activity = sipe_utils_intern(legacy_activity);
 			}
 
 			do_update_status = TRUE;
@@ -434,8 +434,8 @@ void sipe_ocs2005_apply_calendar_status(struct sipe_core_private *sipe_private,
 	/* scheduled Cal update call */
 	if (!status_id) {
 		status_id = sbuddy->last_non_cal_status_id;
-		g_free(sbuddy->activity);
-		sbuddy->activity = g_strdup(sbuddy->last_non_cal_activity);
+		sipe_utils_intern_release(sbuddy->activity);
+		sbuddy->activity = sipe_utils_intern(sbuddy->last_non_cal_activity);
 	}
 
 	if (!status_id) {
@@ -452,8 +452,8 @@ void sipe_ocs2005_apply_calendar_status(struct sipe_core_private *sipe_private,
 		    (cal_avail_since > sbuddy->user_avail_since) &&
 		    sipe_ocs2007_status_is_busy(status_id)) {
 			status_id = sipe_status_activity_to_token(SIPE_ACTIVITY_BUSY);
-			g_free(sbuddy->activity);
-			sbuddy->activity = g_strdup(sipe_core_activity_description(SIPE_ACTIVITY_IN_MEETING));
+			sipe_utils_intern_release(sbuddy->activity);
+			sbuddy->activity = sipe_utils_intern(sipe_core_activity_description(SIPE_ACTIVITY_IN_MEETING));
 		}
 		avail = sipe_ocs2007_availability_from_status(status_id, NULL);
 
@@ -461,8 +461,8 @@ void sipe_ocs2005_apply_calendar_status(struct sipe_core_private *sipe_private,
 		if (cal_avail_since > sbuddy->activity_since) {
 			if ((cal_status == SIPE_CAL_OOF) &&
 			    sipe_ocs2007_availability_is_away(avail)) {
-				g_free(sbuddy->activity);
-				sbuddy->activity = g_strdup(sipe_core_activity_description(SIPE_ACTIVITY_OOF));
+				sipe_utils_intern_release(sbuddy->activity);
+				sbuddy->activity = sipe_utils_intern(sipe_core_activity_description(SIPE_ACTIVITY_OOF));
 			}
 		}
 	}
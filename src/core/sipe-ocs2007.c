@@ -256,8 +256,8 @@ struct sipe_container {
 
 /** MS-PRES container member */
 struct sipe_container_member {
-	/** user, domain, sameEnterprise, federated, publicCloud; everyone */
-	gchar *type;
+	/** user, domain, sameEnterprise, federated, publicCloud; everyone (pooled) */
+	const gchar *type;
 	gchar *value;
 };
 
@@ -268,7 +268,7 @@ static void free_container_member(struct sipe_container_member *member)
 {
 	if (!member) return;
 
-	g_free(member->type);
+	sipe_utils_intern_release(member->type);
 	g_free(member->value);
 	g_free(member);
 }
@@ -313,7 +313,7 @@ static struct sipe_container *create_container(guint index,
 
 	container->id = is_group ? (guint) -1 : containers[index];
 	container->members = g_slist_append(container->members, member);
-	member->type = g_strdup(member_type);
+	member->type = sipe_utils_intern(member_type);
 	member->value = g_strdup(member_value);
 
 	return(container);
@@ -323,6 +323,117 @@ void sipe_ocs2007_free(struct sipe_core_private *sipe_private)
 {
 	sipe_utils_slist_free_full(sipe_private->containers,
 				   (GDestroyNotify) sipe_ocs2007_free_container);
+	sipe_private->containers = NULL;
+
+	/* also called from connection cleanup, e.g. on redirect */
+	if (sipe_private->access_levels) {
+		g_hash_table_destroy(sipe_private->access_levels);
+		sipe_private->access_levels = NULL;
+	}
+}
+
+/*
+ * Access level index
+ *
+ * Maps a member key to a bit mask of the containers[] entries which
+ * contain that member. The lowest set bit is the container with the
+ * highest priority, i.e. the effective access level for the member.
+ *
+ * Member key is "<type>" or "<type>:<value>" in lower case, so that
+ * a member with NULL value doesn't match a member with empty value.
+ */
+static gchar *access_level_key(const gchar *type,
+			       const gchar *value)
+{
+	gchar *tmp = value ?
+		g_strdup_printf("%s:%s", type, value) :
+		g_strdup(type);
+	gchar *key = g_ascii_strdown(tmp, -1);
+	g_free(tmp);
+	return(key);
+}
+
+static guint access_level_container_index(guint id)
+{
+	guint i;
+	for (i = 0; i < CONTAINERS_LEN; i++)
+		if (containers[i] == id)
+			break;
+	return(i);
+}
+
+/* returns CONTAINERS_LEN for empty mask */
+static guint access_level_mask_index(guint mask)
+{
+	guint i;
+	for (i = 0; i < CONTAINERS_LEN; i++)
+		if (mask & (1 << i))
+			break;
+	return(i);
+}
+
+/**
+ * Add/remove container member to/from access level index
+ *
+ * @param changed if not @c NULL, remembers the effective container index
+ *                (+ 1) before the first update for each modified key.
+ */
+static void access_level_index_update(struct sipe_core_private *sipe_private,
+				      guint index,
+				      const struct sipe_container_member *member,
+				      gboolean add,
+				      GHashTable *changed)
+{
+	gchar *key;
+	guint old_mask, new_mask;
+
+	/* ignore members of unknown containers & invalid members */
+	if ((index >= CONTAINERS_LEN) || !member->type)
+		return;
+
+	if (!sipe_private->access_levels)
+		sipe_private->access_levels = g_hash_table_new_full(g_str_hash,
+								    g_str_equal,
+								    g_free,
+								    NULL);
+
+	key      = access_level_key(member->type, member->value);
+	old_mask = GPOINTER_TO_UINT(g_hash_table_lookup(sipe_private->access_levels,
+							key));
+	new_mask = add ? (old_mask | (1 << index)) : (old_mask & ~(1 << index));
+
+	if (changed &&
+	    (access_level_mask_index(old_mask) != access_level_mask_index(new_mask)) &&
+	    !g_hash_table_lookup(changed, key))
+		g_hash_table_insert(changed,
+				    g_strdup(key),
+				    GUINT_TO_POINTER(access_level_mask_index(old_mask) + 1));
+
+	if (new_mask)
+		/* table takes ownership of key */
+		g_hash_table_replace(sipe_private->access_levels,
+				     key,
+				     GUINT_TO_POINTER(new_mask));
+	else {
+		g_hash_table_remove(sipe_private->access_levels, key);
+		g_free(key);
+	}
+}
+
+static void access_level_index_container(struct sipe_core_private *sipe_private,
+					 const struct sipe_container *container,
+					 gboolean add,
+					 GHashTable *changed)
+{
+	guint index = access_level_container_index(container->id);
+	GSList *entry;
+
+	for (entry = container->members; entry; entry = entry->next)
+		access_level_index_update(sipe_private,
+					  index,
+					  entry->data,
+					  add,
+					  changed);
 }
 
 /**
@@ -374,25 +485,22 @@ static int sipe_find_member_access_level(struct sipe_core_private *sipe_private,
 					 const gchar *type,
 					 const gchar *value)
 {
-	unsigned int i = 0;
 	const gchar *value_mod = value;
+	gchar *key;
+	guint index;
 
-	if (!type) return -1;
+	if (!type || !sipe_private->access_levels) return -1;
 
 	if (sipe_strequal("user", type)) {
 		value_mod = sipe_get_no_sip_uri(value);
 	}
 
-	for (i = 0; i < CONTAINERS_LEN; i++) {
-		struct sipe_container_member *member;
-		struct sipe_container *container = sipe_find_container(sipe_private, containers[i]);
-		if (!container) continue;
-
-		member = sipe_find_container_member(container, type, value_mod);
-		if (member) return containers[i];
-	}
+	key   = access_level_key(type, value_mod);
+	index = access_level_mask_index(GPOINTER_TO_UINT(g_hash_table_lookup(sipe_private->access_levels,
+									     key)));
+	g_free(key);
 
-	return -1;
+	return((index < CONTAINERS_LEN) ? (int) containers[index] : -1);
 }
 
 /**
@@ -643,6 +751,8 @@ void sipe_ocs2007_change_access_level(struct sipe_core_private *sipe_private,
 				sipe_send_container_members_prepare(current_container_id, container->version, "remove", type, value, &container_xmls);
 				/* remove member from our cache, to be able to recalculate AL below */
 				container->members = g_slist_remove(container->members, member);
+				access_level_index_update(sipe_private, i, member, FALSE, NULL);
+				free_container_member(member);
 			}
 		}
 	}
@@ -2055,11 +2165,67 @@ static void sipe_refresh_blocked_status_cb(char *buddy_name,
 	}
 }
 
-static void sipe_refresh_blocked_status(struct sipe_core_private *sipe_private)
+struct refresh_blocked_data {
+	struct sipe_core_private *sipe_private;
+	GSList *users;
+	gboolean all;
+};
+
+static void sipe_refresh_blocked_changed_cb(const gchar *key,
+					    gpointer value,
+					    struct refresh_blocked_data *data)
 {
-	sipe_buddy_foreach(sipe_private,
-			   (GHFunc) sipe_refresh_blocked_status_cb,
-			   sipe_private);
+	struct sipe_core_private *sipe_private = data->sipe_private;
+	guint mask = GPOINTER_TO_UINT(g_hash_table_lookup(sipe_private->access_levels,
+							  key));
+
+	/* effective access level unchanged? */
+	if ((GPOINTER_TO_UINT(value) - 1) == access_level_mask_index(mask))
+		return;
+
+	/* only a "user" member can be mapped to a single buddy */
+	if (g_str_has_prefix(key, "user:"))
+		data->users = g_slist_prepend(data->users,
+					      g_strdup_printf("sip:%s", key + 5));
+	else
+		data->all = TRUE;
+}
+
+/**
+ * Refresh blocked status of buddies affected by access level changes
+ *
+ * @param changed keys of modified access levels (see access_level_index_update())
+ */
+static void sipe_refresh_blocked_status(struct sipe_core_private *sipe_private,
+					GHashTable *changed)
+{
+	struct refresh_blocked_data data;
+
+	data.sipe_private = sipe_private;
+	data.users        = NULL;
+	data.all          = FALSE;
+	g_hash_table_foreach(changed,
+			     (GHFunc) sipe_refresh_blocked_changed_cb,
+			     &data);
+
+	if (data.all) {
+		sipe_buddy_foreach(sipe_private,
+				   (GHFunc) sipe_refresh_blocked_status_cb,
+				   sipe_private);
+	} else {
+		GSList *entry;
+
+		for (entry = data.users; entry; entry = entry->next) {
+			struct sipe_buddy *buddy = sipe_buddy_find_by_uri(sipe_private,
+									  entry->data);
+			if (buddy)
+				sipe_refresh_blocked_status_cb(buddy->name,
+							       buddy,
+							       sipe_private);
+		}
+	}
+
+	sipe_utils_slist_free_full(data.users, g_free);
 }
 
 /**
@@ -2081,6 +2247,7 @@ void sipe_ocs2007_process_roaming_self(struct sipe_core_private *sipe_private,
 	int aggreg_avail = 0;
 	gchar *activity_token = NULL;
 	gboolean do_update_status = FALSE;
+	GHashTable *changed_access_levels;
 	gboolean has_note_cleaned = FALSE;
 	GHashTable *devices;
 
@@ -2365,11 +2532,14 @@ void sipe_ocs2007_process_roaming_self(struct sipe_core_private *sipe_private,
 	g_hash_table_destroy(devices);
 
 	/* containers */
+	changed_access_levels = g_hash_table_new_full(g_str_hash, g_str_equal,
+						      g_free, NULL);
 	for (node = sipe_xml_child(xml, "containers/container"); node; node = sipe_xml_twin(node)) {
 		guint id = sipe_xml_int_attribute(node, "id", 0);
 		struct sipe_container *container = sipe_find_container(sipe_private, id);
 
 		if (container) {
+			access_level_index_container(sipe_private, container, FALSE, changed_access_levels);
 			sipe_private->containers = g_slist_remove(sipe_private->containers, container);
 			SIPE_DEBUG_INFO("sipe_ocs2007_process_roaming_self: removed existing container id=%d v%d", container->id, container->version);
 			sipe_ocs2007_free_container(container);
@@ -2382,12 +2552,13 @@ void sipe_ocs2007_process_roaming_self(struct sipe_core_private *sipe_private,
 
 		for (node2 = sipe_xml_child(node, "member"); node2; node2 = sipe_xml_twin(node2)) {
 			struct sipe_container_member *member = g_new0(struct sipe_container_member, 1);
-			member->type = g_strdup(sipe_xml_attribute(node2, "type"));
+			member->type = sipe_utils_intern(sipe_xml_attribute(node2, "type"));
 			member->value = g_strdup(sipe_xml_attribute(node2, "value"));
 			container->members = g_slist_append(container->members, member);
 			SIPE_DEBUG_INFO("sipe_ocs2007_process_roaming_self: added container member type=%s value=%s",
 					member->type, member->value ? member->value : "");
 		}
+		access_level_index_container(sipe_private, container, TRUE, changed_access_levels);
 	}
 
 	SIPE_DEBUG_INFO("sipe_ocs2007_process_roaming_self: access_level_set=%s",
@@ -2419,7 +2590,8 @@ void sipe_ocs2007_process_roaming_self(struct sipe_core_private *sipe_private,
 	}
 
 	/* Refresh contacts' blocked status */
-	sipe_refresh_blocked_status(sipe_private);
+	sipe_refresh_blocked_status(sipe_private, changed_access_levels);
+	g_hash_table_destroy(changed_access_levels);
 
 	/* subscribers */
 	for (node = sipe_xml_child(xml, "subscribers/subscriber"); node; node = sipe_xml_twin(node)) {
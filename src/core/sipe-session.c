@@ -33,6 +33,7 @@
 #include "sip-transport.h"
 #include "sipe-backend.h"
 #include "sipe-chat.h"
+#include "sipe-common.h"
 #include "sipe-conf.h"
 #include "sipe-core.h"
 #include "sipe-core-private.h"
@@ -48,6 +49,137 @@ sipe_free_queued_message(struct queued_message *message)
 	g_free(message);
 }
 
+/* Hash indices over sipe_private->sessions */
+struct sipe_session_index {
+	GHashTable *callid;     /* Call-ID   -> multiparty/conference session */
+	GHashTable *im;         /* peer URI  -> IM session */
+	GHashTable *conference; /* focus URI -> conference session */
+	GHashTable *chat;       /* struct sipe_chat_session -> session */
+};
+
+static struct sipe_session_index *
+session_index(struct sipe_core_private *sipe_private)
+{
+	struct sipe_session_index *index = sipe_private->session_index;
+
+	if (!index) {
+		sipe_private->session_index = index = g_new0(struct sipe_session_index, 1);
+		/* keys are copies: fields can be changed before re-indexing */
+		index->callid     = g_hash_table_new_full(sipe_strcase_hash,
+							  (GEqualFunc) sipe_strcase_equal,
+							  g_free, NULL);
+		index->im         = g_hash_table_new_full(sipe_strcase_hash,
+							  (GEqualFunc) sipe_strcase_equal,
+							  g_free, NULL);
+		index->conference = g_hash_table_new_full(sipe_strcase_hash,
+							  (GEqualFunc) sipe_strcase_equal,
+							  g_free, NULL);
+		index->chat       = g_hash_table_new(g_direct_hash,
+						     g_direct_equal);
+	}
+
+	return(index);
+}
+
+static void
+session_index_insert(GHashTable *table,
+		     const gchar *key,
+		     struct sip_session *session)
+{
+	/* first session wins, same as a search through the list */
+	if (key && !g_hash_table_lookup(table, key))
+		g_hash_table_insert(table, g_strdup(key), session);
+}
+
+static void
+session_index_add(struct sipe_core_private *sipe_private,
+		  struct sip_session *session)
+{
+	struct sipe_session_index *index = session_index(sipe_private);
+	struct sipe_chat_session *chat_session = session->chat_session;
+
+	session_index_insert(index->callid, session->callid, session);
+	if (!session->is_call)
+		session_index_insert(index->im, session->with, session);
+
+	if (chat_session) {
+		if (!g_hash_table_lookup(index->chat, chat_session))
+			g_hash_table_insert(index->chat, chat_session, session);
+		if (chat_session->type == SIPE_CHAT_TYPE_CONFERENCE)
+			session_index_insert(index->conference,
+					     chat_session->id,
+					     session);
+	}
+}
+
+static gboolean
+session_index_match(SIPE_UNUSED_PARAMETER gpointer key,
+		    gpointer value,
+		    gpointer user_data)
+{
+	return(value == user_data);
+}
+
+static void
+session_index_remove(struct sipe_core_private *sipe_private,
+		     struct sip_session *session)
+{
+	struct sipe_session_index *index = sipe_private->session_index;
+
+	if (index) {
+		guint removed;
+
+		/* keys might no longer match the session fields */
+		removed  = g_hash_table_foreach_remove(index->callid,
+						       session_index_match,
+						       session);
+		removed += g_hash_table_foreach_remove(index->im,
+						       session_index_match,
+						       session);
+		removed += g_hash_table_foreach_remove(index->conference,
+						       session_index_match,
+						       session);
+		removed += g_hash_table_foreach_remove(index->chat,
+						       session_index_match,
+						       session);
+
+		/*
+		 * index next session with the same key, if any. Only the
+		 * removed keys are missing, i.e. the first session in the
+		 * list with the same key gets it.
+		 */
+		if (removed) {
+			GSList *entry;
+
+			for (entry = sipe_private->sessions; entry; entry = entry->next)
+				session_index_add(sipe_private, entry->data);
+		}
+	}
+}
+
+static void
+session_index_free(struct sipe_core_private *sipe_private)
+{
+	struct sipe_session_index *index = sipe_private->session_index;
+
+	if (index) {
+		g_hash_table_destroy(index->chat);
+		g_hash_table_destroy(index->conference);
+		g_hash_table_destroy(index->im);
+		g_hash_table_destroy(index->callid);
+		g_free(index);
+		sipe_private->session_index = NULL;
+	}
+}
+
+static void
+session_append(struct sipe_core_private *sipe_private,
+	       struct sip_session *session)
+{
+	sipe_private->sessions = g_slist_append(sipe_private->sessions, session);
+	session_index_add(sipe_private, session);
+}
+
 struct sip_session *
 sipe_session_add_chat(struct sipe_core_private *sipe_private,
 		      struct sipe_chat_session *chat_session,
@@ -70,7 +202,7 @@ sipe_session_add_chat(struct sipe_core_private *sipe_private,
 	session->unconfirmed_messages = g_hash_table_new_full(
 		g_str_hash, g_str_equal, g_free, (GDestroyNotify)sipe_free_queued_message);
 	session->conf_unconfirmed_messages = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
-	sipe_private->sessions = g_slist_append(sipe_private->sessions, session);
+	session_append(sipe_private, session);
 	return session;
 }
 
@@ -86,7 +218,7 @@ sipe_session_add_call(struct sipe_core_private *sipe_private,
 	session->unconfirmed_messages = g_hash_table_new_full(
 		g_str_hash, g_str_equal, g_free, (GDestroyNotify)sipe_free_queued_message);
 	session->is_call = TRUE;
-	sipe_private->sessions = g_slist_append(sipe_private->sessions, session);
+	session_append(sipe_private, session);
 	return session;
 }
 
@@ -96,51 +228,46 @@ struct sip_session *
 sipe_session_find_chat(struct sipe_core_private *sipe_private,
 		       struct sipe_chat_session *chat_session)
 {
-	if (sipe_private == NULL || chat_session == NULL) {
+	if (sipe_private == NULL || chat_session == NULL ||
+	    sipe_private->session_index == NULL) {
 		return NULL;
 	}
 
-	SIPE_SESSION_FOREACH {
-		if (session->chat_session == chat_session) {
-			return session;
-		}
-	} SIPE_SESSION_FOREACH_END;
-	return NULL;
-
+	return(g_hash_table_lookup(sipe_private->session_index->chat,
+				   chat_session));
 }
 
 struct sip_session *
 sipe_session_find_chat_by_callid(struct sipe_core_private *sipe_private,
 				 const gchar *callid)
 {
-	if (sipe_private == NULL || callid == NULL) {
+	if (sipe_private == NULL || callid == NULL ||
+	    sipe_private->session_index == NULL) {
 		return NULL;
 	}
 
-	SIPE_SESSION_FOREACH {
-		if (session->callid &&
-		    sipe_strcase_equal(callid, session->callid)) {
-			return session;
-		}
-	} SIPE_SESSION_FOREACH_END;
-	return NULL;
+	return(g_hash_table_lookup(sipe_private->session_index->callid,
+				   callid));
 }
 
 struct sip_session *
 sipe_session_find_conference(struct sipe_core_private *sipe_private,
 			     const gchar *focus_uri)
 {
-	if (sipe_private == NULL || focus_uri == NULL) {
+	struct sip_session *session;
+
+	if (sipe_private == NULL || focus_uri == NULL ||
+	    sipe_private->session_index == NULL) {
 		return NULL;
 	}
 
-	SIPE_SESSION_FOREACH {
-		if (session->chat_session &&
-		    (session->chat_session->type == SIPE_CHAT_TYPE_CONFERENCE) &&
-		    sipe_strcase_equal(focus_uri, session->chat_session->id)) {
-			return session;
-		}
-	} SIPE_SESSION_FOREACH_END;
+	session = g_hash_table_lookup(sipe_private->session_index->conference,
+				      focus_uri);
+	if (session &&
+	    session->chat_session &&
+	    (session->chat_session->type == SIPE_CHAT_TYPE_CONFERENCE)) {
+		return session;
+	}
 	return NULL;
 }
 
@@ -148,16 +275,17 @@ struct sip_session *
 sipe_session_find_im(struct sipe_core_private *sipe_private,
 		     const gchar *who)
 {
-	if (sipe_private == NULL || who == NULL) {
+	struct sip_session *session;
+
+	if (sipe_private == NULL || who == NULL ||
+	    sipe_private->session_index == NULL) {
 		return NULL;
 	}
 
-	SIPE_SESSION_FOREACH {
-		if (!session->is_call &&
-		    session->with && sipe_strcase_equal(who, session->with)) {
-			return session;
-		}
-	} SIPE_SESSION_FOREACH_END;
+	session = g_hash_table_lookup(sipe_private->session_index->im, who);
+	if (session && !session->is_call) {
+		return session;
+	}
 	return NULL;
 }
 
@@ -172,7 +300,7 @@ sipe_session_find_or_add_im(struct sipe_core_private *sipe_private,
 		session->with = g_strdup(who);
 		session->unconfirmed_messages = g_hash_table_new_full(
 			g_str_hash, g_str_equal, g_free, (GDestroyNotify)sipe_free_queued_message);
-		sipe_private->sessions = g_slist_append(sipe_private->sessions, session);
+		session_append(sipe_private, session);
 	}
 	return session;
 }
@@ -195,6 +323,10 @@ sipe_session_remove(struct sipe_core_private *sipe_private,
 		    struct sip_session *session)
 {
 	sipe_private->sessions = g_slist_remove(sipe_private->sessions, session);
+	if (sipe_private->sessions)
+		session_index_remove(sipe_private, session);
+	else
+		session_index_free(sipe_private);
 
 	sipe_dialog_remove_all(session);
 	sipe_dialog_free(session->focus_dialog);
@@ -206,6 +338,8 @@ sipe_session_remove(struct sipe_core_private *sipe_private,
 	g_hash_table_destroy(session->unconfirmed_messages);
 	if (session->conf_unconfirmed_messages)
 		g_hash_table_destroy(session->conf_unconfirmed_messages);
+	if (session->conf_roster)
+		g_hash_table_destroy(session->conf_roster);
 
 	g_free(session->with);
 	g_free(session->callid);
@@ -215,6 +349,24 @@ sipe_session_remove(struct sipe_core_private *sipe_private,
 	g_free(session);
 }
 
+void
+sipe_session_reindex(struct sipe_core_private *sipe_private,
+		     struct sip_session *session)
+{
+	session_index_remove(sipe_private, session);
+	session_index_add(sipe_private, session);
+}
+
+void
+sipe_session_set_callid(struct sipe_core_private *sipe_private,
+			struct sip_session *session,
+			const gchar *callid)
+{
+	g_free(session->callid);
+	session->callid = g_strdup(callid);
+	sipe_session_reindex(sipe_private, session);
+}
+
 void
 sipe_session_close(struct sipe_core_private *sipe_private,
 		   struct sip_session *session)
@@ -46,6 +46,8 @@ struct sip_session {
 	gchar *with; /* For IM or call sessions only (not multi-party) . A URI.*/
 	/** key is user (URI) */
 	GSList *dialogs;
+	/** dialogs indexed by user (URI), see sipe-dialog.c */
+	GHashTable *dialogs_by_with;
 	/** Key is <Call-ID><CSeq><METHOD><To> */
 	GHashTable *unconfirmed_messages;
 	GSList *outgoing_message_queue;
@@ -70,6 +72,8 @@ struct sip_session {
 	GHashTable *conf_unconfirmed_messages;
 	gchar *audio_video_entity;
 	guint audio_media_id;
+	/** Key is user URI, see sipe-conf.c */
+	GHashTable *conf_roster;
 
 	/*
 	 * Media call related fields
@@ -226,6 +230,31 @@ void
 sipe_session_remove(struct sipe_core_private *sipe_private,
 		    struct sip_session *session);
 
+/**
+ * Update session lookup indices
+ *
+ * Must be called after changing fields used by the sipe_session_find_xxx()
+ * functions, i.e. @c with, @c callid or @c chat_session, directly.
+ *
+ * @param sipe_private (in) SIPE core data
+ * @param session (in) pointer to session
+ */
+void
+sipe_session_reindex(struct sipe_core_private *sipe_private,
+		     struct sip_session *session);
+
+/**
+ * Set Call-ID of a session
+ *
+ * @param sipe_private (in) SIPE core data
+ * @param session (in) pointer to session
+ * @param callid (in) Call-ID, will be copied
+ */
+void
+sipe_session_set_callid(struct sipe_core_private *sipe_private,
+			struct sip_session *session,
+			const gchar *callid);
+
 /**
  * Add a message to outgoing queue.
  *
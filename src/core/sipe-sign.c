@@ -28,145 +28,268 @@
 #include "sipmsg.h"
 #include "sipe-backend.h"
 #include "sipe-sign.h"
+#include "sipe-utils.h"
 
-static gchar * const empty_string = "";
+/* headers used for the signature input, see sipmsg_breakdown_parse() */
+enum {
+	BREAKDOWN_PROXY_AUTHORIZATION = 0,
+	BREAKDOWN_PROXY_AUTHENTICATION_INFO,
+	BREAKDOWN_AUTHENTICATION_INFO,
+	BREAKDOWN_CALL_ID,
+	BREAKDOWN_CSEQ,
+	BREAKDOWN_FROM,
+	BREAKDOWN_TO,
+	BREAKDOWN_P_ASSERTED_IDENTITY,
+	BREAKDOWN_P_PREFERRED_IDENTITY,
+	BREAKDOWN_EXPIRES,
+	BREAKDOWN_HEADERS
+};
 
-void sipmsg_breakdown_parse(struct sipmsg_breakdown * msg, gchar * realm, gchar * target,
+static const gchar * const breakdown_headers[BREAKDOWN_HEADERS] = {
+	"Proxy-Authorization",
+	"Proxy-Authentication-Info",
+	"Authentication-Info",
+	"Call-ID",
+	"CSeq",
+	"From",
+	"To",
+	"P-Asserted-Identity",
+	"P-Preferred-Identity",
+	"Expires",
+};
+
+void sipmsg_breakdown_part_set(struct sipmsg_breakdown_part *part,
+			       const gchar *value)
+{
+	part->value  = value;
+	part->length = value ? strlen(value) : 0;
+}
+
+static void sipmsg_breakdown_part_set_len(struct sipmsg_breakdown_part *part,
+					  const gchar *value,
+					  gsize length)
+{
+	part->value  = value;
+	part->length = length;
+}
+
+/* same semantics as sipmsg_find_part_of_header() with def = "" */
+static void sipmsg_breakdown_part_find(struct sipmsg_breakdown_part *part,
+				       const gchar *hdr,
+				       const gchar *before,
+				       const gchar *after)
+{
+	const gchar *start = before ? strstr(hdr, before) : hdr;
+
+	if (start) {
+		const gchar *end;
+
+		if (before)
+			start += strlen(before);
+
+		end = strstr(start, after);
+		if (end)
+			sipmsg_breakdown_part_set_len(part, start, end - start);
+		else
+			sipmsg_breakdown_part_set(part, start);
+	} else {
+		sipmsg_breakdown_part_set(part, "");
+	}
+}
+
+/* same semantics as sipmsg_parse_p_asserted_identity() */
+static void sipmsg_breakdown_p_asserted_identity(struct sipmsg_breakdown *msgbd,
+						 const gchar *hdr)
+{
+	if (g_ascii_strncasecmp(hdr, "tel:", 4) == 0) {
+		sipmsg_breakdown_part_set(&msgbd->p_assertet_identity_tel_uri,
+					  hdr);
+		return;
+	}
+
+	while (*hdr) {
+		const gchar *comma = strchr(hdr, ',');
+		gsize length       = comma ? (gsize) (comma - hdr) : strlen(hdr);
+		const gchar *uri   = memchr(hdr, '<', length);
+
+		if (uri) {
+			const gchar *end;
+
+			uri++;
+			end = memchr(uri, '>', length - (uri - hdr));
+			if (!end)
+				end = hdr + length;
+
+			if (g_ascii_strncasecmp(uri, "sip:", 4) == 0) {
+				if (msgbd->p_assertet_identity_sip_uri.value)
+					SIPE_DEBUG_WARNING_NOFORMAT("More than one "
+						"sip: URI found in P-Asserted-Identity!");
+				else
+					sipmsg_breakdown_part_set_len(&msgbd->p_assertet_identity_sip_uri,
+								      uri,
+								      end - uri);
+			} else if (g_ascii_strncasecmp(uri, "tel:", 4) == 0) {
+				if (msgbd->p_assertet_identity_tel_uri.value)
+					SIPE_DEBUG_WARNING_NOFORMAT("More than one "
+						"tel: URI found in P-Asserted-Identity!");
+				else
+					sipmsg_breakdown_part_set_len(&msgbd->p_assertet_identity_tel_uri,
+								      uri,
+								      end - uri);
+			}
+		}
+
+		if (!comma)
+			break;
+		hdr = comma + 1;
+	}
+}
+
+void sipmsg_breakdown_parse(struct sipmsg_breakdown *msgbd,
+			    const gchar *realm,
+			    const gchar *target,
 			    const gchar *protocol)
 {
-	const gchar * hdr;
-	if (msg == NULL || msg->msg == NULL) {
+	const gchar *headers[BREAKDOWN_HEADERS];
+	struct sipmsg *msg;
+	const gchar *hdr;
+	GSList *entry;
+
+	if (msgbd == NULL || msgbd->msg == NULL) {
 		SIPE_DEBUG_INFO_NOFORMAT("sipmsg_breakdown_parse msg or msg->msg is NULL");
 		return;
 	}
 
-	msg->rand = msg->num = msg->realm = msg->target_name =
-		msg->cseq = msg->from_url = msg->from_tag = msg->to_url = msg->to_tag =
-		msg->p_assertet_identity_sip_uri = msg->p_assertet_identity_tel_uri = empty_string;
-	msg->call_id = msg->expires = empty_string;
-
-	if ((hdr = sipmsg_find_header(msg->msg, "Proxy-Authorization")) ||
-	    (hdr = sipmsg_find_header(msg->msg, "Proxy-Authentication-Info")) ||
-	    (hdr = sipmsg_find_header(msg->msg, "Authentication-Info")) ) {
-		msg->protocol = sipmsg_find_part_of_header(hdr, NULL, " ", empty_string);
-		msg->rand   = sipmsg_find_part_of_header(hdr, "rand=\"", "\"", empty_string);
-		msg->num    = sipmsg_find_part_of_header(hdr, "num=\"", "\"", empty_string);
-		msg->realm  = sipmsg_find_part_of_header(hdr, "realm=\"", "\"", empty_string);
-		msg->target_name = sipmsg_find_part_of_header(hdr, "targetname=\"", "\"", empty_string);
+	/* all parts empty */
+	msg = msgbd->msg;
+	memset(msgbd, 0, sizeof(struct sipmsg_breakdown));
+	msgbd->msg = msg;
+
+	/*
+	 * Collect all required headers in one pass.
+	 * First instance wins, same as sipmsg_find_header().
+	 */
+	memset(headers, 0, sizeof(headers));
+	for (entry = msg->headers; entry; entry = entry->next) {
+		const struct sipnameval *elem = entry->data;
+		gchar first = g_ascii_tolower(elem->name[0]);
+		guint i;
+
+		for (i = 0; i < BREAKDOWN_HEADERS; i++) {
+			/* cheap pre-check before the full comparison */
+			if (!headers[i] &&
+			    (g_ascii_tolower(breakdown_headers[i][0]) == first) &&
+			    sipe_strcase_equal(elem->name, breakdown_headers[i])) {
+				headers[i] = elem->value;
+				break;
+			}
+		}
+	}
+
+	if ((hdr = headers[BREAKDOWN_PROXY_AUTHORIZATION]) ||
+	    (hdr = headers[BREAKDOWN_PROXY_AUTHENTICATION_INFO]) ||
+	    (hdr = headers[BREAKDOWN_AUTHENTICATION_INFO])) {
+		sipmsg_breakdown_part_find(&msgbd->protocol,    hdr, NULL,            " ");
+		sipmsg_breakdown_part_find(&msgbd->rand,        hdr, "rand=\"",       "\"");
+		sipmsg_breakdown_part_find(&msgbd->num,         hdr, "num=\"",        "\"");
+		sipmsg_breakdown_part_find(&msgbd->realm,       hdr, "realm=\"",      "\"");
+		sipmsg_breakdown_part_find(&msgbd->target_name, hdr, "targetname=\"", "\"");
 	} else {
-		msg->protocol = g_strdup(protocol);
-		msg->realm = g_strdup(realm);
-		msg->target_name = g_strdup(target);
+		sipmsg_breakdown_part_set(&msgbd->protocol,    protocol);
+		sipmsg_breakdown_part_set(&msgbd->realm,       realm);
+		sipmsg_breakdown_part_set(&msgbd->target_name, target);
 	}
 
-	msg->call_id = sipmsg_find_header(msg->msg, "Call-ID");
+	sipmsg_breakdown_part_set(&msgbd->call_id, headers[BREAKDOWN_CALL_ID]);
 
-	hdr = sipmsg_find_header(msg->msg, "CSeq");
+	hdr = headers[BREAKDOWN_CSEQ];
 	if (NULL != hdr) {
-		msg->cseq = sipmsg_find_part_of_header(hdr, NULL, " ", empty_string);
+		sipmsg_breakdown_part_find(&msgbd->cseq, hdr, NULL, " ");
 	}
 
-	hdr = sipmsg_find_header(msg->msg, "From");
+	hdr = headers[BREAKDOWN_FROM];
 	if (NULL != hdr) {
-		msg->from_url = sipmsg_find_part_of_header(hdr, "<", ">", empty_string);
-		msg->from_tag = sipmsg_find_part_of_header(hdr, ";tag=", ";", empty_string);
+		sipmsg_breakdown_part_find(&msgbd->from_url, hdr, "<", ">");
+		sipmsg_breakdown_part_find(&msgbd->from_tag, hdr, ";tag=", ";");
 	}
 
-	hdr = sipmsg_find_header(msg->msg, "To");
+	hdr = headers[BREAKDOWN_TO];
 	if (NULL != hdr) {
-		msg->to_url = sipmsg_find_part_of_header(hdr, "<", ">", empty_string);
-		msg->to_tag = sipmsg_find_part_of_header(hdr, ";tag=", ";", empty_string);
+		sipmsg_breakdown_part_find(&msgbd->to_url, hdr, "<", ">");
+		sipmsg_breakdown_part_find(&msgbd->to_tag, hdr, ";tag=", ";");
 	}
 
-	hdr = sipmsg_find_header(msg->msg, "P-Asserted-Identity");
+	hdr = headers[BREAKDOWN_P_ASSERTED_IDENTITY];
 	if (NULL == hdr) {
-		hdr = sipmsg_find_header(msg->msg, "P-Preferred-Identity");
+		hdr = headers[BREAKDOWN_P_PREFERRED_IDENTITY];
 	}
 	if (NULL != hdr) {
-		gchar *sip_uri = NULL;
-		gchar *tel_uri = NULL;
-
-		sipmsg_parse_p_asserted_identity(hdr, &sip_uri, &tel_uri);
-		if (sip_uri)
-			msg->p_assertet_identity_sip_uri = sip_uri;
-		if (tel_uri)
-			msg->p_assertet_identity_tel_uri = tel_uri;
+		sipmsg_breakdown_p_asserted_identity(msgbd, hdr);
 	}
 
-	msg->expires = sipmsg_find_header(msg->msg, "Expires");
-}
-
-void
-sipmsg_breakdown_free(struct sipmsg_breakdown * msg)
-{
-	if (msg->protocol != empty_string)
-		g_free(msg->protocol);
-	if (msg->rand != empty_string)
-		g_free(msg->rand);
-	if (msg->num != empty_string)
-		g_free(msg->num);
-	if (msg->realm != empty_string)
-		g_free(msg->realm);
-	if (msg->target_name != empty_string)
-		g_free(msg->target_name);
-
-	// straight from header
-	//g_free(msg->call_id);
-
-	if (msg->cseq != empty_string)
-		g_free(msg->cseq);
-	if (msg->from_url != empty_string)
-		g_free(msg->from_url);
-	if (msg->from_tag != empty_string)
-		g_free(msg->from_tag);
-	if (msg->to_url != empty_string)
-		g_free(msg->to_url);
-	if (msg->to_tag != empty_string)
-		g_free(msg->to_tag);
-
-	if (msg->p_assertet_identity_sip_uri != empty_string)
-		g_free(msg->p_assertet_identity_sip_uri);
-	if (msg->p_assertet_identity_tel_uri != empty_string)
-		g_free(msg->p_assertet_identity_tel_uri);
-
-	// straight from header
-	//g_free (msg->expires);
+	sipmsg_breakdown_part_set(&msgbd->expires, headers[BREAKDOWN_EXPIRES]);
 }
 
 gchar *
 sipmsg_breakdown_get_string(int version,
 			    struct sipmsg_breakdown * msgbd)
 {
-	gchar *response_str;
+	const struct sipmsg_breakdown_part *parts[15];
+	struct sipmsg_breakdown_part method;
+	gchar response_str[16];
+	gsize response_length = 0;
+	gsize length;
+	guint count = 0;
+	guint i;
 	gchar *msg;
-	if (msgbd->realm == empty_string || msgbd->realm == NULL) {
+	gchar *p;
+
+	if (msgbd->realm.value == NULL || msgbd->realm.length == 0) {
 		SIPE_DEBUG_INFO_NOFORMAT("realm NULL, so returning NULL signature string");
 		return NULL;
 	}
 
-	response_str = msgbd->msg->response != 0 ? g_strdup_printf("<%d>", msgbd->msg->response) : empty_string;
-	if (version < 3) {
-		msg = g_strdup_printf(
-			"<%s><%s><%s><%s><%s><%s><%s><%s><%s><%s><%s>" // 1 - 11
-			"<%s>%s", // 12 - 13
-			msgbd->protocol, msgbd->rand, msgbd->num, msgbd->realm, msgbd->target_name, msgbd->call_id, msgbd->cseq,
-			msgbd->msg->method, msgbd->from_url, msgbd->from_tag, msgbd->to_tag,
-			msgbd->expires ? msgbd->expires : empty_string, response_str
-		);
-	} else {
-		msg = g_strdup_printf(
-			"<%s><%s><%s><%s><%s><%s><%s><%s><%s><%s><%s><%s><%s><%s>" // 1 - 14
-			"<%s>%s", // 15 - 16
-			msgbd->protocol, msgbd->rand, msgbd->num, msgbd->realm, msgbd->target_name, msgbd->call_id, msgbd->cseq,
-			msgbd->msg->method, msgbd->from_url, msgbd->from_tag, msgbd->to_url, msgbd->to_tag,
-			msgbd->p_assertet_identity_sip_uri, msgbd->p_assertet_identity_tel_uri,
-			msgbd->expires ? msgbd->expires : empty_string, response_str
-		);
+	if (msgbd->msg->response != 0)
+		response_length = g_snprintf(response_str, sizeof(response_str),
+					     "<%d>", msgbd->msg->response);
+
+	sipmsg_breakdown_part_set(&method, msgbd->msg->method);
+
+	parts[count++] = &msgbd->protocol;
+	parts[count++] = &msgbd->rand;
+	parts[count++] = &msgbd->num;
+	parts[count++] = &msgbd->realm;
+	parts[count++] = &msgbd->target_name;
+	parts[count++] = &msgbd->call_id;
+	parts[count++] = &msgbd->cseq;
+	parts[count++] = &method;
+	parts[count++] = &msgbd->from_url;
+	parts[count++] = &msgbd->from_tag;
+	if (version >= 3)
+		parts[count++] = &msgbd->to_url;
+	parts[count++] = &msgbd->to_tag;
+	if (version >= 3) {
+		parts[count++] = &msgbd->p_assertet_identity_sip_uri;
+		parts[count++] = &msgbd->p_assertet_identity_tel_uri;
 	}
+	parts[count++] = &msgbd->expires;
+
+	/* "<part1>...<partN>" + response code: only one allocation */
+	length = response_length;
+	for (i = 0; i < count; i++)
+		length += parts[i]->length + 2;
 
-	if (response_str != empty_string) {
-		g_free(response_str);
+	p = msg = g_malloc(length + 1);
+	for (i = 0; i < count; i++) {
+		*p++ = '<';
+		if (parts[i]->length) {
+			memcpy(p, parts[i]->value, parts[i]->length);
+			p += parts[i]->length;
+		}
+		*p++ = '>';
 	}
+	memcpy(p, response_str, response_length);
+	p[response_length] = '\0';
 
 	return msg;
 }
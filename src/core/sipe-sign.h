@@ -20,32 +20,52 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
  */
 
+/**
+ * Part of a message used as signature input
+ *
+ * The value is borrowed from the message headers or the caller and is
+ * NOT NUL-terminated. A part with NULL value is treated as empty string.
+ */
+struct sipmsg_breakdown_part {
+	const gchar *value;
+	gsize length;
+};
+
 struct sipmsg_breakdown {
 	struct sipmsg * msg;
-	gchar * protocol;
-	gchar * rand;
-	gchar * num;
-	gchar * realm;
-	gchar * target_name;
-	const gchar * call_id;
-	gchar * cseq;
+	struct sipmsg_breakdown_part protocol;
+	struct sipmsg_breakdown_part rand;
+	struct sipmsg_breakdown_part num;
+	struct sipmsg_breakdown_part realm;
+	struct sipmsg_breakdown_part target_name;
+	struct sipmsg_breakdown_part call_id;
+	struct sipmsg_breakdown_part cseq;
 	//method
-	gchar * from_url;
-	gchar * from_tag;
+	struct sipmsg_breakdown_part from_url;
+	struct sipmsg_breakdown_part from_tag;
 	/** @since 3 */
-	gchar * to_url;
-	gchar * to_tag;
+	struct sipmsg_breakdown_part to_url;
+	struct sipmsg_breakdown_part to_tag;
 	/** @since 3 */
-	gchar * p_assertet_identity_sip_uri;
+	struct sipmsg_breakdown_part p_assertet_identity_sip_uri;
 	/** @since 3 */
-	gchar * p_assertet_identity_tel_uri;
-	const gchar * expires;
+	struct sipmsg_breakdown_part p_assertet_identity_tel_uri;
+	struct sipmsg_breakdown_part expires;
 	//response code
 };
 
-void sipmsg_breakdown_parse(struct sipmsg_breakdown * msg, gchar * realm, gchar * target,
+/**
+ * Extract signature input parts from msg->msg
+ *
+ * All parts point into the message headers or the parameters, i.e. the
+ * breakdown is only valid as long as those are. Nothing needs to be freed.
+ */
+void sipmsg_breakdown_parse(struct sipmsg_breakdown * msg,
+			    const gchar *realm,
+			    const gchar *target,
 			    const gchar *protocol);
+void sipmsg_breakdown_part_set(struct sipmsg_breakdown_part *part,
+			       const gchar *value);
 gchar*
 sipmsg_breakdown_get_string(int version,
 			    struct sipmsg_breakdown * msgbd);
-void sipmsg_breakdown_free(struct sipmsg_breakdown * msg);
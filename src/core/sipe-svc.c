@@ -39,6 +39,7 @@
 #include "sipe-core.h"
 #include "sipe-core-private.h"
 #include "sipe-http.h"
+#include "sipe-schedule.h"
 #include "sipe-svc.h"
 #include "sipe-tls.h"
 #include "sipe-utils.h"
@@ -57,7 +58,9 @@ struct svc_request {
 	sipe_svc_callback *cb;
 	gpointer *cb_data;
 	struct sipe_http_request *request;
+	gchar *timeout;      /* cached response is pending */
 	gchar *uri;
+	gboolean cacheable;  /* GET request */
 };
 
 struct sipe_svc {
@@ -74,6 +77,10 @@ static void sipe_svc_request_free(struct sipe_core_private *sipe_private,
 {
 	if (data->request)
 		sipe_http_request_cancel(data->request);
+	if (data->timeout) {
+		sipe_schedule_cancel(sipe_private, data->timeout);
+		g_free(data->timeout);
+	}
 	if (data->cb)
 		/* Callback: aborted */
 		(*data->cb)(sipe_private, NULL, NULL, NULL, data->cb_data);
@@ -126,19 +133,13 @@ void sipe_svc_session_close(struct sipe_svc_session *session)
 	}
 }
 
-static void sipe_svc_https_response(struct sipe_core_private *sipe_private,
-				    guint status,
-				    SIPE_UNUSED_PARAMETER GSList *headers,
-				    const gchar *body,
-				    gpointer callback_data)
+static void sipe_svc_response(struct sipe_core_private *sipe_private,
+			      struct svc_request *data,
+			      const gchar *body)
 {
-	struct svc_request *data = callback_data;
 	struct sipe_svc *svc = sipe_private->svc;
 
-	SIPE_DEBUG_INFO("sipe_svc_https_response: code %d", status);
-	data->request = NULL;
-
-	if ((status == SIPE_HTTP_STATUS_OK) && body) {
+	if (body) {
 		sipe_xml *xml = sipe_xml_parse(body, strlen(body));
 		/* Internal callback: success */
 		(*data->internal_cb)(sipe_private, data, body, xml);
@@ -156,6 +157,56 @@ static void sipe_svc_https_response(struct sipe_core_private *sipe_private,
 	sipe_svc_request_free(sipe_private, data);
 }
 
+static void sipe_svc_https_response(struct sipe_core_private *sipe_private,
+				    guint status,
+				    GSList *headers,
+				    const gchar *body,
+				    gpointer callback_data)
+{
+	struct svc_request *data = callback_data;
+	gchar *cached = NULL;
+
+	SIPE_DEBUG_INFO("sipe_svc_https_response: code %d", status);
+	data->request = NULL;
+
+	if (data->cacheable) {
+		sipe_http_cache_update(sipe_private,
+				       data->uri,
+				       status,
+				       headers,
+				       body);
+
+		/* cached response has been revalidated */
+		if (status == SIPE_HTTP_STATUS_NOT_MODIFIED) {
+			cached = sipe_http_cache_body(sipe_private, data->uri);
+			status = SIPE_HTTP_STATUS_OK;
+			body   = cached;
+		}
+	}
+
+	sipe_svc_response(sipe_private,
+			  data,
+			  (status == SIPE_HTTP_STATUS_OK) ? body : NULL);
+	g_free(cached);
+}
+
+static void sipe_svc_cached_response(struct sipe_core_private *sipe_private,
+				     gpointer callback_data)
+{
+	struct svc_request *data = callback_data;
+	gchar *body = sipe_http_cache_body(sipe_private, data->uri);
+
+	SIPE_DEBUG_INFO("sipe_svc_cached_response: using cached response for '%s'",
+			data->uri);
+
+	/* schedule has expired */
+	g_free(data->timeout);
+	data->timeout = NULL;
+
+	sipe_svc_response(sipe_private, data, body);
+	g_free(body);
+}
+
 /**
  * Send GET request when @c body is NULL, otherwise send POST request
  *
@@ -175,6 +226,7 @@ static gboolean sipe_svc_https_request(struct sipe_core_private *sipe_private,
 {
 	struct svc_request *data = g_new0(struct svc_request, 1);
 	struct sipe_http_request *request = NULL;
+	gboolean cached = FALSE;
 	struct sipe_svc *svc;
 
 	sipe_svc_init(sipe_private);
@@ -202,21 +254,48 @@ static gboolean sipe_svc_https_request(struct sipe_core_private *sipe_private,
 							 data);
 			g_free(headers);
 
+		/* GET responses, e.g. metadata, are cached */
+		} else if (sipe_http_cache_fresh(sipe_private, uri)) {
+			cached = TRUE;
+
 		} else {
+			gchar *headers = sipe_http_cache_headers(sipe_private,
+								 uri);
+
 			request = sipe_http_request_get(sipe_private,
 							uri,
-							NULL,
+							headers,
 							sipe_svc_https_response,
 							data);
+			g_free(headers);
 		}
 	}
 
-	if (request) {
+	if (cached) {
+		data->internal_cb = internal_callback;
+		data->cb          = callback;
+		data->cb_data     = callback_data;
+		data->uri         = g_strdup(uri);
+		data->timeout     = g_strdup_printf("<+svc-cache><%p>", data);
+
+		svc->pending_requests = g_slist_prepend(svc->pending_requests,
+							data);
+
+		/* callback must not be called before we return */
+		sipe_schedule_mseconds(sipe_private,
+				       data->timeout,
+				       data,
+				       0,
+				       sipe_svc_cached_response,
+				       NULL);
+
+	} else if (request) {
 		data->internal_cb = internal_callback;
 		data->cb          = callback;
 		data->cb_data     = callback_data;
 		data->request     = request;
 		data->uri         = g_strdup(uri);
+		data->cacheable   = (body == NULL);
 
 		svc->pending_requests = g_slist_prepend(svc->pending_requests,
 							data);
@@ -229,7 +308,7 @@ static gboolean sipe_svc_https_request(struct sipe_core_private *sipe_private,
 		g_free(data);
 	}
 
-	return(request != NULL);
+	return(cached || (request != NULL));
 }
 
 static gboolean sipe_svc_wsdl_request(struct sipe_core_private *sipe_private,
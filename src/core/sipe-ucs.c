@@ -49,6 +49,17 @@
 #include "sipe-ucs.h"
 #include "sipe-utils.h"
 #include "sipe-xml.h"
+#include "sipe-xml-async.h"
+
+/*
+ * Requests are executed one at a time, in transaction order, because a
+ * response callback can add follow-up requests to its transaction.
+ *
+ * Running independent transactions in parallel wouldn't help: all of
+ * them are sent to the same EWS URL and sipe-http serializes requests on
+ * a connection, i.e. it would only reorder the HTTP queue. The UCS
+ * operations only accept a single item, so they can't be batched either.
+ */
 
 struct sipe_ucs_transaction {
 	GSList *pending_requests;
@@ -84,6 +95,9 @@ static void sipe_ucs_request_free(struct sipe_core_private *sipe_private,
 	struct sipe_ucs *ucs = sipe_private->ucs;
 	struct sipe_ucs_transaction *trans = data->transaction;
 
+	/* response might still be parsed */
+	sipe_xml_parse_async_cancel(sipe_private, data);
+
 	/* remove request from transaction */
 	trans->pending_requests = g_slist_remove(trans->pending_requests,
 						 data);
@@ -107,6 +121,38 @@ static void sipe_ucs_request_free(struct sipe_core_private *sipe_private,
 }
 
 static void sipe_ucs_next_request(struct sipe_core_private *sipe_private);
+static void sipe_ucs_request_done(struct sipe_core_private *sipe_private,
+				  struct ucs_request *data)
+{
+	/* already been called */
+	data->cb = NULL;
+
+	sipe_ucs_request_free(sipe_private, data);
+	sipe_ucs_next_request(sipe_private);
+}
+
+static void sipe_ucs_response_parsed(struct sipe_core_private *sipe_private,
+				     const sipe_xml *xml,
+				     gpointer callback_data)
+{
+	struct ucs_request *data = callback_data;
+
+	/* Callback: success */
+	(*data->cb)(sipe_private,
+		    data->transaction,
+		    sipe_xml_child(xml, "Body"),
+		    data->cb_data);
+
+	sipe_ucs_request_done(sipe_private, data);
+}
+
+static void sipe_ucs_response_aborted(struct sipe_core_private *sipe_private,
+				      gpointer callback_data)
+{
+	/* Callback: aborted, but don't start next request */
+	sipe_ucs_request_free(sipe_private, callback_data);
+}
+
 static void sipe_ucs_http_response(struct sipe_core_private *sipe_private,
 				   guint status,
 				   SIPE_UNUSED_PARAMETER GSList *headers,
@@ -119,24 +165,21 @@ static void sipe_ucs_http_response(struct sipe_core_private *sipe_private,
 	data->request = NULL;
 
 	if ((status == SIPE_HTTP_STATUS_OK) && body) {
-		sipe_xml *xml = sipe_xml_parse(body, strlen(body));
-		const sipe_xml *soap_body = sipe_xml_child(xml, "Body");
-		/* Callback: success */
-		(*data->cb)(sipe_private,
-			    data->transaction,
-			    soap_body,
-			    data->cb_data);
-		sipe_xml_free(xml);
+		/*
+		 * e.g. GetImItemList can be huge. Request stays active
+		 * until the response has been processed.
+		 */
+		sipe_xml_parse_async(sipe_private,
+				     body,
+				     strlen(body),
+				     sipe_ucs_response_parsed,
+				     sipe_ucs_response_aborted,
+				     data);
 	} else {
 		/* Callback: failed */
 		(*data->cb)(sipe_private, NULL, NULL, data->cb_data);
+		sipe_ucs_request_done(sipe_private, data);
 	}
-
-	/* already been called */
-	data->cb = NULL;
-
-	sipe_ucs_request_free(sipe_private, data);
-	sipe_ucs_next_request(sipe_private);
 }
 
 static void sipe_ucs_next_request(struct sipe_core_private *sipe_private)
@@ -187,8 +230,14 @@ static void sipe_ucs_next_request(struct sipe_core_private *sipe_private)
 
 			break;
 		} else {
+			gboolean last = (trans->pending_requests->next == NULL);
+
 			SIPE_DEBUG_ERROR_NOFORMAT("sipe_ucs_next_request: failed to create HTTP connection");
 			sipe_ucs_request_free(sipe_private, data);
+
+			/* empty transaction has been deleted */
+			if (last)
+				break;
 		}
 	}
 }
@@ -28,6 +28,7 @@
 
 #include <glib.h>
 
+#include "sipe-common.h"
 #include "sip-transport.h"
 #include "sipe-backend.h"
 #include "sipe-core.h"    /* to ensure same API for backends */
@@ -327,6 +328,19 @@ sipe_strcase_equal(const gchar *left, const gchar *right)
 	        (left != NULL && right != NULL && g_ascii_strcasecmp(left, right) == 0));
 }
 
+guint
+sipe_strcase_hash(gconstpointer key)
+{
+	/* same algorithm as g_str_hash(), applied to the lower case string */
+	const gchar *p;
+	guint32 h = 5381;
+
+	for (p = key; *p; p++)
+		h = (h << 5) + h + g_ascii_tolower(*p);
+
+	return(h);
+}
+
 gint sipe_strcompare(gconstpointer a, gconstpointer b)
 {
 #if GLIB_CHECK_VERSION(2,16,0)
@@ -546,6 +560,61 @@ void sipe_utils_shrink_buffer(struct sipe_transport_connection *conn,
 	conn->buffer_used -= unread - conn->buffer;
 	/* string terminator is not included in buffer_used */
 	memmove(conn->buffer, unread, conn->buffer_used + 1);
+	/* message has been processed */
+	conn->buffer_hint = 0;
+}
+
+#define TRANSPORT_BUFFER_INITIAL  4096
+#define TRANSPORT_BUFFER_MIN_READ 4096
+/* larger buffers are released again after the message has been processed */
+#define TRANSPORT_BUFFER_KEEP     (64 * 1024)
+/* don't trust the peer for anything larger */
+#define TRANSPORT_BUFFER_HINT_MAX (4 * 1024 * 1024)
+
+void sipe_utils_buffer_hint(struct sipe_transport_connection *conn,
+			    const gchar *body,
+			    gssize length)
+{
+	gsize offset = body - conn->buffer;
+
+	if ((length < 0) ||
+	    (offset > conn->buffer_used) ||
+	    ((gsize) length > TRANSPORT_BUFFER_HINT_MAX - offset)) {
+		conn->buffer_hint = 0;
+		return;
+	}
+
+	conn->buffer_hint = offset + length;
+}
+
+gsize sipe_core_transport_buffer_reserve(struct sipe_transport_connection *conn)
+{
+	/* plus 1 for the string terminator */
+	gsize needed = conn->buffer_used + TRANSPORT_BUFFER_MIN_READ + 1;
+	gsize length = conn->buffer_length;
+
+	if ((conn->buffer_hint >= needed) &&
+	    (conn->buffer_hint <= TRANSPORT_BUFFER_HINT_MAX)) {
+		/* size of incomplete message is known */
+		length = conn->buffer_hint + 1;
+	} else if ((length < needed) ||
+		   ((length > TRANSPORT_BUFFER_KEEP) &&
+		    (needed <= TRANSPORT_BUFFER_KEEP))) {
+		length = TRANSPORT_BUFFER_INITIAL;
+		while (length < needed)
+			length *= 2;
+	}
+
+	if ((length > conn->buffer_length) ||
+	    ((length < conn->buffer_length) &&
+	     (conn->buffer_length > TRANSPORT_BUFFER_KEEP))) {
+		conn->buffer        = g_realloc(conn->buffer, length);
+		conn->buffer_length = length;
+		SIPE_DEBUG_INFO("sipe_core_transport_buffer_reserve: new buffer length %" G_GSIZE_FORMAT,
+				length);
+	}
+
+	return(conn->buffer_length - conn->buffer_used - 1);
 }
 
 gboolean sipe_utils_ip_is_private(const char *ip)
@@ -645,6 +714,98 @@ sipe_utils_get_user_runtime_dir(void)
 	return result;
 }
 
+/* string -> struct intern_entry */
+static GHashTable *intern_pool = NULL;
+
+struct intern_entry {
+	gchar *string;
+	guint refs;
+};
+
+static void intern_entry_free(gpointer data)
+{
+	struct intern_entry *entry = data;
+	g_free(entry->string);
+	g_free(entry);
+}
+
+const gchar *sipe_utils_intern(const gchar *string)
+{
+	struct intern_entry *entry;
+
+	if (!string)
+		return(NULL);
+
+	if (!intern_pool)
+		intern_pool = g_hash_table_new_full(g_str_hash,
+						    g_str_equal,
+						    NULL,
+						    intern_entry_free);
+
+	entry = g_hash_table_lookup(intern_pool, string);
+	if (!entry) {
+		entry = g_new0(struct intern_entry, 1);
+		entry->string = g_strdup(string);
+		g_hash_table_insert(intern_pool, entry->string, entry);
+	}
+	entry->refs++;
+
+	return(entry->string);
+}
+
+void sipe_utils_intern_release(const gchar *string)
+{
+	struct intern_entry *entry;
+
+	if (!string || !intern_pool)
+		return;
+
+	entry = g_hash_table_lookup(intern_pool, string);
+	if (!entry) {
+		SIPE_DEBUG_ERROR("sipe_utils_intern_release: '%s' is not in the pool",
+				 string);
+		return;
+	}
+
+	if (--entry->refs == 0) {
+		g_hash_table_remove(intern_pool, string);
+
+		/* last string released */
+		if (g_hash_table_size(intern_pool) == 0) {
+			g_hash_table_destroy(intern_pool);
+			intern_pool = NULL;
+		}
+	}
+}
+
+/* per string: entry + GHashTable slot (key, value, hash) */
+#define INTERN_ENTRY_OVERHEAD (sizeof(struct intern_entry) + \
+			       2 * sizeof(gpointer) + sizeof(guint))
+
+static void intern_entry_stats(SIPE_UNUSED_PARAMETER gpointer key,
+			       gpointer value,
+			       gpointer user_data)
+{
+	struct intern_entry *entry = value;
+	struct sipe_utils_intern_stats *stats = user_data;
+	gsize length = strlen(entry->string) + 1;
+
+	stats->strings++;
+	stats->refs     += entry->refs;
+	stats->bytes    += length + INTERN_ENTRY_OVERHEAD;
+	stats->unpooled += entry->refs * length;
+}
+
+void sipe_utils_intern_stats(struct sipe_utils_intern_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	if (intern_pool)
+		g_hash_table_foreach(intern_pool,
+				     intern_entry_stats,
+				     stats);
+}
+
 /*
   Local Variables:
   mode: c
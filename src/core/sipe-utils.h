@@ -279,6 +279,18 @@ gboolean sipe_strequal(const gchar *left, const gchar *right);
  */
 gboolean sipe_strcase_equal(const gchar *left, const gchar *right);
 
+/**
+ * Case insensitive string hash function
+ *
+ * Use together with @c sipe_strcase_equal() for hash tables that are
+ * indexed by URIs, Call-IDs etc.
+ *
+ * @param key A string
+ *
+ * @return hash value
+ */
+guint sipe_strcase_hash(gconstpointer key);
+
 /**
  * Compares two strings
  *
@@ -438,6 +450,23 @@ gchar *sipe_utils_str_replace(const gchar *string,
  */
 void sipe_utils_shrink_buffer(struct sipe_transport_connection *conn,
 			      const gchar *unread);
+
+/**
+ * Tell the backend how large the incomplete message in the transport
+ * buffer will be, so that the buffer can be grown in one step.
+ *
+ * The length comes from the peer, e.g. Content-Length. Negative or
+ * unreasonably large values are ignored, i.e. the buffer grows as the
+ * data arrives.
+ *
+ * @param conn   the transport connection
+ * @param body   pointer to the start of the body in the buffer
+ * @param length expected length of the body
+ */
+void sipe_utils_buffer_hint(struct sipe_transport_connection *conn,
+			    const gchar *body,
+			    gssize length);
+
 /**
  * Checks whether given IP address belongs to private block as defined in RFC1918
  *
@@ -489,3 +518,39 @@ void sipe_utils_slist_free_full(GSList *list,
 				GDestroyNotify free);
 
 gchar *sipe_utils_get_user_runtime_dir(void);
+
+/**
+ * Get shared copy of a string from the interning pool
+ *
+ * Use for values that are repeated many times over the contact list,
+ * e.g. company names or activity descriptions. Each call adds a
+ * reference to the pooled string.
+ *
+ * @param string a string (may be @c NULL)
+ *
+ * @return pooled copy of @c string or @c NULL. Must be released with
+ *         @c sipe_utils_intern_release(), never g_free()'d.
+ */
+const gchar *sipe_utils_intern(const gchar *string);
+
+/**
+ * Drop reference to a pooled string
+ *
+ * @param string pooled string returned by @c sipe_utils_intern() (may be @c NULL)
+ */
+void sipe_utils_intern_release(const gchar *string);
+
+/** Memory statistics of the interning pool */
+struct sipe_utils_intern_stats {
+	guint strings;  /* pooled strings */
+	guint refs;     /* references to pooled strings */
+	gsize bytes;    /* pooled string data including pool overhead */
+	gsize unpooled; /* string data if every reference was a g_strdup() */
+};
+
+/**
+ * Collect memory statistics of the interning pool
+ *
+ * @param stats (out) filled with current statistics
+ */
+void sipe_utils_intern_stats(struct sipe_utils_intern_stats *stats);
@@ -26,6 +26,15 @@
  *   - [MS-OCAUTHWS]: http://msdn.microsoft.com/en-us/library/ff595592.aspx
  *   - MS Tech-Ed Europe 2010 "UNC310: Microsoft Lync 2010 Technology Explained"
  *     http://ecn.channel9.msdn.com/o9/te/Europe/2010/pptx/unc310.pptx
+ *
+ *
+ * Persistent cache entries (section "webticket"):
+ *
+ *   key "<services>"  value "<Port Name> <Base URI>[\n...]"
+ *
+ * Tokens themselves are NOT persisted. The cache file is not protected and
+ * there is no backend keyring to store an encryption key in. Deriving that
+ * key from the account password would allow offline password guessing.
  */
 
 #include <string.h>
@@ -35,15 +44,25 @@
 
 #include "sipe-common.h"
 #include "sipe-backend.h"
+#include "sipe-cache.h"
 #include "sipe-core.h"
 #include "sipe-core-private.h"
 #include "sipe-digest.h"
+#include "sipe-schedule.h"
 #include "sipe-svc.h"
 #include "sipe-tls.h"
 #include "sipe-webticket.h"
 #include "sipe-utils.h"
 #include "sipe-xml.h"
 
+#define SIPE_WEBTICKET_CACHE_SECTION     "webticket"
+#define SIPE_WEBTICKET_CACHE_SERVICES    "<services>"
+#define SIPE_WEBTICKET_SERVICES_LIFETIME (30 * 24 * 60 * 60) /* seconds */
+
+#define SIPE_WEBTICKET_REFRESH_ACTION    "<+webticket-refresh>"
+/* renew tokens this long before they expire */
+#define SIPE_WEBTICKET_REFRESH_MARGIN    (5 * 60) /* seconds */
+
 struct webticket_queued_data {
 	sipe_webticket_callback *callback;
 	gpointer callback_data;
@@ -51,7 +70,7 @@ struct webticket_queued_data {
 
 struct webticket_callback_data {
 	gchar *service_uri;
-	const gchar *service_port;
+	gchar *service_port;
 	gchar *service_auth_uri;
 
 	gchar *webticket_negotiate_uri;
@@ -78,8 +97,10 @@ struct webticket_callback_data {
 
 struct webticket_token {
 	gchar *auth_uri;
+	gchar *port_name;  /* NULL if token can't be refreshed */
 	gchar *token;
 	time_t expires;
+	time_t refresh;    /* 0 if no refresh is scheduled */
 };
 
 struct sipe_webticket {
@@ -103,6 +124,8 @@ void sipe_webticket_free(struct sipe_core_private *sipe_private)
 	/* Web Ticket stack is shutting down: reject all new requests */
 	webticket->shutting_down = TRUE;
 
+	sipe_schedule_cancel(sipe_private, SIPE_WEBTICKET_REFRESH_ACTION);
+
 	g_free(webticket->webticket_adfs_uri);
 	g_free(webticket->adfs_token);
 	if (webticket->pending)
@@ -117,10 +140,45 @@ static void free_token(gpointer data)
 {
 	struct webticket_token *wt = data;
 	g_free(wt->auth_uri);
+	g_free(wt->port_name);
 	g_free(wt->token);
 	g_free(wt);
 }
 
+static void persist_service(struct sipe_core_private *sipe_private,
+			    const gchar *service_uri,
+			    const gchar *port_name)
+{
+	const gchar *services = sipe_cache_get(sipe_private,
+					       SIPE_WEBTICKET_CACHE_SECTION,
+					       SIPE_WEBTICKET_CACHE_SERVICES);
+	gchar *entry = g_strdup_printf("%s %s", port_name, service_uri);
+	gboolean known = FALSE;
+
+	if (services) {
+		gchar **lines = g_strsplit(services, "\n", 0);
+		gchar **line;
+
+		for (line = lines; *line && !known; line++)
+			known = sipe_strequal(*line, entry);
+		g_strfreev(lines);
+	}
+
+	if (!known) {
+		gchar *value = services ?
+			g_strdup_printf("%s\n%s", services, entry) :
+			g_strdup(entry);
+		sipe_cache_set(sipe_private,
+			       SIPE_WEBTICKET_CACHE_SECTION,
+			       SIPE_WEBTICKET_CACHE_SERVICES,
+			       value,
+			       SIPE_WEBTICKET_SERVICES_LIFETIME);
+		g_free(value);
+	}
+
+	g_free(entry);
+}
+
 static void sipe_webticket_init(struct sipe_core_private *sipe_private)
 {
 	struct sipe_webticket *webticket;
@@ -138,20 +196,84 @@ static void sipe_webticket_init(struct sipe_core_private *sipe_private)
 					      g_str_equal);
 }
 
+struct refresh_data {
+	time_t now;
+	time_t next;
+	GSList *due;
+};
+
+static void refresh_check(gpointer key,
+			  gpointer value,
+			  gpointer user_data)
+{
+	struct webticket_token *wt = value;
+	struct refresh_data *rd    = user_data;
+
+	if (wt->refresh) {
+		/* collect due tokens only when requested */
+		if (rd->now && (wt->refresh <= rd->now)) {
+			/* only try once per token */
+			wt->refresh = 0;
+			rd->due = g_slist_prepend(rd->due, key);
+		} else if (!rd->next || (wt->refresh < rd->next)) {
+			rd->next = wt->refresh;
+		}
+	}
+}
+
+static void refresh_tokens(struct sipe_core_private *sipe_private,
+			   gpointer unused);
+static void refresh_schedule(struct sipe_core_private *sipe_private)
+{
+	struct refresh_data rd;
+	time_t now = time(NULL);
+
+	rd.now  = 0;
+	rd.next = 0;
+	rd.due  = NULL;
+	g_hash_table_foreach(sipe_private->webticket->cache,
+			     refresh_check,
+			     &rd);
+
+	if (rd.next)
+		sipe_schedule_seconds(sipe_private,
+				      SIPE_WEBTICKET_REFRESH_ACTION,
+				      NULL,
+				      (rd.next > now) ? rd.next - now : 0,
+				      refresh_tokens,
+				      NULL);
+	else
+		sipe_schedule_cancel(sipe_private,
+				     SIPE_WEBTICKET_REFRESH_ACTION);
+}
+
 /* takes ownership of "token" */
 static void cache_token(struct sipe_core_private *sipe_private,
 			const gchar *service_uri,
 			const gchar *auth_uri,
+			const gchar *port_name,
 			gchar *token,
 			time_t expires)
 {
 	struct webticket_token *wt = g_new0(struct webticket_token, 1);
-	wt->auth_uri = g_strdup(auth_uri);
-	wt->token    = token;
-	wt->expires  = expires;
+	time_t now = time(NULL);
+
+	wt->auth_uri  = g_strdup(auth_uri);
+	wt->port_name = g_strdup(port_name);
+	wt->token     = token;
+	wt->expires   = expires;
+
+	/*
+	 * Renew token in the background before it expires. Skip tokens
+	 * with a very short lifetime, otherwise we would keep on refreshing.
+	 */
+	if (port_name && (expires - SIPE_WEBTICKET_REFRESH_MARGIN > now + SIPE_WEBTICKET_REFRESH_MARGIN))
+		wt->refresh = expires - SIPE_WEBTICKET_REFRESH_MARGIN;
+
 	g_hash_table_insert(sipe_private->webticket->cache,
 			    g_strdup(service_uri),
 			    wt);
+	refresh_schedule(sipe_private);
 }
 
 static const struct webticket_token *cache_hit(struct sipe_core_private *sipe_private,
@@ -179,6 +301,7 @@ static void callback_data_free(struct webticket_callback_data *wcd)
 		g_free(wcd->webticket_negotiate_uri);
 		g_free(wcd->webticket_fedbearer_uri);
 		g_free(wcd->service_auth_uri);
+		g_free(wcd->service_port);
 		g_free(wcd->service_uri);
 		g_free(wcd);
 	}
@@ -481,10 +604,15 @@ static void webticket_token(struct sipe_core_private *sipe_private,
 									&expires);
 
 			if (wsse_security) {
+				if (wcd->service_port)
+					persist_service(sipe_private,
+							wcd->service_uri,
+							wcd->service_port);
 				/* cache takes ownership of wsse_security */
 				cache_token(sipe_private,
 					    wcd->service_uri,
 					    wcd->service_auth_uri,
+					    wcd->service_port,
 					    wsse_security,
 					    expires);
 				callback_execute(sipe_private,
@@ -891,6 +1019,7 @@ static gboolean webticket_request(struct sipe_core_private *sipe_private,
 				  const gchar *base_uri,
 				  const gchar *auth_uri,
 				  const gchar *port_name,
+				  gboolean refresh,
 				  sipe_webticket_callback *callback,
 				  gpointer callback_data)
 {
@@ -908,7 +1037,7 @@ static gboolean webticket_request(struct sipe_core_private *sipe_private,
 				 port_name);
 
 	} else {
-		const struct webticket_token *wt = cache_hit(sipe_private, base_uri);
+		const struct webticket_token *wt = refresh ? NULL : cache_hit(sipe_private, base_uri);
 
 		/* cache hit for this URI? */
 		if (wt) {
@@ -943,7 +1072,7 @@ static gboolean webticket_request(struct sipe_core_private *sipe_private,
 
 				if (ret) {
 					wcd->service_uri      = g_strdup(base_uri);
-					wcd->service_port     = port_name;
+					wcd->service_port     = g_strdup(port_name);
 					wcd->service_auth_uri = g_strdup(auth_uri);
 					wcd->callback         = callback;
 					wcd->callback_data    = callback_data;
@@ -962,6 +1091,101 @@ static gboolean webticket_request(struct sipe_core_private *sipe_private,
 	return(ret);
 }
 
+static void background_webticket(SIPE_UNUSED_PARAMETER struct sipe_core_private *sipe_private,
+				 const gchar *base_uri,
+				 const gchar *auth_uri,
+				 const gchar *wsse_security,
+				 SIPE_UNUSED_PARAMETER const gchar *failure_msg,
+				 gpointer callback_data)
+{
+	SIPE_DEBUG_INFO("background_webticket: %s for URI %s",
+			wsse_security ? "got token" :
+			auth_uri ? "failed" : "aborted",
+			base_uri);
+	sipe_svc_session_close(callback_data);
+}
+
+static void background_request(struct sipe_core_private *sipe_private,
+			       const gchar *base_uri,
+			       const gchar *port_name,
+			       gboolean refresh)
+{
+	struct sipe_svc_session *session = sipe_svc_session_start();
+
+	SIPE_DEBUG_INFO("background_request: %s token for URI %s",
+			refresh ? "renewing" : "requesting",
+			base_uri);
+
+	if (!webticket_request(sipe_private,
+			       session,
+			       base_uri,
+			       NULL,
+			       port_name,
+			       refresh,
+			       background_webticket,
+			       session))
+		sipe_svc_session_close(session);
+}
+
+static void refresh_tokens(struct sipe_core_private *sipe_private,
+			   SIPE_UNUSED_PARAMETER gpointer unused)
+{
+	struct refresh_data rd;
+	GSList *entry;
+
+	rd.now  = time(NULL);
+	rd.next = 0;
+	rd.due  = NULL;
+	g_hash_table_foreach(sipe_private->webticket->cache,
+			     refresh_check,
+			     &rd);
+
+	for (entry = rd.due; entry; entry = entry->next) {
+		const struct webticket_token *wt = g_hash_table_lookup(sipe_private->webticket->cache,
+								       entry->data);
+		/* copy: the cache entry will be replaced */
+		gchar *base_uri  = g_strdup(entry->data);
+		gchar *port_name = g_strdup(wt->port_name);
+
+		background_request(sipe_private, base_uri, port_name, TRUE);
+
+		g_free(port_name);
+		g_free(base_uri);
+	}
+	g_slist_free(rd.due);
+
+	refresh_schedule(sipe_private);
+}
+
+void sipe_webticket_prewarm(struct sipe_core_private *sipe_private)
+{
+	const gchar *services;
+	gchar **lines;
+	gchar **line;
+
+	sipe_webticket_init(sipe_private);
+	if (sipe_private->webticket->shutting_down)
+		return;
+
+	services = sipe_cache_get(sipe_private,
+				  SIPE_WEBTICKET_CACHE_SECTION,
+				  SIPE_WEBTICKET_CACHE_SERVICES);
+	if (!services)
+		return;
+
+	/* copy: requests can modify the cache entry */
+	lines = g_strsplit(services, "\n", 0);
+	for (line = lines; *line; line++) {
+		gchar *base_uri = strchr(*line, ' ');
+
+		if (base_uri) {
+			*base_uri++ = '\0';
+			background_request(sipe_private, base_uri, *line, FALSE);
+		}
+	}
+	g_strfreev(lines);
+}
+
 gboolean sipe_webticket_request_with_port(struct sipe_core_private *sipe_private,
 					  struct sipe_svc_session *session,
 					  const gchar *base_uri,
@@ -974,6 +1198,7 @@ gboolean sipe_webticket_request_with_port(struct sipe_core_private *sipe_private
 				 base_uri,
 				 NULL, /* Auth URI is determined via port_name */
 				 port_name,
+				 FALSE,
 				 callback,
 				 callback_data));
 }
@@ -990,6 +1215,7 @@ gboolean sipe_webticket_request_with_auth(struct sipe_core_private *sipe_private
 				 base_uri,
 				 auth_uri,
 				 NULL,
+				 FALSE,
 				 callback,
 				 callback_data));
 }
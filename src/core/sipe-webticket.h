@@ -88,6 +88,16 @@ gboolean sipe_webticket_request_with_auth(struct sipe_core_private *sipe_private
 					  sipe_webticket_callback *callback,
 					  gpointer callback_data);
 
+/**
+ * Request Web Tickets for all services used in previous sessions
+ *
+ * The list of services is taken from the persistent cache. Requests run
+ * in the background, i.e. there is no callback.
+ *
+ * @param sipe_private SIPE core private data
+ */
+void sipe_webticket_prewarm(struct sipe_core_private *sipe_private);
+
 /**
  * Free webticket data
  *
@@ -0,0 +1,224 @@
+/**
+ * @file sipe-xml-async.c
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * The core doesn't know anything about the backend main loop, e.g. the
+ * Miranda backend doesn't use a GLib main loop at all. Each finished job
+ * therefore wakes up the main thread once through the backend.
+ *
+ * Each job is referenced by the main thread and the worker thread. The
+ * worker only touches the job and never the core data. Its reference is
+ * handed over to the wakeup.
+ */
+
+#include <glib.h>
+
+#include "sipe-common.h"
+#include "sipe-backend.h"
+#include "sipe-core.h"
+#include "sipe-core-private.h"
+#include "sipe-xml.h"
+#include "sipe-xml-async.h"
+
+/* smaller documents are parsed in the main thread */
+#define SIPE_XML_ASYNC_THRESHOLD   (64 * 1024) /* bytes */
+#define SIPE_XML_ASYNC_MAX_THREADS 2
+
+/* GThreadPool without g_thread_init() is only possible since 2.32 */
+#if GLIB_CHECK_VERSION(2,32,0)
+#define SIPE_XML_ASYNC_THREADS
+static GThreadPool *xml_async_pool = NULL;
+#endif
+
+struct sipe_xml_async_job {
+	struct sipe_core_public *sipe_public;
+	gchar *string;
+	gsize length;
+	sipe_xml *xml;
+	gchar *messages;
+	sipe_xml_async_cb *callback;
+	sipe_xml_async_aborted_cb *aborted;
+	gpointer data;
+	gboolean removed; /* main thread only */
+	gint done;        /* atomic */
+	gint refs;        /* atomic */
+};
+
+static void xml_async_job_unref(struct sipe_xml_async_job *job)
+{
+	if (g_atomic_int_dec_and_test(&job->refs)) {
+		sipe_xml_free(job->xml);
+		g_free(job->messages);
+		g_free(job->string);
+		g_free(job);
+	}
+}
+
+static void xml_async_job_parse(struct sipe_xml_async_job *job)
+{
+	job->xml = sipe_xml_parse_thread(job->string,
+					 job->length,
+					 &job->messages);
+	g_free(job->string);
+	job->string = NULL;
+	g_atomic_int_set(&job->done, 1);
+}
+
+#ifdef SIPE_XML_ASYNC_THREADS
+static void xml_async_worker(gpointer data,
+			     SIPE_UNUSED_PARAMETER gpointer user_data)
+{
+	struct sipe_xml_async_job *job = data;
+	xml_async_job_parse(job);
+	sipe_backend_wakeup(job);
+}
+#endif
+
+static void xml_async_deliver(struct sipe_core_private *sipe_private,
+			      struct sipe_xml_async_job *job)
+{
+	if (job->messages)
+		SIPE_DEBUG_ERROR("sipe_xml_parse_async: %s", job->messages);
+	(*job->callback)(sipe_private, job->xml, job->data);
+	xml_async_job_unref(job);
+}
+
+void sipe_core_wakeup(gpointer data)
+{
+	struct sipe_xml_async_job *job = data;
+
+	/* job is still pending, i.e. the account is still valid */
+	if (!job->removed) {
+		struct sipe_core_public *sipe_public = job->sipe_public;
+		struct sipe_core_private *sipe_private = SIPE_CORE_PRIVATE;
+
+		/* deliver in submission order */
+		while (sipe_private->xml_async_jobs) {
+			struct sipe_xml_async_job *head = sipe_private->xml_async_jobs->data;
+
+			if (!g_atomic_int_get(&head->done))
+				break;
+
+			/* callback might submit or cancel other jobs */
+			sipe_private->xml_async_jobs = g_slist_remove(sipe_private->xml_async_jobs,
+								      head);
+			head->removed = TRUE;
+			xml_async_deliver(sipe_private, head);
+		}
+	}
+
+	/* release reference held by wakeup */
+	xml_async_job_unref(job);
+}
+
+void sipe_xml_parse_async(struct sipe_core_private *sipe_private,
+			  const gchar *string,
+			  gsize length,
+			  sipe_xml_async_cb *callback,
+			  sipe_xml_async_aborted_cb *aborted,
+			  gpointer data)
+{
+	struct sipe_xml_async_job *job = g_new0(struct sipe_xml_async_job, 1);
+
+	job->sipe_public = SIPE_CORE_PUBLIC;
+	job->string      = g_strndup(string, length);
+	job->length      = length;
+	job->callback    = callback;
+	job->aborted     = aborted;
+	job->data        = data;
+	job->refs        = 2; /* list & wakeup */
+	sipe_private->xml_async_jobs = g_slist_append(sipe_private->xml_async_jobs,
+						      job);
+
+#ifdef SIPE_XML_ASYNC_THREADS
+	if (length >= SIPE_XML_ASYNC_THRESHOLD) {
+		if (!xml_async_pool) {
+			sipe_xml_thread_init();
+			xml_async_pool = g_thread_pool_new(xml_async_worker,
+							   NULL,
+							   SIPE_XML_ASYNC_MAX_THREADS,
+							   FALSE,
+							   NULL);
+		}
+
+		SIPE_DEBUG_INFO("sipe_xml_parse_async: %" G_GSIZE_FORMAT " bytes to worker thread",
+				length);
+		g_thread_pool_push(xml_async_pool, job, NULL);
+	} else
+#endif
+	{
+		/* result is delivered after we have returned */
+		xml_async_job_parse(job);
+		sipe_backend_wakeup(job);
+	}
+}
+
+void sipe_xml_parse_async_cancel(struct sipe_core_private *sipe_private,
+				 gpointer data)
+{
+	GSList *entry = sipe_private->xml_async_jobs;
+
+	while (entry) {
+		struct sipe_xml_async_job *job = entry->data;
+		entry = entry->next;
+
+		if (job->data == data) {
+			sipe_private->xml_async_jobs = g_slist_remove(sipe_private->xml_async_jobs,
+								      job);
+			job->removed = TRUE;
+			xml_async_job_unref(job);
+		}
+	}
+}
+
+void sipe_xml_parse_async_abort_all(struct sipe_core_private *sipe_private)
+{
+	while (sipe_private->xml_async_jobs) {
+		struct sipe_xml_async_job *job = sipe_private->xml_async_jobs->data;
+		sipe_private->xml_async_jobs = g_slist_remove(sipe_private->xml_async_jobs,
+							      job);
+		job->removed = TRUE;
+		if (job->aborted)
+			(*job->aborted)(sipe_private, job->data);
+		xml_async_job_unref(job);
+	}
+}
+
+void sipe_xml_async_shutdown(void)
+{
+#ifdef SIPE_XML_ASYNC_THREADS
+	if (xml_async_pool) {
+		/* wait for running jobs, they only hold their own data */
+		g_thread_pool_free(xml_async_pool, FALSE, TRUE);
+		xml_async_pool = NULL;
+	}
+#endif
+}
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
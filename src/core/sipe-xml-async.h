@@ -0,0 +1,108 @@
+/**
+ * @file sipe-xml-async.h
+ *
+ * pidgin-sipe
+ *
+ * Copyright (C) 2016 SIPE Project <http://sipe.sourceforge.net/>
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Asynchronous XML parsing
+ *
+ * Large documents are parsed by a worker thread so that the main loop
+ * isn't blocked. The callback is always called from the main thread and
+ * never before sipe_xml_parse_async() has returned. Results are delivered
+ * in the same order as the documents were submitted.
+ *
+ * Needs sipe-xml.h for sipe_xml.
+ */
+
+/* Forward declarations */
+struct sipe_core_private;
+
+/**
+ * Parse result callback
+ *
+ * @param sipe_private SIPE core private data
+ * @param xml          parsed document or @c NULL if parsing failed.
+ *                     Will be freed after the callback returns.
+ * @param data         callback data
+ */
+typedef void (sipe_xml_async_cb)(struct sipe_core_private *sipe_private,
+				 const sipe_xml *xml,
+				 gpointer data);
+
+/**
+ * Parse aborted callback
+ *
+ * Called instead of the result callback when the connection is cleaned
+ * up. Must only release the callback data, i.e. not start new requests.
+ *
+ * @param sipe_private SIPE core private data
+ * @param data         callback data
+ */
+typedef void (sipe_xml_async_aborted_cb)(struct sipe_core_private *sipe_private,
+					 gpointer data);
+
+/**
+ * Parse XML document asynchronously
+ *
+ * @param sipe_private SIPE core private data
+ * @param string       XML document (will be copied)
+ * @param length       length of the document
+ * @param callback     function to call with the result
+ * @param aborted      function to call on abort (may be @c NULL)
+ * @param data         callback data
+ */
+void sipe_xml_parse_async(struct sipe_core_private *sipe_private,
+			  const gchar *string,
+			  gsize length,
+			  sipe_xml_async_cb *callback,
+			  sipe_xml_async_aborted_cb *aborted,
+			  gpointer data);
+
+/**
+ * Drop pending parse requests for callback data. Callback will not be called.
+ *
+ * @param sipe_private SIPE core private data
+ * @param data         callback data
+ */
+void sipe_xml_parse_async_cancel(struct sipe_core_private *sipe_private,
+				 gpointer data);
+
+/**
+ * Abort all pending parse requests. Result callbacks will not be called,
+ * only the aborted callbacks.
+ *
+ * @param sipe_private SIPE core private data
+ */
+void sipe_xml_parse_async_abort_all(struct sipe_core_private *sipe_private);
+
+/**
+ * Stop worker threads
+ */
+void sipe_xml_async_shutdown(void);
+
+/*
+  Local Variables:
+  mode: c
+  c-file-style: "bsd"
+  indent-tabs-mode: t
+  tab-width: 8
+  End:
+*/
@@ -51,6 +51,7 @@ struct _sipe_xml {
 struct _parser_data {
 	sipe_xml *root;
 	sipe_xml *current;
+	GString *messages; /* non-NULL: collect instead of logging */
 	gboolean error;
 };
 
@@ -150,7 +151,12 @@ static void callback_error(void *user_data, const char *msg, ...)
 	errmsg = g_strdup_vprintf(msg, args);
 	va_end(args);
 
-	SIPE_DEBUG_ERROR("error parsing xml string: %s", errmsg);
+	if (pd->messages)
+		g_string_append_printf(pd->messages,
+				       "error parsing xml string: %s\n",
+				       errmsg);
+	else
+		SIPE_DEBUG_ERROR("error parsing xml string: %s", errmsg);
 	g_free(errmsg);
 }
 
@@ -158,8 +164,18 @@ static void callback_serror(void *user_data, xmlErrorPtr error)
 {
 	struct _parser_data *pd = user_data;
 
-	if (error && (error->level == XML_ERR_ERROR ||
-	              error->level == XML_ERR_FATAL)) {
+	if (pd->messages) {
+		if (error && (error->level == XML_ERR_ERROR ||
+			      error->level == XML_ERR_FATAL))
+			pd->error = TRUE;
+		g_string_append_printf(pd->messages,
+				       "XML parser error: Domain %i, code %i, level %i: %s\n",
+				       error ? error->domain : 0,
+				       error ? error->code : 0,
+				       error ? (int) error->level : 0,
+				       (error && error->message) ? error->message : "(null)");
+	} else if (error && (error->level == XML_ERR_ERROR ||
+			     error->level == XML_ERR_FATAL)) {
 		pd->error = TRUE;
 		SIPE_DEBUG_ERROR("XML parser error: Domain %i, code %i, level %i: %s",
 				 error->domain, error->code, error->level,
@@ -210,13 +226,15 @@ static xmlSAXHandler parser = {
 	callback_serror,        /* serror */
 };
 
-sipe_xml *sipe_xml_parse(const gchar *string, gsize length)
+static sipe_xml *xml_parse(const gchar *string, gsize length,
+			   GString *messages)
 {
 	sipe_xml *result = NULL;
 
 	if (string && length) {
 		struct _parser_data *pd = g_new0(struct _parser_data, 1);
 
+		pd->messages = messages;
 		if (xmlSAXUserParseMemory(&parser, pd, string, length))
 			pd->error = TRUE;
 
@@ -232,6 +250,33 @@ sipe_xml *sipe_xml_parse(const gchar *string, gsize length)
 	return result;
 }
 
+sipe_xml *sipe_xml_parse(const gchar *string, gsize length)
+{
+	return(xml_parse(string, length, NULL));
+}
+
+sipe_xml *sipe_xml_parse_thread(const gchar *string, gsize length,
+				gchar **messages)
+{
+	GString *collected = g_string_new("");
+	sipe_xml *result   = xml_parse(string, length, collected);
+
+	if (collected->len) {
+		*messages = g_string_free(collected, FALSE);
+	} else {
+		*messages = NULL;
+		g_string_free(collected, TRUE);
+	}
+
+	return(result);
+}
+
+void sipe_xml_thread_init(void)
+{
+	/* must be called before the parser is used from other threads */
+	xmlInitParser();
+}
+
 void sipe_xml_free(sipe_xml *node)
 {
 	sipe_xml *child;
@@ -32,6 +32,27 @@ typedef struct _sipe_xml sipe_xml;
  */
 sipe_xml *sipe_xml_parse(const gchar *string, gsize length);
 
+/**
+ * Parse XML from a string outside of the main thread.
+ *
+ * Same as @c sipe_xml_parse(), but doesn't call the backend debug API.
+ * Parser messages are returned to the caller instead.
+ *
+ * @param string   String with the XML to be parsed.
+ * @param length   Length of the string.
+ * @param messages Parser messages or @c NULL. Must be @c g_free()'d.
+ *
+ * @return Parsed XML information. Must be @c sipe_xml_free()'d.
+ */
+sipe_xml *sipe_xml_parse_thread(const gchar *string, gsize length,
+				gchar **messages);
+
+/**
+ * Prepare XML parser for use from other threads. Must be called in
+ * the main thread before the first @c sipe_xml_parse_thread().
+ */
+void sipe_xml_thread_init(void);
+
 /**
  * Free XML information.
  *
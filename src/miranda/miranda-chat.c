@@ -80,6 +80,14 @@ void sipe_backend_chat_add(struct sipe_backend_chat_session *backend_session,
 	mir_free(nick);
 }
 
+void sipe_backend_chat_add_users(struct sipe_backend_chat_session *backend_session,
+				 const GSList *uris,
+				 gboolean is_new)
+{
+	for (; uris; uris = uris->next)
+		sipe_backend_chat_add(backend_session, uris->data, is_new);
+}
+
 void sipe_backend_chat_close(struct sipe_backend_chat_session *backend_session)
 {
 	SIPPROTO *pr;
@@ -329,6 +337,13 @@ void sipe_backend_chat_remove(struct sipe_backend_chat_session *backend_session,
 	mir_free(nick);
 }
 
+void sipe_backend_chat_remove_users(struct sipe_backend_chat_session *backend_session,
+				    const GSList *uris)
+{
+	for (; uris; uris = uris->next)
+		sipe_backend_chat_remove(backend_session, uris->data);
+}
+
 void sipe_backend_chat_show(struct sipe_backend_chat_session *backend_session)
 {
 	_NIF();
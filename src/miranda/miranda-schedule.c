@@ -144,6 +144,19 @@ gpointer sipe_backend_schedule_mseconds(SIPE_UNUSED_PARAMETER struct sipe_core_p
 	return entry;
 }
 
+static void __stdcall
+wakeup_cb_async(void *data)
+{
+	/* core checks if the account still exists */
+	sipe_core_wakeup(data);
+}
+
+void sipe_backend_wakeup(gpointer data)
+{
+	/* queued to the main thread, also when called from it */
+	CallFunctionAsync(wakeup_cb_async, data);
+}
+
 gpointer sipe_backend_schedule_seconds(SIPE_UNUSED_PARAMETER struct sipe_core_public *sipe_public,
 				       guint timeout,
 				       gpointer data)
@@ -24,6 +24,7 @@
 
 #include <glib.h>
 
+#include "sipe-common.h"
 #include "sipe-core.h"
 #include "sipe-backend.h"
 
@@ -48,7 +49,8 @@ static const gchar * const setting_name[SIPE_SETTING_LAST] = {
 	"login",          /* SIPE_SETTING_EMAIL_LOGIN    */
 	"password",       /* SIPE_SETTING_EMAIL_PASSWORD */
 	"groupchat_user", /* SIPE_SETTING_GROUPCHAT_USER */
-	"useragent"       /* SIPE_SETTING_USER_AGENT     */
+	"useragent",      /* SIPE_SETTING_USER_AGENT     */
+	"ft_block_size"   /* SIPE_SETTING_FT_BLOCK_SIZE  */
 };
 
 const gchar *sipe_backend_setting(struct sipe_core_public *sipe_public,
@@ -74,6 +76,12 @@ const gchar *sipe_backend_setting(struct sipe_core_public *sipe_public,
 
 }
 
+const gchar *sipe_backend_cache_dir(SIPE_UNUSED_PARAMETER struct sipe_core_public *sipe_public)
+{
+	/* @TODO: no persistent cache support yet */
+	return NULL;
+}
+
 /*
   Local Variables:
   mode: c
@@ -42,8 +42,6 @@
 #define MIRANDA_TRANSPORT ((struct sipe_transport_miranda *) conn)
 #define SIPE_TRANSPORT_CONNECTION ((struct sipe_transport_connection *) transport)
 
-#define BUFFER_SIZE_INCREMENT 4096
-
 struct sipe_transport_miranda {
 	/* public part shared with core */
 	struct sipe_transport_connection public;
@@ -100,17 +98,8 @@ miranda_sipe_input_cb(gpointer data,
 	}
 
 	do {
-		/* Increase input buffer size as needed */
-		if (conn->buffer_length < conn->buffer_used + BUFFER_SIZE_INCREMENT) {
-			conn->buffer_length += BUFFER_SIZE_INCREMENT;
-			conn->buffer = g_realloc(conn->buffer, conn->buffer_length);
-			SIPE_DEBUG_INFO("miranda_sipe_input_cb: new buffer length %" G_GSIZE_FORMAT,
-					conn->buffer_length);
-		}
-
 		/* Try to read as much as there is space left in the buffer */
-		/* minus 1 for the string terminator */
-		readlen = conn->buffer_length - conn->buffer_used - 1;
+		readlen = sipe_core_transport_buffer_reserve(conn);
 
 		len = Netlib_Recv(transport->fd, conn->buffer + conn->buffer_used, readlen, MSG_NODUMP);
 
@@ -210,23 +199,37 @@ gchar *sipe_backend_transport_ip_address(struct sipe_transport_connection *conn)
 }
 
 void sipe_backend_transport_message(struct sipe_transport_connection *conn,
-				    const gchar *buffer)
+				    const struct sipe_transport_part *parts,
+				    guint count)
 {
 	struct sipe_transport_miranda *transport = MIRANDA_TRANSPORT;
-	guint written = 0;
+	GString *message = g_string_new("");
+	const gchar *buffer;
+	gsize length;
+	gsize written = 0;
+	guint i;
+
+	/* send message with as few Netlib_Send() calls as possible */
+	for (i = 0; i < count; i++)
+		g_string_append_len(message, parts[i].data, parts[i].length);
+	buffer = message->str;
+	length = message->len;
 
 	do {
-		int len = Netlib_Send(transport->fd, buffer + written, strlen(buffer + written), MSG_NODUMP);
+		int len = Netlib_Send(transport->fd, buffer + written, length - written, MSG_NODUMP);
 
 		if (len == SOCKET_ERROR) {
 			SIPE_DEBUG_INFO_NOFORMAT("sipe_backend_transport_message: error, exiting");
 			transport->error(SIPE_TRANSPORT_CONNECTION,
 					 "Write error");
+			g_string_free(message, TRUE);
 			return;
 		}
 
 		written += len;
-	} while (written < strlen(buffer));
+	} while (written < length);
+
+	g_string_free(message, TRUE);
 }
 
 void sipe_backend_transport_flush(struct sipe_transport_connection *conn)
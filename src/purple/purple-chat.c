@@ -49,9 +49,11 @@
 #else
 #include "blist.h"
 #define purple_chat_conversation_add_user(c, n, m, f, b) purple_conv_chat_add_user(c, n, m, f, b)
+#define purple_chat_conversation_add_users(c, u, m, f, b) purple_conv_chat_add_users(c, u, m, f, b)
 #define purple_chat_conversation_clear_users(c)          purple_conv_chat_clear_users(c)
 #define purple_chat_conversation_get_id(c)               purple_conv_chat_get_id(c)
 #define purple_chat_conversation_remove_user(c, n, s)    purple_conv_chat_remove_user(c, n, s)
+#define purple_chat_conversation_remove_users(c, u, s)   purple_conv_chat_remove_users(c, u, s)
 #define purple_chat_conversation_set_nick(c, n)          purple_conv_chat_set_nick(c, n)
 #define purple_chat_conversation_set_topic(c, n, s)      purple_conv_chat_set_topic(c, n, s)
 #define purple_chat_get_components(chat)                 chat->components
@@ -388,6 +390,31 @@ void sipe_backend_chat_add(struct sipe_backend_chat_session *backend_session,
 					  is_new);
 }
 
+void sipe_backend_chat_add_users(struct sipe_backend_chat_session *backend_session,
+				 const GSList *uris,
+				 gboolean is_new)
+{
+	GList *users = NULL;
+	GList *flags = NULL;
+
+	/* libpurple expects one flags entry per user */
+	for (; uris; uris = uris->next) {
+		users = g_list_prepend(users, uris->data);
+		flags = g_list_prepend(flags,
+				       GINT_TO_POINTER(PURPLE_CHAT_USER_NONE));
+	}
+	users = g_list_reverse(users);
+
+	purple_chat_conversation_add_users(BACKEND_SESSION_TO_PURPLE_CONV_CHAT(backend_session),
+					   users,
+					   NULL,
+					   flags,
+					   is_new);
+
+	g_list_free(flags);
+	g_list_free(users);
+}
+
 void sipe_backend_chat_close(struct sipe_backend_chat_session *backend_session)
 {
 	purple_chat_conversation_clear_users(BACKEND_SESSION_TO_PURPLE_CONV_CHAT(backend_session));
@@ -550,6 +577,22 @@ void sipe_backend_chat_remove(struct sipe_backend_chat_session *backend_session,
 						     NULL /* reason */);
 }
 
+void sipe_backend_chat_remove_users(struct sipe_backend_chat_session *backend_session,
+				    const GSList *uris)
+{
+	GList *users = NULL;
+
+	for (; uris; uris = uris->next)
+		users = g_list_prepend(users, uris->data);
+	users = g_list_reverse(users);
+
+	purple_chat_conversation_remove_users(BACKEND_SESSION_TO_PURPLE_CONV_CHAT(backend_session),
+					      users,
+					      NULL /* reason */);
+
+	g_list_free(users);
+}
+
 void sipe_backend_chat_show(struct sipe_backend_chat_session *backend_session)
 {
 	/* Bring existing purple chat to the front */
@@ -60,8 +60,14 @@ void sipe_mime_parts_foreach(const gchar *type,
 			     sipe_mime_parts_cb callback,
 			     gpointer user_data)
 {
-	gchar *doc = g_strdup_printf("Content-Type: %s\r\n\r\n%s", type, body);
-	PurpleMimeDocument *mime = purple_mime_document_parse(doc);
+	gchar *doc;
+	PurpleMimeDocument *mime;
+
+	if (sipe_mime_parts_foreach_simple(type, body, callback, user_data))
+		return;
+
+	doc = g_strdup_printf("Content-Type: %s\r\n\r\n%s", type, body);
+	mime = purple_mime_document_parse(doc);
 
 	if (mime) {
 		GList* parts = purple_mime_document_get_parts(mime);
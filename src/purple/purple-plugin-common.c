@@ -529,6 +529,7 @@ void sipe_purple_close(PurpleConnection *gc)
 		if (purple_private->deferred_status_timeout)
 			purple_timeout_remove(purple_private->deferred_status_timeout);
 		g_free(purple_private->deferred_status_note);
+		g_free(purple_private->cache_dir);
 
 		g_free(purple_private);
 		purple_connection_set_protocol_data(gc, NULL);
@@ -935,6 +936,12 @@ GList * sipe_purple_account_options()
 	option = purple_account_option_string_new(_("Group Chat Proxy\n   company.com  or  user@company.com\n(leave empty to determine from Username)"), "groupchat_user", "");
 	options = g_list_append(options, option);
 
+	/** Example: 65535 (maximum)
+	 *  Default is a small block size that is safe with ForeFront
+	 */
+	option = purple_account_option_string_new(_("File transfer block size\n(leave empty for default)"), "ft_block_size", "");
+	options = g_list_append(options, option);
+
 #ifdef HAVE_XDATA
 	option = purple_account_option_list_new(_("Remote desktop client"), "rdp-client", NULL);
 	purple_account_option_add_list_item(option, _("Remmina"), "remmina");
@@ -77,6 +77,7 @@ struct sipe_backend_private {
 	GList *rejoin_chats;
 	GSList *transports;
 	GSList *dns_queries;
+	gchar *cache_dir;
 
 	/* work around broken libpurple idle notification */
 	gchar *deferred_status_note;
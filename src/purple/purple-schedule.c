@@ -72,6 +72,18 @@ void sipe_backend_schedule_cancel(SIPE_UNUSED_PARAMETER struct sipe_core_public
 	purple_timeout_remove(schedule->timeout_handler);
 	g_free(schedule);
 }
+
+static gboolean purple_wakeup_execute(gpointer data)
+{
+	sipe_core_wakeup(data);
+	return(FALSE);
+}
+
+void sipe_backend_wakeup(gpointer data)
+{
+	/* purple_timeout_add() isn't thread-safe, the GLib default context is */
+	g_idle_add(purple_wakeup_execute, data);
+}
 	
 /*
   Local Variables:
@@ -24,6 +24,7 @@
 
 #include "account.h"
 #include "connection.h"
+#include "util.h"
 
 #include "sipe-backend.h"
 #include "sipe-core.h"
@@ -43,7 +44,8 @@ static const gchar * const setting_name[SIPE_SETTING_LAST] = {
 	"email_login",    /* SIPE_SETTING_EMAIL_LOGIN    */
 	"email_password", /* SIPE_SETTING_EMAIL_PASSWORD */
 	"groupchat_user", /* SIPE_SETTING_GROUPCHAT_USER */
-	"useragent"       /* SIPE_SETTING_USER_AGENT     */
+	"useragent",      /* SIPE_SETTING_USER_AGENT     */
+	"ft_block_size"   /* SIPE_SETTING_FT_BLOCK_SIZE  */
 };
 
 const gchar *sipe_backend_setting(struct sipe_core_public *sipe_public,
@@ -53,6 +55,33 @@ const gchar *sipe_backend_setting(struct sipe_core_public *sipe_public,
 					 setting_name[type], NULL));
 }
 
+const gchar *sipe_backend_cache_dir(struct sipe_core_public *sipe_public)
+{
+	struct sipe_backend_private *purple_private = sipe_public->backend_private;
+
+	if (!purple_private->cache_dir) {
+		gchar *account = g_strdup(purple_account_get_username(purple_private->account));
+		gchar *dir;
+
+		/* user name can contain characters that are invalid in a path */
+		g_strcanon(account,
+			   G_CSET_a_2_z G_CSET_A_2_Z G_CSET_DIGITS "@.-_",
+			   '_');
+		dir = g_build_filename(purple_user_dir(), "sipe", account, NULL);
+		g_free(account);
+
+		if (g_mkdir_with_parents(dir, 0700) == 0) {
+			purple_private->cache_dir = dir;
+		} else {
+			SIPE_DEBUG_ERROR("sipe_backend_cache_dir: can't create '%s'",
+					 dir);
+			g_free(dir);
+		}
+	}
+
+	return(purple_private->cache_dir);
+}
+
 /*
   Local Variables:
   mode: c
@@ -41,19 +41,6 @@
 #include "proxy.h"
 #include "sslconn.h"
 
-#include "version.h"
-#if PURPLE_VERSION_CHECK(3,0,0)
-#include "circularbuffer.h"
-#else
-#include "circbuffer.h"
-#define PurpleCircularBuffer PurpleCircBuffer
-#define purple_circular_buffer_append(b, s, n) purple_circ_buffer_append(b, s, n)
-#define purple_circular_buffer_get_max_read(b) purple_circ_buffer_get_max_read(b)
-#define purple_circular_buffer_get_output(b)   b->outptr
-#define purple_circular_buffer_mark_read(b, s) purple_circ_buffer_mark_read(b, s)
-#define purple_circular_buffer_new(s)          purple_circ_buffer_new(s)
-#endif
-
 #ifdef _WIN32
 /* wrappers for write() & friends for socket handling */
 #include "win32/win32dep.h"
@@ -79,7 +66,13 @@ struct sipe_transport_purple {
 	transport_error_cb *error;
 	PurpleSslConnection *gsc;
 	PurpleProxyConnectData *proxy;
-	PurpleCircularBuffer *transmit_buffer;
+	/*
+	 * Outgoing data is collected until the socket becomes writable,
+	 * i.e. all messages queued during one main loop iteration are
+	 * sent with one write.
+	 */
+	GByteArray *transmit_buffer;
+	gsize transmit_offset;    /* already written */
 	guint transmit_handler;
 	guint receive_handler;
 	int socket;
@@ -90,7 +83,6 @@ struct sipe_transport_purple {
 #define PURPLE_TRANSPORT ((struct sipe_transport_purple *) conn)
 #define SIPE_TRANSPORT_CONNECTION ((struct sipe_transport_connection *) transport)
 
-#define BUFFER_SIZE_INCREMENT 4096
 #define FLUSH_MAX_RETRIES 5
 
 
@@ -108,17 +100,8 @@ static void transport_common_input(struct sipe_transport_purple *transport)
 
 	/* Read all available data from the connection */
 	do {
-		/* Increase input buffer size as needed */
-		if (conn->buffer_length < conn->buffer_used + BUFFER_SIZE_INCREMENT) {
-			conn->buffer_length += BUFFER_SIZE_INCREMENT;
-			conn->buffer = g_realloc(conn->buffer, conn->buffer_length);
-			SIPE_DEBUG_INFO("transport_input_common: new buffer length %" G_GSIZE_FORMAT,
-					conn->buffer_length);
-		}
-
 		/* Try to read as much as there is space left in the buffer */
-		/* minus 1 for the string terminator */
-		readlen = conn->buffer_length - conn->buffer_used - 1;
+		readlen = sipe_core_transport_buffer_reserve(conn);
 		len = transport->gsc ?
 			(gssize) purple_ssl_read(transport->gsc,
 						 conn->buffer + conn->buffer_used,
@@ -251,7 +234,7 @@ sipe_backend_transport_connect(struct sipe_core_public *sipe_public,
 	transport->connected        = setup->connected;
 	transport->input            = setup->input;
 	transport->error            = setup->error;
-	transport->transmit_buffer  = purple_circular_buffer_new(0);
+	transport->transmit_buffer  = g_byte_array_new();
 	transport->is_valid         = TRUE;
 
 	purple_private->transports = g_slist_prepend(purple_private->transports,
@@ -341,11 +324,7 @@ void sipe_backend_transport_disconnect(struct sipe_transport_connection *conn)
 		purple_input_remove(transport->receive_handler);
 
 	if (transport->transmit_buffer)
-#if PURPLE_VERSION_CHECK(3,0,0)
-		g_object_unref(transport->transmit_buffer);
-#else
-		purple_circ_buffer_destroy(transport->transmit_buffer);
-#endif
+		g_byte_array_free(transport->transmit_buffer, TRUE);
 	g_free(transport->public.buffer);
 
 	/* defer deletion of transport data structure to idle callback */
@@ -397,16 +376,17 @@ void sipe_purple_transport_close_all(struct sipe_backend_private *purple_private
 /* returns a negative number on write error */
 static gssize transport_write(struct sipe_transport_purple *transport)
 {
-	gsize max_write;
+	GByteArray *buffer = transport->transmit_buffer;
+	gsize max_write    = buffer->len - transport->transmit_offset;
 
-	max_write = purple_circular_buffer_get_max_read(transport->transmit_buffer);
 	if (max_write > 0) {
+		const guint8 *output = buffer->data + transport->transmit_offset;
 		gssize written = transport->gsc ?
 			(gssize) purple_ssl_write(transport->gsc,
-						  purple_circular_buffer_get_output(transport->transmit_buffer),
+						  output,
 						  max_write) :
 			write(transport->socket,
-			      purple_circular_buffer_get_output(transport->transmit_buffer),
+			      output,
 			      max_write);
 
 		if (written <= 0) {
@@ -417,8 +397,13 @@ static gssize transport_write(struct sipe_transport_purple *transport)
 						 _("Write error"));
 			}
 		} else {
-			purple_circular_buffer_mark_read(transport->transmit_buffer,
-							 written);
+			transport->transmit_offset += written;
+
+			/* everything sent: reuse buffer */
+			if (transport->transmit_offset == buffer->len) {
+				g_byte_array_set_size(buffer, 0);
+				transport->transmit_offset = 0;
+			}
 		}
 
 		return written;
@@ -443,13 +428,24 @@ static void transport_canwrite_cb(gpointer data,
 }
 
 void sipe_backend_transport_message(struct sipe_transport_connection *conn,
-				    const gchar *buffer)
+				    const struct sipe_transport_part *parts,
+				    guint count)
 {
 	struct sipe_transport_purple *transport = PURPLE_TRANSPORT;
+	GByteArray *buffer = transport->transmit_buffer;
+	guint i;
+
+	/* drop data from partial writes before the buffer grows further */
+	if (transport->transmit_offset > buffer->len / 2) {
+		g_byte_array_remove_range(buffer, 0, transport->transmit_offset);
+		transport->transmit_offset = 0;
+	}
 
-	/* add packet to circular buffer */
-	purple_circular_buffer_append(transport->transmit_buffer,
-				      buffer, strlen(buffer));
+	/* add packet to transmit buffer */
+	for (i = 0; i < count; i++)
+		g_byte_array_append(buffer,
+				    (const guint8 *) parts[i].data,
+				    parts[i].length);
 
 	/* initiate transmission */
 	if (!transport->transmit_handler) {
@@ -481,9 +477,9 @@ void sipe_backend_transport_flush(struct sipe_transport_connection *conn)
 		/* We couldn't send the whole buffer. Transport is probably
 		 * broken. */
 		SIPE_DEBUG_INFO("sipe_backend_transport_flush: leaving "
-				"%" G_GSSIZE_FORMAT " unsent bytes in buffer.",
-				purple_circular_buffer_get_max_read(
-						transport->transmit_buffer));
+				"%" G_GSIZE_FORMAT " unsent bytes in buffer.",
+				(gsize) (transport->transmit_buffer->len -
+					 transport->transmit_offset));
 	}
 }
 
@@ -71,6 +71,21 @@ typedef struct _SipeContactList {
 	GHashTable *buddy_handles; /* key: TpHandle,   value: buddy */
 	GHashTable *groups;        /* key: group name, value: buddy */
 
+	/*
+	 * Changes are collected and signalled once per main loop iteration.
+	 * Otherwise the initial presence burst after login would cause one
+	 * D-Bus signal per contact.
+	 */
+	GHashTable *changed_presences; /* key: TpHandle */
+	GHashTable *changed_aliases;   /* key: TpHandle */
+	GHashTable *changed_info;      /* key: TpHandle */
+	guint changed_source;
+
+	/* statistics: changes recorded, idle wakeups, D-Bus signals */
+	guint changes_recorded;
+	guint changes_wakeups;
+	guint changes_signals;
+
 	gboolean initial_received;
 } SipeContactList;
 
@@ -144,6 +159,15 @@ static void sipe_contact_list_dispose(GObject *object)
 
 	SIPE_DEBUG_INFO_NOFORMAT("SipeContactList::dispose");
 
+	/* pending changes are no longer of interest */
+	if (self->changed_source) {
+		g_source_remove(self->changed_source);
+		self->changed_source = 0;
+	}
+	tp_clear_pointer(&self->changed_presences, g_hash_table_unref);
+	tp_clear_pointer(&self->changed_aliases, g_hash_table_unref);
+	tp_clear_pointer(&self->changed_info, g_hash_table_unref);
+
 	tp_clear_pointer(&self->contacts, tp_handle_set_destroy);
 	tp_clear_object(&self->connection);
 	/* NOTE: the order is important due to borrowing of keys! */
@@ -183,6 +207,11 @@ static void sipe_contact_list_init(SIPE_UNUSED_PARAMETER SipeContactList *self)
 	self->groups        = g_hash_table_new_full(g_str_hash, g_str_equal,
 						    g_free, NULL);
 
+	self->changed_presences = g_hash_table_new(g_direct_hash, g_direct_equal);
+	self->changed_aliases   = g_hash_table_new(g_direct_hash, g_direct_equal);
+	self->changed_info      = g_hash_table_new(g_direct_hash, g_direct_equal);
+	self->changed_source    = 0;
+
 	self->initial_received = FALSE;
 }
 
@@ -270,6 +299,110 @@ SipeContactList *sipe_telepathy_contact_list_new(TpBaseConnection *connection)
 			    NULL));
 }
 
+/*
+ * Contact List class - change notifications
+ */
+static GPtrArray *convert_contact_info(struct telepathy_buddy *buddy);
+static gboolean changes_emit(gpointer data)
+{
+	SipeContactList *self = data;
+	GObject *connection   = G_OBJECT(self->connection);
+	GHashTableIter iter;
+	gpointer contact;
+
+	self->changed_source = 0;
+	self->changes_wakeups++;
+
+	if (g_hash_table_size(self->changed_presences)) {
+		GHashTable *presences = g_hash_table_new_full(g_direct_hash,
+							      g_direct_equal,
+							      NULL,
+							      (GDestroyNotify) tp_presence_status_free);
+
+		g_hash_table_iter_init(&iter, self->changed_presences);
+		while (g_hash_table_iter_next(&iter, &contact, NULL)) {
+			struct telepathy_buddy *buddy = g_hash_table_lookup(self->buddy_handles,
+									    contact);
+			/* buddy might have been removed in the meantime */
+			if (buddy)
+				g_hash_table_insert(presences,
+						    contact,
+						    tp_presence_status_new(buddy->activity,
+									   NULL));
+		}
+		g_hash_table_remove_all(self->changed_presences);
+
+		SIPE_DEBUG_INFO("SipeContactList::changes_emit: %d presences",
+				g_hash_table_size(presences));
+		if (g_hash_table_size(presences)) {
+			tp_presence_mixin_emit_presence_update(connection,
+							       presences);
+			self->changes_signals++;
+		}
+		g_hash_table_unref(presences);
+	}
+
+	if (g_hash_table_size(self->changed_aliases)) {
+		GHashTable *aliases = g_hash_table_new(g_direct_hash,
+						       g_direct_equal);
+
+		g_hash_table_iter_init(&iter, self->changed_aliases);
+		while (g_hash_table_iter_next(&iter, &contact, NULL)) {
+			struct telepathy_buddy *buddy = g_hash_table_lookup(self->buddy_handles,
+									    contact);
+			if (buddy)
+				g_hash_table_insert(aliases,
+						    contact,
+						    buddy->info[SIPE_BUDDY_INFO_DISPLAY_NAME]);
+		}
+		g_hash_table_remove_all(self->changed_aliases);
+
+		SIPE_DEBUG_INFO("SipeContactList::changes_emit: %d aliases",
+				g_hash_table_size(aliases));
+		if (g_hash_table_size(aliases)) {
+			sipe_telepathy_connection_aliases_updated(self->connection,
+								  aliases);
+			self->changes_signals++;
+		}
+		g_hash_table_unref(aliases);
+	}
+
+	/* ContactInfoChanged is a per-contact signal */
+	g_hash_table_iter_init(&iter, self->changed_info);
+	while (g_hash_table_iter_next(&iter, &contact, NULL)) {
+		struct telepathy_buddy *buddy = g_hash_table_lookup(self->buddy_handles,
+								    contact);
+		GPtrArray *info               = convert_contact_info(buddy);
+
+		if (info) {
+			tp_svc_connection_interface_contact_info_emit_contact_info_changed(self->connection,
+											   buddy->handle,
+											   info);
+			g_boxed_free(TP_ARRAY_TYPE_CONTACT_INFO_FIELD_LIST, info);
+			self->changes_signals++;
+		}
+	}
+	g_hash_table_remove_all(self->changed_info);
+
+	/* without batching there would be one signal per recorded change */
+	SIPE_DEBUG_INFO("SipeContactList::changes_emit: totals %d changes, %d wakeups, %d signals",
+			self->changes_recorded,
+			self->changes_wakeups,
+			self->changes_signals);
+
+	return(FALSE);
+}
+
+static void changes_add(SipeContactList *self,
+			GHashTable *changed,
+			TpHandle contact)
+{
+	g_hash_table_insert(changed, GUINT_TO_POINTER(contact), NULL);
+	self->changes_recorded++;
+	if (!self->changed_source)
+		self->changed_source = g_idle_add(changes_emit, self);
+}
+
 /* get & set alias for a contact  */
 const gchar *sipe_telepathy_buddy_get_alias(SipeContactList *contact_list,
 					    TpHandle contact)
@@ -715,16 +848,14 @@ void sipe_backend_buddy_refresh_properties(struct sipe_core_public *sipe_public,
 					   const gchar *uri)
 {
 	struct sipe_backend_private *telepathy_private = sipe_public->backend_private;
-	struct telepathy_buddy *buddy                  = g_hash_table_lookup(telepathy_private->contact_list->buddies,
+	SipeContactList *contact_list                  = telepathy_private->contact_list;
+	struct telepathy_buddy *buddy                  = g_hash_table_lookup(contact_list->buddies,
 									     uri);
-	GPtrArray *info                                = convert_contact_info(buddy);
 
-	if (info) {
-		tp_svc_connection_interface_contact_info_emit_contact_info_changed(telepathy_private->connection,
-										   buddy->handle,
-										   info);
-		g_boxed_free(TP_ARRAY_TYPE_CONTACT_INFO_FIELD_LIST, info);
-	}
+	if (buddy)
+		changes_add(contact_list,
+			    contact_list->changed_info,
+			    buddy->handle);
 }
 
 guint sipe_backend_buddy_get_status(struct sipe_core_public *sipe_public,
@@ -753,9 +884,9 @@ void sipe_backend_buddy_set_alias(struct sipe_core_public *sipe_public,
 	if (contact_list->initial_received) {
 		SIPE_DEBUG_INFO("sipe_backend_buddy_set_alias: %s changed to '%s'",
 				buddy->uri, alias);
-		sipe_telepathy_connection_alias_updated(contact_list->connection,
-						        buddy->handle,
-							alias);
+		changes_add(contact_list,
+			    contact_list->changed_aliases,
+			    buddy->handle);
 	}
 }
 
@@ -878,7 +1009,6 @@ void sipe_backend_buddy_set_status(struct sipe_core_public *sipe_public,
 	SipeContactList *contact_list                  = telepathy_private->contact_list;
 	struct telepathy_buddy *buddy                  = g_hash_table_lookup(contact_list->buddies,
 									     uri);
-	TpPresenceStatus *status;
 
 	if (!buddy)
 		return;
@@ -886,11 +1016,10 @@ void sipe_backend_buddy_set_status(struct sipe_core_public *sipe_public,
 
 	SIPE_DEBUG_INFO("sipe_backend_buddy_set_status: %s to %d", uri, activity);
 
-	/* emit status update signal */
-	status = tp_presence_status_new(activity, NULL);
-	tp_presence_mixin_emit_one_presence_update(G_OBJECT(telepathy_private->connection),
-						   buddy->handle, status);
-	tp_presence_status_free(status);
+	/* status update signal is emitted with the next batch */
+	changes_add(contact_list,
+		    contact_list->changed_presences,
+		    buddy->handle);
 }
 
 gboolean sipe_backend_uses_photo(void)
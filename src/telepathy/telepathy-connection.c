@@ -774,26 +774,31 @@ TpBaseConnection *sipe_telepathy_connection_new(TpBaseProtocol *protocol,
 	return(TP_BASE_CONNECTION(conn));
 }
 
-void sipe_telepathy_connection_alias_updated(TpBaseConnection *connection,
-					     guint contact,
-					     const gchar *alias)
+/* one AliasesChanged signal for all contacts in the table */
+void sipe_telepathy_connection_aliases_updated(TpBaseConnection *connection,
+					       GHashTable *changed)
 {
-	GPtrArray *aliases = g_ptr_array_sized_new(1);
-	GValueArray *pair  = g_value_array_new(2);
-
-	g_value_array_append(pair, NULL);
-	g_value_array_append(pair, NULL);
-	g_value_init(pair->values + 0, G_TYPE_UINT);
-	g_value_init(pair->values + 1, G_TYPE_STRING);
-	g_value_set_uint(pair->values + 0, contact);
-	g_value_set_string(pair->values + 1, alias);
-	g_ptr_array_add(aliases, pair);
+	GPtrArray *aliases = g_ptr_array_new_with_free_func((GDestroyNotify) g_value_array_free);
+	GHashTableIter iter;
+	gpointer contact, alias;
+
+	g_hash_table_iter_init(&iter, changed);
+	while (g_hash_table_iter_next(&iter, &contact, &alias)) {
+		GValueArray *pair = g_value_array_new(2);
+
+		g_value_array_append(pair, NULL);
+		g_value_array_append(pair, NULL);
+		g_value_init(pair->values + 0, G_TYPE_UINT);
+		g_value_init(pair->values + 1, G_TYPE_STRING);
+		g_value_set_uint(pair->values + 0, GPOINTER_TO_UINT(contact));
+		g_value_set_string(pair->values + 1, alias);
+		g_ptr_array_add(aliases, pair);
+	}
 
 	tp_svc_connection_interface_aliasing_emit_aliases_changed(SIPE_CONNECTION(connection),
 								  aliases);
 
 	g_ptr_array_unref(aliases);
-	g_value_array_free(pair);
 }
 
 struct sipe_backend_private *sipe_telepathy_connection_private(GObject *object)
@@ -899,6 +904,10 @@ const gchar *sipe_backend_setting(struct sipe_core_public *sipe_public,
 	return(value);
 }
 
+const gchar *sipe_backend_cache_dir(struct sipe_core_public *sipe_public)
+{
+	return(sipe_public->backend_private->cache_dir);
+}
 
 /*
   Local Variables:
@@ -82,9 +82,8 @@ gpointer sipe_telepathy_contact_info_props(void);
 struct _TpBaseConnection *sipe_telepathy_connection_new(struct _TpBaseProtocol *protocol,
 							GHashTable *params,
 							GError **error);
-void sipe_telepathy_connection_alias_updated(struct _TpBaseConnection *connection,
-					     guint contact,
-					     const gchar *alias);
+void sipe_telepathy_connection_aliases_updated(struct _TpBaseConnection *connection,
+					       GHashTable *changed);
 struct sipe_backend_private *sipe_telepathy_connection_private(GObject *object);
 
 /* debugging */
@@ -52,6 +52,17 @@ void sipe_backend_schedule_cancel(SIPE_UNUSED_PARAMETER struct sipe_core_public
 	g_source_remove(GPOINTER_TO_UINT(data));
 }
 
+static gboolean wakeup_execute(gpointer data)
+{
+	sipe_core_wakeup(data);
+	return(FALSE);
+}
+
+void sipe_backend_wakeup(gpointer data)
+{
+	g_idle_add(wakeup_execute, data);
+}
+
 /*
   Local Variables:
   mode: c
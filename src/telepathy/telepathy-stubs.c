@@ -93,6 +93,9 @@ void sipe_backend_chat_session_destroy(SIPE_UNUSED_PARAMETER struct sipe_backend
 void sipe_backend_chat_add(SIPE_UNUSED_PARAMETER struct sipe_backend_chat_session *backend_session,
 			   SIPE_UNUSED_PARAMETER const gchar *uri,
 			   SIPE_UNUSED_PARAMETER gboolean is_new) {}
+void sipe_backend_chat_add_users(SIPE_UNUSED_PARAMETER struct sipe_backend_chat_session *backend_session,
+				 SIPE_UNUSED_PARAMETER const GSList *uris,
+				 SIPE_UNUSED_PARAMETER gboolean is_new) {}
 void sipe_backend_chat_close(SIPE_UNUSED_PARAMETER struct sipe_backend_chat_session *backend_session) {}
 struct sipe_backend_chat_session *sipe_backend_chat_create(SIPE_UNUSED_PARAMETER struct sipe_core_public *sipe_public,
 							   SIPE_UNUSED_PARAMETER struct sipe_chat_session *session,
@@ -116,6 +119,8 @@ void sipe_backend_chat_rejoin(SIPE_UNUSED_PARAMETER struct sipe_core_public *sip
 void sipe_backend_chat_rejoin_all(SIPE_UNUSED_PARAMETER struct sipe_core_public *sipe_public) {}
 void sipe_backend_chat_remove(SIPE_UNUSED_PARAMETER struct sipe_backend_chat_session *backend_session,
 			      SIPE_UNUSED_PARAMETER const gchar *uri) {}
+void sipe_backend_chat_remove_users(SIPE_UNUSED_PARAMETER struct sipe_backend_chat_session *backend_session,
+				    SIPE_UNUSED_PARAMETER const GSList *uris) {}
 void sipe_backend_chat_show(SIPE_UNUSED_PARAMETER struct sipe_backend_chat_session *backend_session) {}
 void sipe_backend_chat_topic(SIPE_UNUSED_PARAMETER struct sipe_backend_chat_session *backend_session,
 			     SIPE_UNUSED_PARAMETER const gchar *topic) {}
@@ -51,7 +51,9 @@ struct sipe_transport_telepathy {
 	GSocketConnection *socket;
 	GInputStream *istream;
 	GOutputStream *ostream;
-	GSList *buffers; /* != NULL -> write operation in progress */
+	GString *output;  /* queued data, written with the next write */
+	GString *writing; /* != NULL -> write operation in progress */
+	gsize written;
 	guint port;
 	gboolean do_flush;
 };
@@ -59,67 +61,53 @@ struct sipe_transport_telepathy {
 #define TELEPATHY_TRANSPORT ((struct sipe_transport_telepathy *) conn)
 #define SIPE_TRANSPORT_CONNECTION ((struct sipe_transport_connection *) transport)
 
-#define BUFFER_SIZE_INCREMENT 4096
-
 static void read_completed(GObject *stream,
 			   GAsyncResult *result,
 			   gpointer data)
 {
 	struct sipe_transport_telepathy *transport = data;
 	struct sipe_transport_connection *conn = SIPE_TRANSPORT_CONNECTION;
+	gsize readlen;
 
-	do {
-		if (conn->buffer_length < conn->buffer_used + BUFFER_SIZE_INCREMENT) {
-			conn->buffer_length += BUFFER_SIZE_INCREMENT;
-			conn->buffer = g_realloc(conn->buffer, conn->buffer_length);
-			SIPE_DEBUG_INFO("read_completed: new buffer length %" G_GSIZE_FORMAT,
-					conn->buffer_length);
-		}
-
-		/* callback result is valid */
-		if (result) {
-			GError *error = NULL;
-			gssize len    = g_input_stream_read_finish(G_INPUT_STREAM(stream),
-								   result,
-								   &error);
-
-			if (len < 0) {
-				const gchar *msg = error ? error->message : "UNKNOWN";
-				SIPE_DEBUG_ERROR("read_completed: error: %s", msg);
-				if (transport->error)
-					transport->error(conn, msg);
-				g_error_free(error);
-				return;
-			} else if (len == 0) {
-				SIPE_DEBUG_ERROR_NOFORMAT("read_completed: server has disconnected");
-				transport->error(conn, _("Server has disconnected"));
-				return;
-			} else if (transport->do_flush) {
-				/* read completed while disconnected transport is flushing */
-				SIPE_DEBUG_INFO_NOFORMAT("read_completed: ignored during flushing");
-				return;
-			} else if (g_cancellable_is_cancelled(transport->cancel)) {
-				/* read completed when transport was disconnected */
-				SIPE_DEBUG_INFO_NOFORMAT("read_completed: cancelled");
-				return;
-			}
-
-			/* Forward data to core */
-			conn->buffer_used               += len;
-			conn->buffer[conn->buffer_used]  = '\0';
-			transport->input(conn);
+	/* callback result is valid */
+	if (result) {
+		GError *error = NULL;
+		gssize len    = g_input_stream_read_finish(G_INPUT_STREAM(stream),
+							   result,
+							   &error);
 
-			/* we processed the result */
-			result = NULL;
+		if (len < 0) {
+			const gchar *msg = error ? error->message : "UNKNOWN";
+			SIPE_DEBUG_ERROR("read_completed: error: %s", msg);
+			if (transport->error)
+				transport->error(conn, msg);
+			g_error_free(error);
+			return;
+		} else if (len == 0) {
+			SIPE_DEBUG_ERROR_NOFORMAT("read_completed: server has disconnected");
+			transport->error(conn, _("Server has disconnected"));
+			return;
+		} else if (transport->do_flush) {
+			/* read completed while disconnected transport is flushing */
+			SIPE_DEBUG_INFO_NOFORMAT("read_completed: ignored during flushing");
+			return;
+		} else if (g_cancellable_is_cancelled(transport->cancel)) {
+			/* read completed when transport was disconnected */
+			SIPE_DEBUG_INFO_NOFORMAT("read_completed: cancelled");
+			return;
 		}
 
-		/* buffer too short? */
-	} while (conn->buffer_length - conn->buffer_used - 1 == 0);
+		/* Forward data to core */
+		conn->buffer_used               += len;
+		conn->buffer[conn->buffer_used]  = '\0';
+		transport->input(conn);
+	}
 
 	/* setup next read */
+	readlen = sipe_core_transport_buffer_reserve(conn);
 	g_input_stream_read_async(G_INPUT_STREAM(stream),
 				  conn->buffer + conn->buffer_used,
-				  conn->buffer_length - conn->buffer_used - 1,
+				  readlen,
 				  G_PRIORITY_DEFAULT,
 				  transport->cancel,
 				  read_completed,
@@ -291,7 +279,8 @@ struct sipe_transport_connection *sipe_backend_transport_connect(struct sipe_cor
 	transport->tls_info         = NULL;
 	transport->private          = sipe_public->backend_private;
 	transport->cancel           = g_cancellable_new();
-	transport->buffers          = NULL;
+	transport->output           = g_string_new("");
+	transport->writing          = NULL;
 	transport->port             = setup->server_port;
 	transport->do_flush         = FALSE;
 
@@ -312,7 +301,6 @@ struct sipe_transport_connection *sipe_backend_transport_connect(struct sipe_cor
 static gboolean free_transport(gpointer data)
 {
 	struct sipe_transport_telepathy *transport = data;
-	GSList *entry;
 
 	SIPE_DEBUG_INFO("free_transport %p", transport);
 
@@ -321,9 +309,9 @@ static gboolean free_transport(gpointer data)
 	g_free(transport->hostname);
 
 	/* free unflushed buffers */
-	for (entry = transport->buffers; entry; entry = entry->next)
-		g_free(entry->data);
-	g_slist_free(transport->buffers);
+	g_string_free(transport->output, TRUE);
+	if (transport->writing)
+		g_string_free(transport->writing, TRUE);
 
 	if (transport->cancel)
 		g_object_unref(transport->cancel);
@@ -376,7 +364,7 @@ void sipe_backend_transport_disconnect(struct sipe_transport_connection *conn)
 	if (transport->socket) {
 
 		/* flush required? */
-		if (transport->do_flush && transport->buffers)
+		if (transport->do_flush && transport->writing)
 			SIPE_DEBUG_INFO("sipe_backend_transport_disconnect: %p needs flushing",
 					transport);
 		else
@@ -421,17 +409,11 @@ static void write_completed(GObject *stream,
 			    gpointer data)
 {
 	struct sipe_transport_telepathy *transport = data;
-	gchar                           *buffer;
 	GError                          *error     = NULL;
 	gssize written = g_output_stream_write_finish(G_OUTPUT_STREAM(stream),
 						      result,
 						      &error);
 
-	/* free the buffer that has just been written. */
-	buffer = transport->buffers->data;
-	transport->buffers = g_slist_remove(transport->buffers, buffer);
-	g_free(buffer);
-
 	if ((written < 0) || error) {
 		const gchar *msg = error ? error->message : "UNKNOWN";
 		SIPE_DEBUG_ERROR("write_completed: error: %s", msg);
@@ -447,8 +429,16 @@ static void write_completed(GObject *stream,
 		/* write completed when transport was disconnected */
 		SIPE_DEBUG_INFO_NOFORMAT("write_completed: cancelled");
 	} else {
+		transport->written += written;
+
+		/* buffer completely written? */
+		if (transport->written == transport->writing->len) {
+			g_string_free(transport->writing, TRUE);
+			transport->writing = NULL;
+		}
+
 		/* more to write? */
-		if (transport->buffers) {
+		if (transport->writing || transport->output->len) {
 			do_write(transport);
 		/* flush completed? */
 		} else if (transport->do_flush) {
@@ -459,9 +449,16 @@ static void write_completed(GObject *stream,
 
 static void do_write(struct sipe_transport_telepathy *transport)
 {
+	/* send everything that was queued during the last write in one go */
+	if (!transport->writing) {
+		transport->writing = transport->output;
+		transport->written = 0;
+		transport->output  = g_string_new("");
+	}
+
 	g_output_stream_write_async(transport->ostream,
-				    transport->buffers->data,
-				    strlen(transport->buffers->data),
+				    transport->writing->str + transport->written,
+				    transport->writing->len - transport->written,
 				    G_PRIORITY_DEFAULT,
 				    transport->cancel,
 				    write_completed,
@@ -469,14 +466,18 @@ static void do_write(struct sipe_transport_telepathy *transport)
 }
 
 void sipe_backend_transport_message(struct sipe_transport_connection *conn,
-				    const gchar *buffer)
+				    const struct sipe_transport_part *parts,
+				    guint count)
 {
 	struct sipe_transport_telepathy *transport = TELEPATHY_TRANSPORT;
-	gboolean can_write = (transport->buffers == NULL);
+	guint i;
 
-	transport->buffers = g_slist_append(transport->buffers, g_strdup(buffer));
+	for (i = 0; i < count; i++)
+		g_string_append_len(transport->output,
+				    parts[i].data,
+				    parts[i].length);
 
-	if (can_write)
+	if (!transport->writing)
 		do_write(transport);
 }
 